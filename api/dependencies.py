@@ -10,6 +10,7 @@ from typing import Optional
 from db.database import get_async_session
 from db.models import User
 from services.auth_service import decode_access_token
+from services.loaders import Loaders
 
 security = HTTPBearer()
 security_optional = HTTPBearer(auto_error=False)
@@ -103,3 +104,8 @@ async def get_admin_user(
         raise redirect_exception
     except (ValueError, TypeError):
         raise redirect_exception
+
+
+async def get_loaders(db: AsyncSession = Depends(get_async_session)) -> Loaders:
+    """Request-scoped batch loaders sharing the request's session (services/loaders.py)."""
+    return Loaders(db)
@@ -7,9 +7,10 @@ from sqlalchemy.orm import selectinload
 from typing import Optional
 from datetime import datetime, timezone
 
-from db.database import get_async_session
+from db.database import get_async_session, get_read_session
 from db.models import User, CheckIn, Bounce, BounceInvite, BounceAttendee, Follow, Place, CheckInHistory
 from api.dependencies import get_admin_user
+from services import bounce_index
 from services.auth_service import create_access_token
 from services.redis import get_redis
 from core.config import settings
@@ -89,7 +90,7 @@ async def admin_logout():
 @router.get("/", response_class=HTMLResponse)
 async def admin_dashboard(
     request: Request,
-    db: AsyncSession = Depends(get_async_session),
+    db: AsyncSession = Depends(get_read_session),
     admin: User = Depends(get_admin_user)
 ):
     """Admin dashboard with stats overview."""
@@ -138,6 +139,8 @@ async def admin_dashboard(
 # USERS
 # ============================================================================
 
+# List pages that a delete redirects back to read the primary, so the row
+# just removed never reappears from a lagging replica
 @router.get("/users", response_class=HTMLResponse)
 async def admin_users_list(
     request: Request,
@@ -445,6 +448,8 @@ async def admin_bounce_update(
     bounce.is_now = is_now
 
     await db.commit()
+    await bounce_index.index_bounce(bounce)
+    await bounce_index.invalidate_bounce(bounce_id)
 
     return RedirectResponse(url=f"/admin/bounces/{bounce_id}", status_code=302)
 
@@ -464,6 +469,8 @@ async def admin_bounce_delete(
 
     await db.delete(bounce)
     await db.commit()
+    await bounce_index.unindex_bounce(bounce_id)
+    await bounce_index.invalidate_bounce(bounce_id)
 
     return RedirectResponse(url="/admin/bounces", status_code=302)
 
@@ -477,7 +484,7 @@ async def admin_places_list(
     request: Request,
     page: int = 1,
     search: str = "",
-    db: AsyncSession = Depends(get_async_session),
+    db: AsyncSession = Depends(get_read_session),
     admin: User = Depends(get_admin_user)
 ):
     """List all places with pagination."""
@@ -585,7 +592,7 @@ async def admin_follow_delete(
 
 @router.get("/api/users/locations")
 async def admin_users_locations(
-    db: AsyncSession = Depends(get_async_session),
+    db: AsyncSession = Depends(get_read_session),
     admin: User = Depends(get_admin_user)
 ):
     """JSON endpoint: all users with a known location, online status, and venue if checked in."""
@@ -612,18 +619,22 @@ async def admin_users_locations(
     keys = [f"user:alive:{uid}" for uid in user_ids]
     alive_values = await r.mget(keys)
     alive_set = {uid for uid, val in zip(user_ids, alive_values) if val}
+    # Buffered positions not yet flushed to the users table
+    from services.location_store import get_positions
+    buffered = await get_positions(user_ids)
 
     out = []
     for u in users:
         ci = active_checkins.get(u.id)
+        lat, lon, seen = buffered.get(u.id) or (u.last_location_lat, u.last_location_lon, u.last_location_update)
         out.append({
             "id": u.id,
             "nickname": u.nickname,
             "profile_pic": u.profile_picture or u.instagram_profile_pic,
-            "latitude": u.last_location_lat,
-            "longitude": u.last_location_lon,
+            "latitude": lat,
+            "longitude": lon,
             "is_online": u.id in alive_set,
-            "last_seen": u.last_location_update.isoformat() if u.last_location_update else None,
+            "last_seen": seen.isoformat() if seen else None,
             "venue_name": ci.location_name if ci else None,
             "place_id": ci.place_id if ci else None,
         })
@@ -631,6 +642,42 @@ async def admin_users_locations(
     return out
 
 
+@router.get("/api/ws/stats")
+async def admin_ws_stats(admin: User = Depends(get_admin_user)):
+    """This instance's WebSocket connection counts and per-channel fan-out
+    counters (deliveries, drops, slow-consumer disconnects, latency)."""
+    from api.routes.websocket import manager
+    return manager.stats()
+
+
+@router.get("/api/cache/stats")
+async def admin_cache_stats(admin: User = Depends(get_admin_user)):
+    """This instance's cache hit counts per key namespace (L1 / Redis / miss)."""
+    from services.cache import cache_stats
+    return cache_stats()
+
+
+@router.get("/api/events/stats")
+async def admin_event_stats(admin: User = Depends(get_admin_user)):
+    """This instance's place-event buffer: queued / written / coalesced / dropped."""
+    from services.recommendations import event_log_stats
+    return event_log_stats()
+
+
+@router.get("/api/autocomplete/stats")
+async def admin_autocomplete_stats(admin: User = Depends(get_admin_user)):
+    """This instance's autocomplete sources (local index / Redis) and Google fallback rate."""
+    from services.places.autocomplete import autocomplete_stats
+    return autocomplete_stats()
+
+
+@router.get("/api/llm/stats")
+async def admin_llm_stats(admin: User = Depends(get_admin_user)):
+    """This instance's LLM queue plus per-caller calls, latency, tokens and estimated cost."""
+    from services.llm import llm_stats
+    return llm_stats()
+
+
 @router.get("/users/map", response_class=HTMLResponse)
 async def admin_users_map(
     request: Request,
@@ -22,12 +22,7 @@ from api.routes.bounces import get_bounce_participants, get_venue_photo_url
 from core.config import settings
 from services.auth_service import decode_access_token
 from services.ai_commentator import get_or_create_commentator, remove_commentator
-from services.live_room import (
-    ReactionThrottle,
-    register_viewer,
-    unregister_viewer,
-    viewer_refresh_loop,
-)
+from services.live_room import ReactionThrottle, presence
 
 router = APIRouter(tags=["bounce-share"])
 logger = logging.getLogger(__name__)
@@ -423,7 +418,6 @@ async def bounce_guest_websocket(
     is_app_user = False
     app_user_id: Optional[int] = None
     conn_id = uuid4().hex
-    refresh_task: Optional[asyncio.Task] = None
     throttle = ReactionThrottle()
 
     def _viewer_key(bid: int) -> str:
@@ -504,27 +498,28 @@ async def bounce_guest_websocket(
 
                 # Send push notification to app participants
                 from services.apns_service import NotificationPayload, NotificationType
-                from services.tasks import enqueue_notification, payload_to_dict
-                for pid in participants:
-                    payload = NotificationPayload(
-                        notification_type=NotificationType.GUEST_JOINED,
-                        title="Guest Joined",
-                        body=f"{name} joined the bounce at {bounce.venue_name}",
-                        actor_id=0,
-                        actor_nickname=name,
-                        bounce_id=bounce.id,
-                        bounce_venue_name=bounce.venue_name,
-                        bounce_place_id=bounce.place_id
-                    )
-                    enqueue_notification(pid, payload_to_dict(payload))
+                from services.tasks import enqueue_notifications_bulk, payload_to_dict
+                payload = NotificationPayload(
+                    notification_type=NotificationType.GUEST_JOINED,
+                    title="Guest Joined",
+                    body=f"{name} joined the bounce at {bounce.venue_name}",
+                    actor_id=0,
+                    actor_nickname=name,
+                    bounce_id=bounce.id,
+                    bounce_venue_name=bounce.venue_name,
+                    bounce_place_id=bounce.place_id
+                )
+                enqueue_notifications_bulk(list(participants), payload_to_dict(payload))
 
-        # Register viewer presence (Redis ZSET, accurate across instances)
-        viewer_count = None
-        try:
-            viewer_count = await register_viewer(_viewer_key(bounce_id), conn_id)
-        except Exception as e:
-            logger.warning(f"Viewer register failed for bounce {bounce_id}: {e}")
-        refresh_task = asyncio.create_task(viewer_refresh_loop(_viewer_key(bounce_id), conn_id))
+        # Register viewer presence (Redis ZSET, accurate across instances;
+        # batched per worker, the count is broadcast on the next tick)
+        async def _broadcast_viewer_count(count: int, bid: int = bounce_id):
+            await manager.send_to_bounce(bid, {
+                "type": "viewer_count",
+                "bounce_id": bid,
+                "count": count,
+            })
+        viewer_count = presence.join(_viewer_key(bounce_id), conn_id, _broadcast_viewer_count)
 
         # Send initial state
         initial_state = await _build_initial_state(db, bounce_id)
@@ -533,13 +528,6 @@ async def bounce_guest_websocket(
         logger.info(f"Sending initial_state to '{name}': {len(initial_state.get('app_users', []))} app users, {len(initial_state.get('guests', []))} guests")
         await websocket.send_json(initial_state)
 
-        if viewer_count is not None:
-            await manager.send_to_bounce(bounce_id, {
-                "type": "viewer_count",
-                "bounce_id": bounce_id,
-                "count": viewer_count,
-            })
-
         # Fetch creator name for commentator context
         creator_result = await db.execute(
             select(User).where(User.id == bounce.creator_id)
@@ -730,18 +718,8 @@ async def bounce_guest_websocket(
     except Exception as e:
         logger.error(f"Guest WS error for bounce: {e}")
     finally:
-        if refresh_task is not None:
-            refresh_task.cancel()
         if bounce_id is not None:
-            try:
-                count = await unregister_viewer(_viewer_key(bounce_id), conn_id)
-                await manager.send_to_bounce(bounce_id, {
-                    "type": "viewer_count",
-                    "bounce_id": bounce_id,
-                    "count": count,
-                })
-            except Exception as e:
-                logger.warning(f"Viewer unregister failed for bounce {bounce_id}: {e}")
+            presence.leave(_viewer_key(bounce_id), conn_id)
 
             # App users don't have guest records — skip guest cleanup
             if not is_app_user:
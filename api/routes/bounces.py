@@ -9,12 +9,14 @@ import logging
 from db.database import get_async_session
 from db.models import Bounce, BounceInvite, BounceAttendee, BounceLocationShare, BounceGuestLocation, User, Place, GooglePic
 from api.dependencies import get_current_user
+from services import bounce_index
 from services.geofence import haversine_distance
 from services.places import get_place_with_photos
 from api.routes.websocket import manager
 from services.apns_service import NotificationPayload, NotificationType
 from services.cache import cache_get, cache_set, cache_delete
-from services.tasks import enqueue_notification, payload_to_dict
+from services.tasks import enqueue_notifications_bulk, payload_to_dict
+from services.recommendations import W_BOUNCE_ATTENDED, record_interaction
 
 router = APIRouter(prefix="/bounces", tags=["bounces"])
 logger = logging.getLogger(__name__)
@@ -43,7 +45,6 @@ async def get_venue_photos_batch(db: AsyncSession, places_fk_ids: List[int]) ->
     if not places_fk_ids:
         return {}
     # Get first photo for each place using DISTINCT ON
-    from sqlalchemy import distinct
     result = await db.execute(
         select(GooglePic.place_id, GooglePic.photo_url)
         .where(GooglePic.place_id.in_(places_fk_ids))
@@ -99,6 +100,52 @@ async def get_active_attendees(
         return count, []
 
 
+async def get_active_attendees_batch(db: AsyncSession, bounce_ids: List[int]) -> dict:
+    """Active attendees for several bounces in one query. Returns {bounce_id: [AttendeeInfo]}."""
+    if not bounce_ids:
+        return {}
+    expiry_time = datetime.now(timezone.utc) - timedelta(minutes=ATTENDEE_EXPIRY_MINUTES)
+    result = await db.execute(
+        select(BounceAttendee, User)
+        .join(User, BounceAttendee.user_id == User.id)
+        .where(
+            BounceAttendee.bounce_id.in_(bounce_ids),
+            BounceAttendee.last_seen_at >= expiry_time
+        )
+        .order_by(BounceAttendee.joined_at.asc())
+    )
+    attendees: dict = {}
+    for att, user in result.all():
+        attendees.setdefault(att.bounce_id, []).append(AttendeeInfo(
+            user_id=att.user_id,
+            nickname=user.nickname,
+            profile_picture=user.profile_picture or user.instagram_profile_pic,
+            joined_at=att.joined_at
+        ))
+    return attendees
+
+
+def _bounding_box(lat: float, lng: float, radius_km: float):
+    """Coarse lat/lng box around a point (SQL fallback when the geo index is down)."""
+    import math
+    dlat = radius_km / 111.0
+    dlng = radius_km / max(111.0 * math.cos(math.radians(lat)), 0.001)
+    return and_(
+        Bounce.latitude.between(lat - dlat, lat + dlat),
+        Bounce.longitude.between(lng - dlng, lng + dlng),
+    )
+
+
+async def _public_filter(db: AsyncSession, lat: float, lng: float, radius_km: float):
+    """WHERE clause for active public bounces near a point: the geo index's
+    ids, or a bounding box when it is unavailable. Callers still apply the
+    exact haversine check."""
+    public_ids = await bounce_index.public_within(db, lat, lng, radius_km)
+    if public_ids is None:
+        return and_(Bounce.is_public == True, _bounding_box(lat, lng, radius_km))
+    return Bounce.id.in_(public_ids)
+
+
 # Request/Response Schemas
 class BounceCreate(BaseModel):
     venue_name: str
@@ -234,9 +281,12 @@ async def create_bounce(
                     invite = BounceInvite(bounce_id=bounce.id, user_id=user_id)
                     db.add(invite)
                     invite_count += 1
+        bounce.invite_count = invite_count
 
         await db.commit()
         await db.refresh(bounce)
+        await bounce_index.index_bounce(bounce)
+        await bounce_index.invalidate_visible([current_user.id] + (bounce_data.invite_user_ids or []))
 
         logger.info(
             "Bounce created",
@@ -263,41 +313,34 @@ async def create_bounce(
             "invited_user_ids": invited_ids
         }
 
-        # If public, broadcast to everyone; otherwise only to invited users
+        # If public, send to everyone around the venue; otherwise only to invited users
         if bounce.is_public:
-            await manager.broadcast(ws_message)
+            await manager.publish_geo(bounce.latitude, bounce.longitude, ws_message)
         else:
             # Send to creator and invited users only
-            for user_id in [current_user.id] + invited_ids:
-                if user_id in manager.active_connections:
-                    for conn in manager.active_connections[user_id]:
-                        try:
-                            await conn.send_json(ws_message)
-                        except Exception:
-                            pass
+            manager.send_to_users_local([current_user.id] + invited_ids, ws_message)
 
         # Send notifications to invited users
         from services.tasks import send_websocket_notification
 
+        payload = NotificationPayload(
+            notification_type=NotificationType.BOUNCE_INVITE,
+            title="Bounce Invite",
+            body=f"{current_user.nickname or current_user.first_name} invited you to bounce at {bounce.venue_name}",
+            actor_id=current_user.id,
+            actor_nickname=current_user.nickname or current_user.first_name or "Someone",
+            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+            bounce_id=bounce.id,
+            bounce_venue_name=bounce.venue_name,
+            bounce_place_id=bounce.place_id
+        )
+        payload_dict = payload_to_dict(payload)
         for user_id in invited_ids:
-            payload = NotificationPayload(
-                notification_type=NotificationType.BOUNCE_INVITE,
-                title="Bounce Invite",
-                body=f"{current_user.nickname or current_user.first_name} invited you to bounce at {bounce.venue_name}",
-                actor_id=current_user.id,
-                actor_nickname=current_user.nickname or current_user.first_name or "Someone",
-                actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-                bounce_id=bounce.id,
-                bounce_venue_name=bounce.venue_name,
-                bounce_place_id=bounce.place_id
-            )
-            payload_dict = payload_to_dict(payload)
-
             # Send WebSocket notification for in-app display (immediate)
             await send_websocket_notification(user_id, payload_dict)
 
-            # Queue push notification (background)
-            enqueue_notification(user_id, payload_dict)
+        # Queue push notifications (background, one batch)
+        enqueue_notifications_bulk(invited_ids, payload_dict)
 
         return bounce_response
 
@@ -318,14 +361,6 @@ async def get_bounces(
 ):
     """Get bounces: ones I created + ones I'm invited to + public ones"""
 
-    # Subquery for invite count
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
     # Build query - bounces I created, I'm invited to, or are public
     invited_bounce_ids = (
         select(BounceInvite.bounce_id)
@@ -333,7 +368,7 @@ async def get_bounces(
     )
 
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
         .where(
             or_(
@@ -382,75 +417,53 @@ async def get_map_bounces(
     - All bounces user is invited to (regardless of distance)
     - All bounces user created (regardless of distance)
 
+    Public candidates come from the bounce geo index and the personal ones from
+    the cached visibility set (services/bounce_index.py), so the row load is a
+    primary-key lookup however many bounces are active elsewhere.
+
     Args:
         lat: User's latitude
         lng: User's longitude
         radius: Search radius in km for public bounces (default 50km)
     """
-    now = datetime.now(timezone.utc)
-
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
-    # Get IDs of bounces user is invited to
-    invited_bounce_ids = (
-        select(BounceInvite.bounce_id)
-        .where(BounceInvite.user_id == current_user.id)
-    )
+    personal_ids = await bounce_index.visible_ids(db, current_user.id)
+    visibility = [await _public_filter(db, lat, lng, radius)]
+    if personal_ids:
+        visibility.append(Bounce.id.in_(personal_ids))
 
-    # Get all active bounces that are:
-    # - public, OR
-    # - user is invited to, OR
-    # - user created
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
         .where(Bounce.status == 'active')
-        .where(
-            or_(
-                Bounce.is_public == True,
-                Bounce.id.in_(invited_bounce_ids),
-                Bounce.creator_id == current_user.id
-            )
-        )
+        .where(or_(*visibility))
         .order_by(Bounce.bounce_time.asc())
     )
 
     result = await db.execute(stmt)
     rows = result.all()
 
-    # Batch fetch venue photos
+    # Batch fetch venue photos and live attendees (public "now" bounces)
     places_fk_ids = [bounce.places_fk_id for bounce, _, _ in rows if bounce.places_fk_id]
     venue_photos = await get_venue_photos_batch(db, places_fk_ids)
+    attendees_by_bounce = await get_active_attendees_batch(
+        db, [bounce.id for bounce, _, _ in rows if bounce.is_public and bounce.is_now]
+    )
 
     # Filter: public bounces must be within radius, private ones always included
     visible_bounces = []
-    seen_ids = set()
-
     for bounce, user, invite_count in rows:
-        if bounce.id in seen_ids:
-            continue
-        seen_ids.add(bounce.id)
-
-        # Check if this bounce should be visible
         is_mine = bounce.creator_id == current_user.id
-        is_invited = not bounce.is_public and not is_mine  # If we got it and it's not public/mine, we're invited
-
         if bounce.is_public and not is_mine:
-            # Public bounce - check distance
+            # Exact check (the index / fallback box is a superset near the edge)
             distance = haversine_distance(lat, lng, bounce.latitude, bounce.longitude)
             if distance > radius:
                 continue
 
-        # Get attendee info for public "now" bounces
         attendee_count = 0
         attendees = None
         if bounce.is_public and bounce.is_now:
-            attendee_count, attendees = await get_active_attendees(db, bounce.id, include_details=True)
+            attendees = attendees_by_bounce.get(bounce.id, [])
+            attendee_count = len(attendees)
 
         visible_bounces.append(
             build_bounce_response(
@@ -470,15 +483,8 @@ async def get_my_bounces(
     db: AsyncSession = Depends(get_async_session)
 ):
     """Get bounces created by the current user"""
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
         .where(Bounce.creator_id == current_user.id)
         .order_by(desc(Bounce.bounce_time))
@@ -506,16 +512,9 @@ async def get_invited_bounces(
     db: AsyncSession = Depends(get_async_session)
 ):
     """Get bounces the current user is invited to"""
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
     # Get bounces where user is invited (exclude declined invites)
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
         .join(BounceInvite, Bounce.id == BounceInvite.bounce_id)
         .where(BounceInvite.user_id == current_user.id)
@@ -550,13 +549,6 @@ async def get_shared_bounces(
     Get bounces shared between current user and another user.
     Returns bounces where both users are either creator or invited.
     """
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
     # Subquery for bounces where current user is involved
     my_bounces = (
         select(Bounce.id)
@@ -589,7 +581,7 @@ async def get_shared_bounces(
 
     # Get bounces that are in both sets
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
         .where(
             Bounce.id.in_(my_bounces),
@@ -633,17 +625,11 @@ async def get_public_bounces(
     """
     now = datetime.now(timezone.utc)
 
-    invite_count_subq = (
-        select(func.count(BounceInvite.id))
-        .where(BounceInvite.bounce_id == Bounce.id)
-        .correlate(Bounce)
-        .scalar_subquery()
-    )
-
-    # Get all public active future bounces
+    # Public active future bounces near the point
     stmt = (
-        select(Bounce, User, invite_count_subq.label('invite_count'))
+        select(Bounce, User, Bounce.invite_count)
         .join(User, Bounce.creator_id == User.id)
+        .where(await _public_filter(db, lat, lng, radius))
         .where(Bounce.is_public == True)
         .where(Bounce.status == 'active')
         .where(Bounce.bounce_time >= now)
@@ -707,16 +693,10 @@ async def get_bounce(
     if not (bounce.is_public or bounce.creator_id == current_user.id or is_invited):
         raise HTTPException(status_code=403, detail="Access denied")
 
-    # Get invite count
-    count_result = await db.execute(
-        select(func.count(BounceInvite.id)).where(BounceInvite.bounce_id == bounce_id)
-    )
-    invite_count = count_result.scalar() or 0
-
     # Get venue photo
     venue_photo = await get_venue_photo_url(db, bounce.places_fk_id)
 
-    return build_bounce_response(bounce, user, invite_count, venue_photo_url=venue_photo)
+    return build_bounce_response(bounce, user, bounce.invite_count or 0, venue_photo_url=venue_photo)
 
 
 @router.delete("/{bounce_id}", status_code=status.HTTP_204_NO_CONTENT)
@@ -755,6 +735,8 @@ async def delete_bounce(
 
     await db.delete(bounce)
     await db.commit()
+    await bounce_index.unindex_bounce(bounce_id)
+    await bounce_index.invalidate_bounce(bounce_id)
 
     logger.info(f"Bounce {bounce_id} deleted by user {current_user.id}")
 
@@ -763,13 +745,7 @@ async def delete_bounce(
         "type": "bounce_deleted",
         "bounce_id": bounce_id
     }
-    for user_id in users_to_notify:
-        if user_id in manager.active_connections:
-            for conn in manager.active_connections[user_id]:
-                try:
-                    await conn.send_json(deletion_message)
-                except Exception:
-                    pass
+    manager.send_to_users_local(users_to_notify, deletion_message)
 
 
 @router.post("/{bounce_id}/invite", status_code=status.HTTP_201_CREATED)
@@ -807,33 +783,34 @@ async def invite_to_bounce(
             db.add(invite)
             added += 1
             newly_invited.append(user_id)
+    bounce.invite_count = Bounce.invite_count + added
 
     await db.commit()
+    await bounce_index.invalidate_visible(newly_invited)
 
     logger.info(f"Added {added} invites to bounce {bounce_id}")
 
     # Send notifications to newly invited users
     from services.tasks import send_websocket_notification
 
+    payload = NotificationPayload(
+        notification_type=NotificationType.BOUNCE_INVITE,
+        title="Bounce Invite",
+        body=f"{current_user.nickname or current_user.first_name} invited you to bounce at {bounce.venue_name}",
+        actor_id=current_user.id,
+        actor_nickname=current_user.nickname or current_user.first_name or "Someone",
+        actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+        bounce_id=bounce.id,
+        bounce_venue_name=bounce.venue_name,
+        bounce_place_id=bounce.place_id
+    )
+    payload_dict = payload_to_dict(payload)
     for user_id in newly_invited:
-        payload = NotificationPayload(
-            notification_type=NotificationType.BOUNCE_INVITE,
-            title="Bounce Invite",
-            body=f"{current_user.nickname or current_user.first_name} invited you to bounce at {bounce.venue_name}",
-            actor_id=current_user.id,
-            actor_nickname=current_user.nickname or current_user.first_name or "Someone",
-            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-            bounce_id=bounce.id,
-            bounce_venue_name=bounce.venue_name,
-            bounce_place_id=bounce.place_id
-        )
-        payload_dict = payload_to_dict(payload)
-
         # Send WebSocket notification for in-app display (immediate)
         await send_websocket_notification(user_id, payload_dict)
 
-        # Queue push notification (background)
-        enqueue_notification(user_id, payload_dict)
+    # Queue push notifications (background, one batch)
+    enqueue_notifications_bulk(newly_invited, payload_dict)
 
     return {"added": added, "total": len(existing_user_ids) + added}
 
@@ -883,24 +860,22 @@ async def accept_bounce_invite(
     # Notify all participants (push + in-app)
     from services.tasks import send_websocket_notification
     actor_name = current_user.nickname or current_user.first_name or "Someone"
-    participants = await get_bounce_participants(db, bounce_id)
+    participants = [pid for pid in await get_bounce_participants(db, bounce_id) if pid != current_user.id]
+    payload = NotificationPayload(
+        notification_type=NotificationType.BOUNCE_ACCEPTED,
+        title="Bounce Accepted",
+        body=f"{actor_name} is coming to {bounce.venue_name}",
+        actor_id=current_user.id,
+        actor_nickname=actor_name,
+        actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+        bounce_id=bounce.id,
+        bounce_venue_name=bounce.venue_name,
+        bounce_place_id=bounce.place_id
+    )
+    payload_dict = payload_to_dict(payload)
     for pid in participants:
-        if pid == current_user.id:
-            continue
-        payload = NotificationPayload(
-            notification_type=NotificationType.BOUNCE_ACCEPTED,
-            title="Bounce Accepted",
-            body=f"{actor_name} is coming to {bounce.venue_name}",
-            actor_id=current_user.id,
-            actor_nickname=actor_name,
-            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-            bounce_id=bounce.id,
-            bounce_venue_name=bounce.venue_name,
-            bounce_place_id=bounce.place_id
-        )
-        payload_dict = payload_to_dict(payload)
         await send_websocket_notification(pid, payload_dict)
-        enqueue_notification(pid, payload_dict)
+    enqueue_notifications_bulk(participants, payload_dict)
 
     return {"success": True, "message": "Invite accepted"}
 
@@ -945,17 +920,12 @@ async def decline_bounce_invite(
     logger.info(f"Invite declined: bounce {bounce_id}, user {current_user.id}")
 
     # Notify the bounce creator
-    if bounce.creator_id in manager.active_connections:
-        for conn in manager.active_connections[bounce.creator_id]:
-            try:
-                await conn.send_json({
-                    "type": "bounce_invite_update",
-                    "bounce_id": bounce_id,
-                    "user_id": current_user.id,
-                    "status": "declined"
-                })
-            except Exception:
-                pass
+    manager.send_to_users_local([bounce.creator_id], {
+        "type": "bounce_invite_update",
+        "bounce_id": bounce_id,
+        "user_id": current_user.id,
+        "status": "declined"
+    })
 
     return {"success": True, "message": "Invite declined"}
 
@@ -999,22 +969,19 @@ async def remove_invite(
         raise HTTPException(status_code=404, detail="Invite not found")
 
     await db.delete(invite)
+    bounce.invite_count = Bounce.invite_count - 1
     await db.commit()
+    await bounce_index.invalidate_visible([user_id])
 
     logger.info(f"Invite removed: bounce {bounce_id}, user {user_id}, by {current_user.id}")
 
     # Notify the bounce creator that an attendee left (don't send bounce_deleted!)
-    if bounce.creator_id in manager.active_connections:
-        for conn in manager.active_connections[bounce.creator_id]:
-            try:
-                await conn.send_json({
-                    "type": "bounce_attendee_update",
-                    "bounce_id": bounce_id,
-                    "user_id": user_id,
-                    "action": "left"
-                })
-            except Exception:
-                pass
+    manager.send_to_users_local([bounce.creator_id], {
+        "type": "bounce_attendee_update",
+        "bounce_id": bounce_id,
+        "user_id": user_id,
+        "action": "left"
+    })
 
     return {"success": True, "message": "Invite removed"}
 
@@ -1147,17 +1114,13 @@ async def archive_bounce(
     bounce.status = 'archived'
     await db.commit()
     await db.refresh(bounce)
-
-    # Get invite count
-    count_result = await db.execute(
-        select(func.count(BounceInvite.id)).where(BounceInvite.bounce_id == bounce_id)
-    )
-    invite_count = count_result.scalar() or 0
+    await bounce_index.index_bounce(bounce)
+    await bounce_index.invalidate_bounce(bounce_id)
 
     # Get venue photo
     venue_photo = await get_venue_photo_url(db, bounce.places_fk_id)
 
-    return build_bounce_response(bounce, user, invite_count, venue_photo_url=venue_photo)
+    return build_bounce_response(bounce, user, bounce.invite_count or 0, venue_photo_url=venue_photo)
 
 
 # ============== Attendee Tracking ==============
@@ -1209,11 +1172,12 @@ async def get_nearby_bounces(
     )
     current_checkin = current_checkin_result.scalar_one_or_none()
 
-    # Find all active public 'now' bounces
+    # Active public 'now' bounces within check-in proximity
     stmt = (
         select(Bounce, User)
         .join(User, Bounce.creator_id == User.id)
         .where(
+            await _public_filter(db, lat, lng, BOUNCE_PROXIMITY_KM),
             Bounce.is_public == True,
             Bounce.is_now == True,
             Bounce.status == 'active'
@@ -1222,12 +1186,23 @@ async def get_nearby_bounces(
     result = await db.execute(stmt)
     rows = result.all()
 
+    attendee_counts = {}
+    if rows:
+        counts_result = await db.execute(
+            select(BounceAttendee.bounce_id, func.count(BounceAttendee.id))
+            .where(
+                BounceAttendee.bounce_id.in_([bounce.id for bounce, _ in rows]),
+                BounceAttendee.last_seen_at >= expiry_time
+            )
+            .group_by(BounceAttendee.bounce_id)
+        )
+        attendee_counts = dict(counts_result.all())
+
     nearby = []
     for bounce, creator in rows:
         distance_km = haversine_distance(lat, lng, bounce.latitude, bounce.longitude)
         if distance_km <= BOUNCE_PROXIMITY_KM:
-            # Get attendee count
-            attendee_count, _ = await get_active_attendees(db, bounce.id, include_details=False)
+            attendee_count = attendee_counts.get(bounce.id, 0)
 
             nearby.append(NearbyBounceInfo(
                 id=bounce.id,
@@ -1337,10 +1312,16 @@ async def checkin_to_bounce(
 
     await db.commit()
 
+    if not current_attendee:
+        record_interaction(current_user.id, bounce.place_id, W_BOUNCE_ATTENDED)
+
     # Broadcast update for previous bounce if user switched
     if previous_bounce_id:
         prev_count, prev_attendees = await get_active_attendees(db, previous_bounce_id, include_details=True)
-        await manager.broadcast({
+        prev_bounce = await db.get(Bounce, previous_bounce_id)
+        await manager.publish_geo(
+            prev_bounce.latitude if prev_bounce else bounce.latitude,
+            prev_bounce.longitude if prev_bounce else bounce.longitude, {
             "type": "bounce_attendee_update",
             "bounce_id": previous_bounce_id,
             "attendee_count": prev_count,
@@ -1352,8 +1333,8 @@ async def checkin_to_bounce(
 
     logger.info(f"User {current_user.id} checked in to bounce {bounce_id}. Total attendees: {count}")
 
-    # Broadcast attendee update via WebSocket
-    await manager.broadcast({
+    # Attendee update to clients around the bounce
+    await manager.publish_geo(bounce.latitude, bounce.longitude, {
         "type": "bounce_attendee_update",
         "bounce_id": bounce_id,
         "attendee_count": count,
@@ -1412,8 +1393,10 @@ async def leave_bounce(
 
     logger.info(f"User {current_user.id} left bounce {bounce_id}. Total attendees: {count}")
 
-    # Broadcast attendee update
-    await manager.broadcast({
+    # Attendee update to clients around the bounce
+    bounce = await db.get(Bounce, bounce_id)
+    await manager.publish_geo(bounce.latitude if bounce else None,
+                              bounce.longitude if bounce else None, {
         "type": "bounce_attendee_update",
         "bounce_id": bounce_id,
         "attendee_count": count,
@@ -6,15 +6,17 @@ from typing import List, Optional
 from datetime import datetime, timezone, timedelta
 from math import radians, sin, cos, sqrt, atan2
 
-from db.database import get_async_session
+from db.database import get_async_session, get_read_session
 from db.models import CheckIn, CheckInHistory, User, Place, Bounce, Follow
-from api.dependencies import get_current_user
+from api.dependencies import get_current_user, get_loaders
 from services.geofence import is_in_basel_area
 from services.places.service import get_place_with_photos
 from api.routes.websocket import manager
 from services.apns_service import NotificationPayload, NotificationType
 from services.cache import cache_get, cache_set, cache_delete
-from services.tasks import enqueue_notification, payload_to_dict
+from services.loaders import Loaders
+from services.tasks import enqueue_notifications_bulk, payload_to_dict
+from services.recommendations import W_CHECKIN, record_interaction
 import logging
 
 logger = logging.getLogger(__name__)
@@ -51,57 +53,61 @@ async def auto_checkout_if_needed(db: AsyncSession, user_id: int, user_lat: floa
     Check if user has an active venue check-in and is far enough away to auto-checkout.
     Returns the place_id if auto-checkout was performed, None otherwise.
     """
+    checked_out = await auto_checkout_many(db, {user_id: (user_lat, user_lng)})
+    return checked_out[0] if checked_out else None
+
+
+async def auto_checkout_many(db: AsyncSession, positions: dict) -> List[str]:
+    """
+    Batched auto_checkout_if_needed for {user_id: (lat, lng)}: one query for
+    every user's active venue check-in, one commit for all checkouts.
+    Used by the location write-behind flusher. Returns checked-out place_ids.
+    """
+    if not positions:
+        return []
     expiry_time = datetime.now(timezone.utc) - timedelta(hours=CHECKIN_EXPIRY_HOURS)
     result = await db.execute(
-        select(CheckIn).where(
+        select(CheckIn, Place).join(Place, Place.id == CheckIn.places_fk_id).where(
             and_(
-                CheckIn.user_id == user_id,
+                CheckIn.user_id.in_(list(positions)),
                 CheckIn.is_active == True,
                 CheckIn.last_seen_at >= expiry_time,
-                CheckIn.places_fk_id.isnot(None)
             )
         )
     )
-    checkin = result.scalar_one_or_none()
-    if not checkin:
-        return None
-
-    # Get venue coordinates from the Place record
-    place_result = await db.execute(
-        select(Place).where(Place.id == checkin.places_fk_id)
-    )
-    place = place_result.scalar_one_or_none()
-    if not place:
-        return None
 
-    distance = haversine_distance(user_lat, user_lng, place.latitude, place.longitude)
-    if distance <= AUTO_CHECKOUT_RADIUS_METERS:
-        return None
-
-    place_id = checkin.place_id
-    venue_name = checkin.location_name
+    checkouts = []
+    for checkin, place in result.all():
+        user_lat, user_lng = positions[checkin.user_id]
+        distance = haversine_distance(user_lat, user_lng, place.latitude, place.longitude)
+        if distance <= AUTO_CHECKOUT_RADIUS_METERS:
+            continue
+        checkouts.append((checkin.user_id, checkin.place_id, checkin.location_name, distance, place))
+        # Auto-checkout: move to history
+        await move_checkin_to_history(db, checkin)
 
-    # Auto-checkout: move to history
-    await move_checkin_to_history(db, checkin)
+    if not checkouts:
+        return []
     await db.commit()
 
-    # Invalidate venue count cache
-    if place_id:
-        await cache_delete(f"venue_count:{place_id}")
+    for user_id, place_id, venue_name, distance, place in checkouts:
+        # Invalidate venue count cache
+        if place_id:
+            await cache_delete(f"venue_count:{place_id}")
 
-    # Broadcast checkout to all connected clients
-    checkout_event = {
-        "type": "venue_checkout",
-        "place_id": place_id,
-        "venue_name": venue_name,
-        "user_id": user_id,
-        "timestamp": datetime.now(timezone.utc).isoformat()
-    }
-    await manager.broadcast(checkout_event)
-    await manager.send_to_venue_feed(place_id, checkout_event)
+        # Checkout goes to clients around the venue
+        checkout_event = {
+            "type": "venue_checkout",
+            "place_id": place_id,
+            "venue_name": venue_name,
+            "user_id": user_id,
+            "timestamp": datetime.now(timezone.utc).isoformat()
+        }
+        await manager.publish_geo(place.latitude, place.longitude, checkout_event)
+        await manager.send_to_venue_feed(place_id, checkout_event)
 
-    logger.info(f"Auto-checkout user {user_id} from venue {place_id} (distance: {int(distance)}m)")
-    return place_id
+        logger.info(f"Auto-checkout user {user_id} from venue {place_id} (distance: {int(distance)}m)")
+    return [c[1] for c in checkouts]
 
 
 def haversine_distance(lat1: float, lng1: float, lat2: float, lng2: float) -> float:
@@ -271,14 +277,13 @@ async def get_venues_with_checkins_in_area(
     lat: float,
     lng: float,
     radius: float = 5000,
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Get all venues with active check-ins within a radius.
     Returns venues with their check-in counts for map display.
     """
-    from db.models import GooglePic
-
     expiry_time = datetime.now(timezone.utc) - timedelta(hours=CHECKIN_EXPIRY_HOURS)
 
     # Get all active check-ins grouped by place_id
@@ -301,37 +306,29 @@ async def get_venues_with_checkins_in_area(
 
     venues = []
     rows = result.all()
-    for row in rows:
-        # Get place info from Place table (required for accurate coordinates)
-        place_result = await db.execute(
-            select(Place).where(Place.place_id == row.place_id)
-        )
-        place = place_result.scalar_one_or_none()
-
-        if not place:
-            continue
-
-        # Filter by distance using venue coordinates from Place table
-        distance = haversine_distance(lat, lng, place.latitude, place.longitude)
-        if distance <= radius:
-            # Get photos — stable /img URLs (key stays server-side; a bare
-            # photo_reference is not a usable URL, so never fall back to it)
-            photos = []
-            pics_result = await db.execute(
-                select(GooglePic).where(GooglePic.place_id == place.id).limit(3)
-            )
-            for i, _pic in enumerate(pics_result.scalars().all()):
-                photos.append({"url": f"/img/place/{place.id}/{i}"})
-
-            venues.append(VenueWithCheckInsResponse(
-                place_id=row.place_id,
-                name=place.name,
-                address=place.address,
-                latitude=place.latitude,
-                longitude=place.longitude,
-                checkin_count=row.checkin_count,
-                photos=photos
-            ))
+    # Place rows (required for accurate coordinates), then photo counts for the
+    # ones in range — two queries total instead of two per venue
+    places = await loaders.places_by_google_id.load_many([row.place_id for row in rows])
+    in_range = [
+        (row, place) for row, place in zip(rows, places)
+        if place and haversine_distance(lat, lng, place.latitude, place.longitude) <= radius
+    ]
+    photo_counts = await loaders.photo_counts.load_many([place.id for _, place in in_range])
+
+    for (row, place), photo_count in zip(in_range, photo_counts):
+        # Photos as stable /img URLs (key stays server-side; a bare
+        # photo_reference is not a usable URL, so never fall back to it)
+        photos = [{"url": f"/img/place/{place.id}/{i}"} for i in range(photo_count or 0)]
+
+        venues.append(VenueWithCheckInsResponse(
+            place_id=row.place_id,
+            name=place.name,
+            address=place.address,
+            latitude=place.latitude,
+            longitude=place.longitude,
+            checkin_count=row.checkin_count,
+            photos=photos
+        ))
 
     total_users = sum(v.checkin_count for v in venues)
     return VenuesWithCheckInsResponse(venues=venues, total_checked_in_users=total_users)
@@ -436,7 +433,10 @@ async def checkin_to_venue(
     # Invalidate venue count cache
     await cache_delete(f"venue_count:{place_id}")
 
-    # Broadcast check-in to all connected clients
+    # Suggestions reflect the visit now, not at the next model rebuild
+    record_interaction(current_user.id, place_id, W_CHECKIN)
+
+    # Check-in goes to clients around the venue
     checkin_event = {
         "type": "venue_checkin",
         "place_id": place_id,
@@ -447,7 +447,7 @@ async def checkin_to_venue(
         "nickname": current_user.nickname,
         "timestamp": datetime.now(timezone.utc).isoformat()
     }
-    await manager.broadcast(checkin_event)
+    await manager.publish_geo(place.latitude, place.longitude, checkin_event)
 
     # Also into the venue's live feed room ("X joined" row)
     profile_pic = current_user.profile_picture or current_user.instagram_profile_pic
@@ -481,23 +481,25 @@ async def checkin_to_venue(
     from services.tasks import send_websocket_notification
 
     # Notify users at the same venue
-    for user, _ in same_venue_followers_result.all():
-        payload = NotificationPayload(
-            notification_type=NotificationType.FRIEND_AT_VENUE,
-            title="Friend Arrived",
-            body=f"{current_user.nickname} just arrived at {place.name}",
-            actor_id=current_user.id,
-            actor_nickname=current_user.nickname or current_user.first_name or "Someone",
-            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-            venue_place_id=place_id,
-            venue_name=place.name,
-            venue_latitude=place.latitude,
-            venue_longitude=place.longitude
-        )
-        payload_dict = payload_to_dict(payload)
-        await send_websocket_notification(user.id, payload_dict)
-        enqueue_notification(user.id, payload_dict)
-        logger.info(f"Sent friend_at_venue notification for user {user.id}")
+    payload = NotificationPayload(
+        notification_type=NotificationType.FRIEND_AT_VENUE,
+        title="Friend Arrived",
+        body=f"{current_user.nickname} just arrived at {place.name}",
+        actor_id=current_user.id,
+        actor_nickname=current_user.nickname or current_user.first_name or "Someone",
+        actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+        venue_place_id=place_id,
+        venue_name=place.name,
+        venue_latitude=place.latitude,
+        venue_longitude=place.longitude
+    )
+    payload_dict = payload_to_dict(payload)
+    recipients = [user.id for user, _ in same_venue_followers_result.all()]
+    for user_id in recipients:
+        await send_websocket_notification(user_id, payload_dict)
+    enqueue_notifications_bulk(recipients, payload_dict)
+    if recipients:
+        logger.info(f"Sent friend_at_venue notification to {len(recipients)} user(s)")
 
     # Notify users who have the current user marked as a close friend
     close_friend_followers_result = await db.execute(
@@ -510,23 +512,25 @@ async def checkin_to_venue(
         ).where(User.id != current_user.id)
     )
 
-    for user in close_friend_followers_result.scalars().all():
-        payload = NotificationPayload(
-            notification_type=NotificationType.CLOSE_FRIEND_CHECKIN,
-            title="Close Friend Check-in",
-            body=f"{current_user.nickname} checked into {place.name}",
-            actor_id=current_user.id,
-            actor_nickname=current_user.nickname or current_user.first_name or "Someone",
-            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-            venue_place_id=place_id,
-            venue_name=place.name,
-            venue_latitude=place.latitude,
-            venue_longitude=place.longitude
-        )
-        payload_dict = payload_to_dict(payload)
-        await send_websocket_notification(user.id, payload_dict)
-        enqueue_notification(user.id, payload_dict)
-        logger.info(f"Sent close_friend_checkin notification for user {user.id}")
+    payload = NotificationPayload(
+        notification_type=NotificationType.CLOSE_FRIEND_CHECKIN,
+        title="Close Friend Check-in",
+        body=f"{current_user.nickname} checked into {place.name}",
+        actor_id=current_user.id,
+        actor_nickname=current_user.nickname or current_user.first_name or "Someone",
+        actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+        venue_place_id=place_id,
+        venue_name=place.name,
+        venue_latitude=place.latitude,
+        venue_longitude=place.longitude
+    )
+    payload_dict = payload_to_dict(payload)
+    recipients = [user.id for user in close_friend_followers_result.scalars().all()]
+    for user_id in recipients:
+        await send_websocket_notification(user_id, payload_dict)
+    enqueue_notifications_bulk(recipients, payload_dict)
+    if recipients:
+        logger.info(f"Sent close_friend_checkin notification to {len(recipients)} user(s)")
 
     return VenueCheckInResponse(
         id=checkin.id,
@@ -700,25 +704,27 @@ async def checkout_from_venue(
     # Send notifications (WebSocket + push)
     from services.tasks import send_websocket_notification
 
-    for user, _ in same_venue_followers_result.all():
-        payload = NotificationPayload(
-            notification_type=NotificationType.FRIEND_LEFT_VENUE,
-            title="Friend Left",
-            body=f"{current_user.nickname} left {venue_name}",
-            actor_id=current_user.id,
-            actor_nickname=current_user.nickname or current_user.first_name or "Someone",
-            actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
-            venue_place_id=place_id,
-            venue_name=venue_name,
-            venue_latitude=place.latitude if place else None,
-            venue_longitude=place.longitude if place else None
-        )
-        payload_dict = payload_to_dict(payload)
-        await send_websocket_notification(user.id, payload_dict)
-        enqueue_notification(user.id, payload_dict)
-        logger.info(f"Sent friend_left_venue notification for user {user.id}")
-
-    # Broadcast checkout to all connected clients
+    payload = NotificationPayload(
+        notification_type=NotificationType.FRIEND_LEFT_VENUE,
+        title="Friend Left",
+        body=f"{current_user.nickname} left {venue_name}",
+        actor_id=current_user.id,
+        actor_nickname=current_user.nickname or current_user.first_name or "Someone",
+        actor_profile_picture=current_user.profile_picture or current_user.instagram_profile_pic,
+        venue_place_id=place_id,
+        venue_name=venue_name,
+        venue_latitude=place.latitude if place else None,
+        venue_longitude=place.longitude if place else None
+    )
+    payload_dict = payload_to_dict(payload)
+    recipients = [user.id for user, _ in same_venue_followers_result.all()]
+    for user_id in recipients:
+        await send_websocket_notification(user_id, payload_dict)
+    enqueue_notifications_bulk(recipients, payload_dict)
+    if recipients:
+        logger.info(f"Sent friend_left_venue notification to {len(recipients)} user(s)")
+
+    # Checkout goes to clients around the venue
     checkout_event = {
         "type": "venue_checkout",
         "place_id": place_id,
@@ -727,7 +733,8 @@ async def checkout_from_venue(
         "nickname": current_user.nickname,
         "timestamp": datetime.now(timezone.utc).isoformat()
     }
-    await manager.broadcast(checkout_event)
+    await manager.publish_geo(place.latitude if place else checkin.latitude,
+                              place.longitude if place else checkin.longitude, checkout_event)
     await manager.send_to_venue_feed(place_id, checkout_event)
 
     return {"message": "Successfully checked out"}
@@ -762,7 +769,7 @@ async def get_my_checkin_history(
     limit: int = 50,
     offset: int = 0,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get current user's check-in history."""
     result = await db.execute(
@@ -781,7 +788,7 @@ async def get_user_checkin_history(
     limit: int = 50,
     offset: int = 0,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get a user's check-in history."""
     result = await db.execute(
@@ -800,7 +807,7 @@ async def get_venue_checkin_history(
     limit: int = 50,
     offset: int = 0,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get a venue's check-in history (all users who checked in)."""
     result = await db.execute(
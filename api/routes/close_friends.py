@@ -5,15 +5,19 @@ from pydantic import BaseModel
 from typing import Optional, List
 import asyncio
 import logging
+import time
 from datetime import datetime, timezone, timedelta
 
 from db.database import get_async_session, get_session_maker
 from db.models import User, Follow, CheckIn
-from api.dependencies import get_current_user
+from api.dependencies import get_current_user, get_loaders
 from api.routes.websocket import manager as ws_manager
 from api.routes.users import SimpleUserResponse
 from services.tasks import enqueue_notification, payload_to_dict
 from api.routes.checkins import auto_checkout_if_needed
+from services.loaders import Loaders
+from services.location_store import get_positions, record_location
+from services.silent_push import TICK_SECONDS, refresh_sharer, run_tick
 
 router = APIRouter(prefix="/users", tags=["close-friends"])
 logger = logging.getLogger(__name__)
@@ -40,57 +44,13 @@ async def stop_silent_push_loop():
         logger.info("Stopped silent push loop")
 
 
-# APNs budgets content-available pushes to roughly a few per hour per device when the
-# app isn't in use — a 30s cadence just gets throttled while burning APNs traffic and
-# device battery. A few minutes is the fastest cadence that reliably delivers.
-SILENT_PUSH_INTERVAL_SECONDS = 180
-
-
 async def _silent_push_loop():
-    """Periodically send silent pushes to users who are sharing location with close friends"""
-    from services.apns_service import get_apns_service
-    from services.redis import get_redis
-
+    """Drive the silent push timing wheel (services/silent_push.py): one slot per tick"""
+    session_maker = get_session_maker()
     while True:
         try:
-            await asyncio.sleep(SILENT_PUSH_INTERVAL_SECONDS)
-
-            # Cross-worker lock: with multiple workers/instances, only one may send per tick,
-            # otherwise every process duplicates every push
-            try:
-                r = await get_redis()
-                acquired = await r.set(
-                    "locks:silent_push_tick", "1",
-                    nx=True, ex=SILENT_PUSH_INTERVAL_SECONDS - 15
-                )
-                if not acquired:
-                    continue
-            except Exception as e:
-                logger.warning(f"Silent push lock unavailable, proceeding without it: {e}")
-
-            session_maker = get_session_maker()
-            async with session_maker() as db:
-                # Find all users who are actively sharing location with at least one close friend
-                result = await db.execute(
-                    select(Follow.follower_id).where(
-                        Follow.close_friend_status == 'accepted',
-                        Follow.is_sharing_location == True
-                    ).distinct()
-                )
-                user_ids = [row[0] for row in result.all()]
-
-                if not user_ids:
-                    continue
-
-                apns = await get_apns_service()
-                for user_id in user_ids:
-                    try:
-                        await apns.send_silent_push(db, user_id)
-                    except Exception as e:
-                        logger.error(f"Silent push failed for user {user_id}: {e}")
-
-                logger.debug(f"Sent silent pushes to {len(user_ids)} users sharing location")
-
+            await asyncio.sleep(TICK_SECONDS - time.time() % TICK_SECONDS)
+            await run_tick(session_maker)
         except asyncio.CancelledError:
             break
         except Exception as e:
@@ -152,7 +112,8 @@ async def get_pending_close_friend_requests(
 async def request_close_friend(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Request to become close friends with a user.
@@ -161,27 +122,12 @@ async def request_close_friend(
     if user_id == current_user.id:
         raise HTTPException(status_code=400, detail="Cannot add yourself as close friend")
 
-    # Check if current user follows target user
-    result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow = result.scalar_one_or_none()
+    # Both follow edges in one query
+    follow, reverse_follow = await loaders.follow_pair(current_user.id, user_id)
 
     if not follow:
         raise HTTPException(status_code=404, detail="Not following this user")
 
-    # Check if it's a mutual follow
-    reverse_result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    reverse_follow = reverse_result.scalar_one_or_none()
-
     if not reverse_follow:
         raise HTTPException(
             status_code=400,
@@ -239,19 +185,14 @@ async def request_close_friend(
 async def accept_close_friend(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Accept a close friend request from another user.
     """
-    # Check if current user follows target user
-    result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow = result.scalar_one_or_none()
+    # Both follow edges in one query
+    follow, reverse_follow = await loaders.follow_pair(current_user.id, user_id)
 
     if not follow:
         raise HTTPException(status_code=404, detail="Not following this user")
@@ -263,15 +204,6 @@ async def accept_close_friend(
     if follow.close_friend_requester_id == current_user.id:
         raise HTTPException(status_code=400, detail="Cannot accept your own request")
 
-    # Get reverse follow
-    reverse_result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    reverse_follow = reverse_result.scalar_one_or_none()
-
     # Set status to accepted on both follow records
     follow.close_friend_status = 'accepted'
     follow.is_close_friend = True
@@ -317,19 +249,14 @@ async def accept_close_friend(
 async def decline_close_friend(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Decline a close friend request from another user.
     """
-    # Check if current user follows target user
-    result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow = result.scalar_one_or_none()
+    # Both follow edges in one query
+    follow, reverse_follow = await loaders.follow_pair(current_user.id, user_id)
 
     if not follow:
         raise HTTPException(status_code=404, detail="Not following this user")
@@ -338,15 +265,6 @@ async def decline_close_friend(
     if follow.close_friend_status != 'pending':
         raise HTTPException(status_code=400, detail="No pending close friend request")
 
-    # Get reverse follow
-    reverse_result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    reverse_follow = reverse_result.scalar_one_or_none()
-
     # Reset status to none on both follow records
     # Also clear location sharing so it can't silently resume if they become close friends again
     follow.close_friend_status = 'none'
@@ -358,6 +276,8 @@ async def decline_close_friend(
         reverse_follow.is_sharing_location = False
 
     await db.commit()
+    await refresh_sharer(db, current_user.id)
+    await refresh_sharer(db, user_id)
 
     # Send WebSocket notification to the requester
     notification_payload = {
@@ -379,19 +299,14 @@ async def decline_close_friend(
 async def remove_close_friend(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Remove close friend status. When either user removes, it removes for both.
     """
-    # Check if current user follows target user
-    result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow = result.scalar_one_or_none()
+    # Both follow edges in one query
+    follow, reverse_follow = await loaders.follow_pair(current_user.id, user_id)
 
     if not follow:
         raise HTTPException(status_code=404, detail="Not following this user")
@@ -400,15 +315,6 @@ async def remove_close_friend(
     if follow.close_friend_status == 'none':
         raise HTTPException(status_code=400, detail="Not close friends")
 
-    # Get reverse follow
-    reverse_result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    reverse_follow = reverse_result.scalar_one_or_none()
-
     # Reset status to none on both follow records
     # Also clear location sharing so it can't silently resume if they become close friends again
     follow.close_friend_status = 'none'
@@ -422,6 +328,8 @@ async def remove_close_friend(
         reverse_follow.is_sharing_location = False
 
     await db.commit()
+    await refresh_sharer(db, current_user.id)
+    await refresh_sharer(db, user_id)
 
     # Send WebSocket notification to the other user
     notification_payload = {
@@ -507,6 +415,7 @@ async def toggle_location_sharing(
     follow.is_sharing_location = new_state
 
     await db.commit()
+    await refresh_sharer(db, current_user.id)
 
     # If enabling location sharing, notify the other user
     if new_state:
@@ -562,29 +471,15 @@ async def toggle_location_sharing(
 async def get_location_sharing_status(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_async_session),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Get location sharing status between current user and target user.
     Returns whether each user is sharing their location with the other.
     """
-    # Check if current user follows target user
-    result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow = result.scalar_one_or_none()
-
-    # Check reverse follow
-    reverse_result = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    reverse_follow = reverse_result.scalar_one_or_none()
+    # Both follow edges in one query
+    follow, reverse_follow = await loaders.follow_pair(current_user.id, user_id)
 
     return {
         "user_id": user_id,
@@ -605,14 +500,13 @@ async def broadcast_location_to_close_friends(
     - We are sharing our location with them (our is_sharing_location = True)
     - The close friend relationship is accepted
     """
-    # Update user's last location
-    current_user.last_location_lat = location.latitude
-    current_user.last_location_lon = location.longitude
-    current_user.last_location_update = datetime.now(timezone.utc)
-    await db.commit()
-
-    # Auto-checkout from venue if user has moved far enough away
-    await auto_checkout_if_needed(db, current_user.id, location.latitude, location.longitude)
+    # Update user's last location (write-behind; the flusher handles auto-checkout)
+    if not await record_location(current_user.id, location.latitude, location.longitude):
+        current_user.last_location_lat = location.latitude
+        current_user.last_location_lon = location.longitude
+        current_user.last_location_update = datetime.now(timezone.utc)
+        await db.commit()
+        await auto_checkout_if_needed(db, current_user.id, location.latitude, location.longitude)
 
     # Find all close friends we're sharing location with
     result = await db.execute(
@@ -666,13 +560,18 @@ async def get_close_friend_locations(
             Follow.following_id == current_user.id,
             Follow.close_friend_status == 'accepted',
             Follow.is_sharing_location == True,
-            User.last_location_lat.isnot(None),
-            User.last_location_lon.isnot(None),
-            User.last_location_update.isnot(None),
-            User.last_location_update >= staleness_cutoff
         )
     )
-    rows = result.all()
+    # Buffered fixes are newer than the row (which lags by a flush interval)
+    candidates = result.all()
+    buffered = await get_positions(user.id for user, _ in candidates)
+    rows, positions = [], {}
+    for user, follow in candidates:
+        pos = buffered.get(user.id) or (user.last_location_lat, user.last_location_lon, user.last_location_update)
+        if pos[0] is None or pos[1] is None or pos[2] is None or pos[2] < staleness_cutoff:
+            continue
+        rows.append((user, follow))
+        positions[user.id] = pos
     logger.info(f"Found {len(rows)} close friends sharing location")
 
     # Get active check-ins for these users
@@ -692,9 +591,9 @@ async def get_close_friend_locations(
             user_id=user.id,
             nickname=user.nickname or user.first_name,
             profile_picture=user.profile_picture or user.instagram_profile_pic,
-            latitude=user.last_location_lat,
-            longitude=user.last_location_lon,
-            updated_at=user.last_location_update,
+            latitude=positions[user.id][0],
+            longitude=positions[user.id][1],
+            updated_at=positions[user.id][2],
             checked_in_venue=checkin.location_name if checkin else None
         ))
 
@@ -16,7 +16,8 @@ from core.config import settings
 from services.cache import cache_get, cache_set, single_flight
 from services.places.autocomplete import (
     global_autocomplete_search,
-    index_place as index_place_to_cache
+    index_place as index_place_to_cache,
+    record_google_fallback,
 )
 
 router = APIRouter(prefix="/geocoding", tags=["geocoding"])
@@ -424,6 +425,7 @@ async def places_autocomplete(
             return AutocompleteResponse(predictions=predictions, from_cache=True)
 
     # 3. Fall back to Google API (no matches or none within 100km)
+    record_google_fallback()
     if not settings.GOOGLE_MAPS_API_KEY:
         # If no API key, return whatever we have from cache
         if cached_results:
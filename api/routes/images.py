@@ -3,6 +3,11 @@
 GET /img/place/{places_fk_id}        first venue photo
 GET /img/place/{places_fk_id}/{n}    nth venue photo (0-4)
 GET /img/user/{user_id}              profile picture
+GET /img/blob/{name}                 content-addressed upload (services/blob_store.py)
+
+All of them take `?w=<px>&fmt=webp|jpeg`: the image is resized (width snapped
+up to image_variants.VARIANT_WIDTHS) and re-encoded on first request, so a
+40px map avatar no longer downloads an 800px Google photo.
 
 Why this exists:
 - Google photo URLs previously shipped to clients with the API key embedded;
@@ -11,33 +16,70 @@ Why this exists:
   by URL, so client-side caches finally work for them.
 - Bytes are cached in Redis (binary client) and served with ETag/304 and a
   long Cache-Control, so repeat loads cost nothing.
+- Uploads live in the blob store; those are streamed straight from it (file
+  response on local disk) with the content hash as a strong ETag, no Redis
+  copy and no base64 decoding. Only /img/blob/ is immutable; a blob reached
+  through /img/user/{id} is revalidated, since that URL changes meaning.
+- Variants are tiered: per-process LRU (hot avatars) -> Redis (place / user
+  sources) or the blob store itself (blob sources, stored as
+  <hash>.w<px>.<ext>) -> build. Concurrent misses share one build.
 
 Endpoints are public by design — image URLs are fetched by clients without
 auth headers (same exposure as the existing /bounce/img-proxy).
 """
 
-import base64
 import hashlib
 import logging
 from typing import Callable, Optional
 
 import httpx
 from fastapi import APIRouter, Depends, HTTPException, Request, Response
+from fastapi.responses import FileResponse
 from sqlalchemy import select
 from sqlalchemy.ext.asyncio import AsyncSession
 
 from core.config import settings
 from db.database import get_async_session
 from db.models import GooglePic, User
+from services import blob_store, image_variants
 from services.redis import circuit_is_open, get_redis_binary
 
 router = APIRouter(prefix="/img", tags=["images"])
 logger = logging.getLogger(__name__)
 
 IMG_TTL = 7 * 24 * 3600
+BLOB_CACHE_CONTROL = "public, max-age=31536000, immutable"
+# /img/user/{id} serves whatever the user's picture is now: revalidate every
+# time (a 304 against the blob hash ETag) so a new picture shows up at once
+USER_BLOB_CACHE_CONTROL = "public, no-cache"
 MAX_IMAGE_BYTES = 5 * 1024 * 1024
+# Full-size originals past this are refetched rather than pinned in Redis;
+# clients asking for ?w= hit the (small) cached variant instead
+REDIS_MAX_ITEM_BYTES = 1024 * 1024
 FETCH_TIMEOUT = 10.0
 
+_http_client: Optional[httpx.AsyncClient] = None
+_l1 = image_variants.MemoryLRU()
+
+
+def _get_http_client() -> httpx.AsyncClient:
+    """Shared client: keeps TLS/HTTP connections to Google and CDNs warm."""
+    global _http_client
+    if _http_client is None or _http_client.is_closed:
+        _http_client = httpx.AsyncClient(
+            follow_redirects=True,
+            timeout=FETCH_TIMEOUT,
+            limits=httpx.Limits(max_connections=50, max_keepalive_connections=20),
+        )
+    return _http_client
+
+
+async def close_http_client():
+    global _http_client
+    if _http_client is not None:
+        await _http_client.aclose()
+        _http_client = None
+
 
 async def _cache_get(key: str) -> tuple[Optional[bytes], Optional[str]]:
     if circuit_is_open():
@@ -70,40 +112,69 @@ async def _cache_set(key: str, data: bytes, content_type: str):
 
 async def _fetch_remote(url: str) -> tuple[Optional[bytes], Optional[str]]:
     try:
-        async with httpx.AsyncClient(follow_redirects=True, timeout=FETCH_TIMEOUT) as client:
-            resp = await client.get(url)
-            if resp.status_code != 200:
-                return None, None
-            content_type = resp.headers.get("content-type", "image/jpeg")
-            if not content_type.startswith("image/"):
-                return None, None
-            if len(resp.content) > MAX_IMAGE_BYTES:
-                return None, None
-            return resp.content, content_type
+        resp = await _get_http_client().get(url)
+        if resp.status_code != 200:
+            return None, None
+        content_type = resp.headers.get("content-type", "image/jpeg")
+        if not content_type.startswith("image/"):
+            return None, None
+        if len(resp.content) > MAX_IMAGE_BYTES:
+            return None, None
+        return resp.content, content_type
     except Exception as e:
         logger.warning(f"Image fetch failed for {url[:80]}: {e}")
         return None, None
 
 
-def _parse_data_uri(uri: str) -> tuple[Optional[bytes], Optional[str]]:
-    try:
-        header, b64 = uri.split(",", 1)
-        content_type = "image/jpeg"
-        if header.startswith("data:") and ";" in header:
-            content_type = header[5:].split(";")[0] or "image/jpeg"
-        return base64.b64decode(b64), content_type
-    except Exception:
-        return None, None
-
-
-async def _serve(request: Request, cache_key: str, resolve) -> Response:
-    """Cache -> resolve -> ETag/304 -> long-lived response."""
+async def _original(cache_key: str, resolve) -> tuple[Optional[bytes], Optional[str]]:
     data, content_type = await _cache_get(cache_key)
     if data is None:
         data, content_type = await resolve()
-        if data is None:
-            raise HTTPException(status_code=404, detail="Image not found")
-        await _cache_set(cache_key, data, content_type or "image/jpeg")
+        if data is not None and len(data) <= REDIS_MAX_ITEM_BYTES:
+            await _cache_set(cache_key, data, content_type or "image/jpeg")
+    return data, content_type
+
+
+async def _variant(cache_key: str, resolve, width: Optional[int], fmt: Optional[str]):
+    """L1 -> Redis -> single-flight build from the original."""
+    vkey = f"{cache_key}:w{width or 0}:{fmt or 'src'}"
+    hit = _l1.get(vkey)
+    if hit is not None:
+        return hit
+    data, content_type = await _cache_get(vkey)
+    if data is not None:
+        _l1.put(vkey, data, content_type)
+        return data, content_type
+
+    async def build():
+        src, src_type = await _original(cache_key, resolve)
+        if src is None:
+            return None, None
+        out, out_type = await image_variants.transcode(src, width, fmt)
+        if out_type is None:
+            # Undecodable (or no Pillow): the original is still a valid answer
+            return src, src_type
+        await _cache_set(vkey, out, out_type)
+        _l1.put(vkey, out, out_type)
+        return out, out_type
+
+    return await image_variants.single_flight(vkey, build)
+
+
+async def _serve(
+    request: Request,
+    cache_key: str,
+    resolve,
+    width: Optional[int] = None,
+    fmt: Optional[str] = None,
+) -> Response:
+    """Cache -> resolve (-> variant) -> ETag/304 -> long-lived response."""
+    if width or fmt:
+        data, content_type = await _variant(cache_key, resolve, width, fmt)
+    else:
+        data, content_type = await _original(cache_key, resolve)
+    if data is None:
+        raise HTTPException(status_code=404, detail="Image not found")
 
     etag = f'W/"{hashlib.sha1(data).hexdigest()[:20]}"'
     if request.headers.get("if-none-match") == etag:
@@ -119,12 +190,94 @@ async def _serve(request: Request, cache_key: str, resolve) -> Response:
     )
 
 
+async def _blob_variant(name: str, vname: str, width: Optional[int]):
+    """Build variant `vname` of blob `name` and persist it next to the original."""
+    src = await blob_store.get_blob(name)
+    if src is None:
+        return None, None
+    ext = vname.rsplit(".", 1)[-1]
+    out, out_type = await image_variants.transcode(src, width, "jpeg" if ext == "jpg" else ext)
+    if out_type is None:
+        return src, blob_store.content_type_for(name)
+    try:
+        await blob_store.put_blob(vname, out, out_type)
+    except Exception as e:
+        logger.warning(f"Blob variant store failed for {vname}: {e}")
+    return out, out_type
+
+
+async def _serve_blob(
+    request: Request,
+    name: str,
+    width: Optional[int] = None,
+    fmt: Optional[str] = None,
+    cache_control: str = BLOB_CACHE_CONTROL,
+) -> Response:
+    """Stream a blob; names are content hashes, so the ETag never needs the bytes.
+    The default Cache-Control is only right for the content-addressed URL."""
+    if not blob_store.valid_name(name):
+        raise HTTPException(status_code=404, detail="Image not found")
+    vname = blob_store.variant_name(name, width, fmt) if (width or fmt) else None
+    if vname is not None:
+        return await _serve_blob_variant(request, name, vname, width, cache_control)
+    etag = blob_store.etag_for(name)
+    headers = {"Cache-Control": cache_control, "ETag": etag}
+    if request.headers.get("if-none-match") == etag:
+        return Response(status_code=304, headers=headers)
+    media_type = blob_store.content_type_for(name)
+
+    path = blob_store.local_path(name)
+    if path is not None:
+        return FileResponse(path, media_type=media_type, headers=headers)
+    data = await blob_store.get_blob(name)
+    if data is None:
+        raise HTTPException(status_code=404, detail="Image not found")
+    return Response(content=data, media_type=media_type, headers=headers)
+
+
+async def _serve_blob_variant(request: Request, name: str, vname: str, width: Optional[int],
+                              cache_control: str = BLOB_CACHE_CONTROL) -> Response:
+    """L1 -> blob store -> single-flight build. Variants are immutable like
+    their originals, so no Redis tier is needed for these."""
+    etag = blob_store.etag_for(vname)
+    headers = {"Cache-Control": cache_control, "ETag": etag}
+    if request.headers.get("if-none-match") == etag:
+        return Response(status_code=304, headers=headers)
+
+    hit = _l1.get(vname)
+    if hit is not None:
+        return Response(content=hit[0], media_type=hit[1], headers=headers)
+    path = blob_store.local_path(vname)
+    if path is not None:
+        return FileResponse(path, media_type=blob_store.content_type_for(vname), headers=headers)
+
+    data = await blob_store.get_blob(vname)
+    if data is not None:
+        content_type = blob_store.content_type_for(vname)
+    else:
+        data, content_type = await image_variants.single_flight(
+            f"blob:{vname}", lambda: _blob_variant(name, vname, width)
+        )
+        if data is None:
+            raise HTTPException(status_code=404, detail="Image not found")
+    _l1.put(vname, data, content_type)
+    return Response(content=data, media_type=content_type, headers=headers)
+
+
+@router.get("/blob/{name}")
+async def get_blob_image(name: str, request: Request, w: Optional[int] = None, fmt: Optional[str] = None):
+    """Uploaded image by content hash (the ref stored in user / feed rows)."""
+    return await _serve_blob(request, name, image_variants.snap_width(w), image_variants.normalize_format(fmt))
+
+
 @router.get("/place/{places_fk_id}")
 @router.get("/place/{places_fk_id}/{n}")
 async def get_place_image(
     places_fk_id: int,
     request: Request,
     n: int = 0,
+    w: Optional[int] = None,
+    fmt: Optional[str] = None,
     db: AsyncSession = Depends(get_async_session),
 ):
     """Nth photo of a venue. Google API key stays server-side."""
@@ -153,34 +306,39 @@ async def get_place_image(
             return None, None
         return await _fetch_remote(url)
 
-    return await _serve(request, f"place:{places_fk_id}:{n}", resolve)
+    return await _serve(
+        request, f"place:{places_fk_id}:{n}", resolve,
+        image_variants.snap_width(w), image_variants.normalize_format(fmt),
+    )
 
 
 @router.get("/user/{user_id}")
 async def get_user_image(
     user_id: int,
     request: Request,
+    w: Optional[int] = None,
+    fmt: Optional[str] = None,
     db: AsyncSession = Depends(get_async_session),
 ):
-    """Profile picture as a real, cacheable image — whether it's stored as a
-    base64 data URI, a relative upload path, or a remote URL."""
+    """Profile picture as a real, cacheable image — whether it's a blob ref,
+    a legacy base64 data URI, a relative upload path, or a remote URL."""
+    result = await db.execute(
+        select(User.profile_picture_1, User.profile_picture, User.instagram_profile_pic)
+        .where(User.id == user_id)
+    )
+    row = result.first()
+    pic = (row[0] or row[1] or row[2]) if row else None
+    width, fmt = image_variants.snap_width(w), image_variants.normalize_format(fmt)
+    if blob_store.is_blob_ref(pic):
+        return await _serve_blob(request, blob_store.name_from_ref(pic), width, fmt, USER_BLOB_CACHE_CONTROL)
 
     async def resolve():
-        result = await db.execute(select(User).where(User.id == user_id))
-        user = result.scalar_one_or_none()
-        if not user:
-            return None, None
-        pic = (
-            user.profile_picture_1
-            or user.profile_picture
-            or user.instagram_profile_pic
-        )
         if not pic:
             return None, None
         if pic.startswith("data:"):
-            return _parse_data_uri(pic)
+            return blob_store.parse_data_uri(pic)
         if pic.startswith("http"):
             return await _fetch_remote(pic)
         return None, None
 
-    return await _serve(request, f"user:{user_id}", resolve)
+    return await _serve(request, f"user:{user_id}", resolve, width, fmt)
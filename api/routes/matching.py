@@ -76,7 +76,7 @@ async def people_here(
     model = await get_matching_model(db)
     occupants = await get_active_occupants(db, CHECKIN_EXPIRY_HOURS)
     candidates = [u for u in occupants.get(target, []) if u != current_user.id]
-    ranked = rank_people(model, current_user.id, candidates)[:limit]
+    ranked = rank_people(model, current_user.id, candidates, limit=limit)
 
     users = {}
     if ranked:
@@ -1,10 +1,12 @@
 from fastapi import APIRouter, Depends, HTTPException
 from sqlalchemy.ext.asyncio import AsyncSession
-from sqlalchemy import select, func, or_
+from sqlalchemy import select, func, or_, update, case, tuple_
+from sqlalchemy.orm.attributes import set_committed_value
 from pydantic import BaseModel, Field
 from typing import Optional, List, Dict, Any
 from datetime import datetime, timezone
 from collections import defaultdict
+import json
 import logging
 
 from db.database import get_async_session
@@ -17,6 +19,8 @@ router = APIRouter(prefix="/messages", tags=["messages"])
 logger = logging.getLogger(__name__)
 
 MAX_MESSAGE_LENGTH = 2000
+INBOX_PAGE_SIZE = 100
+INBOX_MAX_PAGE_SIZE = 200
 ALLOWED_REACTIONS = {"❤️", "😂", "😮", "😢", "🔥", "👍", "👎", "🎉"}
 
 
@@ -74,6 +78,15 @@ def _is_participant(conversation: Conversation, user_id: int) -> bool:
     return user_id in (conversation.user1_id, conversation.user2_id)
 
 
+def _participant_filter(user_id: int):
+    return or_(Conversation.user1_id == user_id, Conversation.user2_id == user_id)
+
+
+def _unread_column(conversation: Conversation, user_id: int) -> str:
+    """Name of the counter holding user_id's unread messages in this conversation."""
+    return "user1_unread" if conversation.user1_id == user_id else "user2_unread"
+
+
 # ---------------------------------------------------------------------------
 # Serialization
 # ---------------------------------------------------------------------------
@@ -167,69 +180,131 @@ async def _serialize_one(db: AsyncSession, message: DirectMessage) -> dict:
     return (await _serialize_messages(db, [message]))[0]
 
 
+# ---------------------------------------------------------------------------
+# Denormalized inbox (Conversation.last_message_* / user*_unread)
+# ---------------------------------------------------------------------------
+
+async def _set_snapshot(db: AsyncSession, conversation_id: int, message_id: int, serialized: dict):
+    """Point the conversation's preview at message_id unless a newer one is there
+    already (concurrent sends may commit out of order)."""
+    await db.execute(
+        update(Conversation)
+        .where(
+            Conversation.id == conversation_id,
+            or_(Conversation.last_message_id.is_(None), Conversation.last_message_id <= message_id)
+        )
+        .values(last_message_id=message_id, last_message_snapshot=json.dumps(serialized))
+    )
+
+
+async def _refresh_snapshot_if_last(db: AsyncSession, conversation: Conversation, message: DirectMessage):
+    """Re-serialize the preview after a reaction / unsend / read touched it."""
+    if conversation.last_message_id == message.id:
+        await _set_snapshot(db, conversation.id, message.id, await _serialize_one(db, message))
+
+
+async def _backfill_inbox(db: AsyncSession, conversations: List[Conversation]):
+    """Fill snapshot / unread columns on rows that predate them, then commit.
+    Runs once per old conversation; afterwards reads never touch messages."""
+    missing_snapshot = [c for c in conversations if c.last_message_snapshot is None]
+    missing_unread = [c for c in conversations if c.user1_unread is None or c.user2_unread is None]
+    if not missing_snapshot and not missing_unread:
+        return
+
+    if missing_snapshot:
+        by_id = {c.id: c for c in missing_snapshot}
+        last_msg_result = await db.execute(
+            select(DirectMessage).where(
+                DirectMessage.id.in_(
+                    select(func.max(DirectMessage.id))
+                    .where(DirectMessage.conversation_id.in_(list(by_id)))
+                    .group_by(DirectMessage.conversation_id)
+                )
+            )
+        )
+        last_messages = list(last_msg_result.scalars().all())
+        for m, d in zip(last_messages, await _serialize_messages(db, last_messages)):
+            await _set_snapshot(db, m.conversation_id, m.id, d)
+            # The UPDATE above did the write; just reflect it on the loaded row
+            set_committed_value(by_id[m.conversation_id], "last_message_id", m.id)
+            set_committed_value(by_id[m.conversation_id], "last_message_snapshot", json.dumps(d))
+
+    if missing_unread:
+        counts_result = await db.execute(
+            select(DirectMessage.conversation_id, DirectMessage.sender_id, func.count(DirectMessage.id))
+            .where(
+                DirectMessage.conversation_id.in_([c.id for c in missing_unread]),
+                DirectMessage.read_at.is_(None),
+                DirectMessage.deleted_at.is_(None)
+            )
+            .group_by(DirectMessage.conversation_id, DirectMessage.sender_id)
+        )
+        counts = {(cid, sender): n for cid, sender, n in counts_result.all()}
+        for c in missing_unread:
+            # Each side's unread = the other side's unread, undeleted messages
+            user1_unread = counts.get((c.id, c.user2_id), 0)
+            user2_unread = counts.get((c.id, c.user1_id), 0)
+            await db.execute(
+                update(Conversation)
+                .where(
+                    Conversation.id == c.id,
+                    or_(Conversation.user1_unread.is_(None), Conversation.user2_unread.is_(None))
+                )
+                .values(user1_unread=user1_unread, user2_unread=user2_unread)
+            )
+            set_committed_value(c, "user1_unread", user1_unread)
+            set_committed_value(c, "user2_unread", user2_unread)
+    await db.commit()
+
+
 # ---------------------------------------------------------------------------
 # Conversations
 # ---------------------------------------------------------------------------
 
 @router.get("/conversations", response_model=List[ConversationResponse])
 async def get_conversations(
+    before_at: Optional[datetime] = None,
+    before_id: Optional[int] = None,
+    limit: int = INBOX_PAGE_SIZE,
     current_user: User = Depends(get_current_user),
     db: AsyncSession = Depends(get_async_session)
 ):
-    """All conversations for the current user, most recent first, with unread counts."""
-    result = await db.execute(
-        select(Conversation).where(
-            or_(
-                Conversation.user1_id == current_user.id,
-                Conversation.user2_id == current_user.id
+    """Conversations for the current user, most recent first, with unread counts.
+
+    One indexed range read over the denormalized preview + counters. Page with
+    before_at / before_id = the last row's last_message_at / conversation_id.
+    """
+    limit = min(max(limit, 1), INBOX_MAX_PAGE_SIZE)
+    query = select(Conversation).where(_participant_filter(current_user.id))
+    if before_at is not None:
+        if before_id is not None:
+            query = query.where(
+                tuple_(Conversation.last_message_at, Conversation.id) < tuple_(before_at, before_id)
             )
-        ).order_by(Conversation.last_message_at.desc())
+        else:
+            query = query.where(Conversation.last_message_at < before_at)
+    result = await db.execute(
+        query.order_by(Conversation.last_message_at.desc(), Conversation.id.desc()).limit(limit)
     )
     conversations = result.scalars().all()
     if not conversations:
         return []
 
-    conversation_ids = [c.id for c in conversations]
-
-    last_msg_result = await db.execute(
-        select(DirectMessage).where(
-            DirectMessage.id.in_(
-                select(func.max(DirectMessage.id))
-                .where(DirectMessage.conversation_id.in_(conversation_ids))
-                .group_by(DirectMessage.conversation_id)
-            )
-        )
-    )
-    last_messages = {m.conversation_id: m for m in last_msg_result.scalars().all()}
-    serialized_last = {
-        m.conversation_id: d
-        for m, d in zip(
-            last_messages.values(),
-            await _serialize_messages(db, list(last_messages.values()))
-        )
-    }
-
-    unread_result = await db.execute(
-        select(DirectMessage.conversation_id, func.count(DirectMessage.id))
-        .where(
-            DirectMessage.conversation_id.in_(conversation_ids),
-            DirectMessage.sender_id != current_user.id,
-            DirectMessage.read_at.is_(None),
-            DirectMessage.deleted_at.is_(None)
-        )
-        .group_by(DirectMessage.conversation_id)
-    )
-    unread_counts = dict(unread_result.all())
+    await _backfill_inbox(db, conversations)
 
     other_ids = [_other_user_id(c, current_user.id) for c in conversations]
-    users_result = await db.execute(select(User).where(User.id.in_(other_ids)))
-    users = {u.id: u for u in users_result.scalars().all()}
+    users_result = await db.execute(
+        select(User.id, User.nickname, User.first_name, User.profile_picture, User.instagram_profile_pic)
+        .where(User.id.in_(other_ids))
+    )
+    users = {u.id: u for u in users_result.all()}
 
     out = []
     for conversation in conversations:
         other = users.get(_other_user_id(conversation, current_user.id))
         if not other:
             continue
+        snapshot = conversation.last_message_snapshot
         out.append(ConversationResponse(
             conversation_id=conversation.id,
             other_user=ConversationUser(
@@ -238,8 +313,8 @@ async def get_conversations(
                 first_name=other.first_name,
                 profile_picture=other.profile_picture or other.instagram_profile_pic,
             ),
-            last_message=serialized_last.get(conversation.id),
-            unread_count=unread_counts.get(conversation.id, 0),
+            last_message=json.loads(snapshot) if snapshot else None,
+            unread_count=getattr(conversation, _unread_column(conversation, current_user.id)) or 0,
             last_message_at=conversation.last_message_at,
         ))
     return out
@@ -348,11 +423,21 @@ async def send_message(
         bounce_id=bounce_id,
     )
     db.add(message)
-    conversation.last_message_at = datetime.now(timezone.utc)
-    await db.commit()
+    await db.flush()
     await db.refresh(message)
-
     serialized = await _serialize_one(db, message)
+
+    # Inbox: bump the recipient's counter (NULL = not backfilled yet, stays NULL)
+    # and move the preview, in the same transaction as the message
+    unread = _unread_column(conversation, user_id)
+    await db.execute(
+        update(Conversation)
+        .where(Conversation.id == conversation.id)
+        .values({"last_message_at": datetime.now(timezone.utc), unread: getattr(Conversation, unread) + 1})
+    )
+    await _set_snapshot(db, conversation.id, message.id, serialized)
+    await db.commit()
+
     sender_name = current_user.nickname or current_user.first_name or "Someone"
     sender_pic = current_user.profile_picture or current_user.instagram_profile_pic
 
@@ -436,6 +521,8 @@ async def react_to_message(
         db.add(DirectMessageReaction(
             message_id=message_id, user_id=current_user.id, emoji=body.emoji
         ))
+    await db.flush()
+    await _refresh_snapshot_if_last(db, conversation, message)
     await db.commit()
 
     await ws_manager.send_to_user(_other_user_id(conversation, current_user.id), {
@@ -466,6 +553,8 @@ async def remove_reaction(
     reaction = result.scalar_one_or_none()
     if reaction:
         await db.delete(reaction)
+        await db.flush()
+        await _refresh_snapshot_if_last(db, conversation, message)
         await db.commit()
 
     await ws_manager.send_to_user(_other_user_id(conversation, current_user.id), {
@@ -495,6 +584,15 @@ async def unsend_message(
 
     if message.deleted_at is None:
         message.deleted_at = datetime.now(timezone.utc)
+        if message.read_at is None:
+            unread = _unread_column(conversation, _other_user_id(conversation, current_user.id))
+            await db.execute(
+                update(Conversation)
+                .where(Conversation.id == conversation.id, getattr(Conversation, unread) > 0)
+                .values({unread: getattr(Conversation, unread) - 1})
+            )
+        await db.flush()
+        await _refresh_snapshot_if_last(db, conversation, message)
         await db.commit()
 
     await ws_manager.send_to_user(_other_user_id(conversation, current_user.id), {
@@ -540,6 +638,25 @@ async def mark_read(
     unread = unread_result.scalars().all()
     for message in unread:
         message.read_at = now
+    await db.flush()
+
+    # Recount rather than decrement: exact, and heals any drift in the counter
+    remaining_result = await db.execute(
+        select(func.count(DirectMessage.id)).where(
+            DirectMessage.conversation_id == conversation_id,
+            DirectMessage.sender_id != current_user.id,
+            DirectMessage.read_at.is_(None),
+            DirectMessage.deleted_at.is_(None)
+        )
+    )
+    await db.execute(
+        update(Conversation)
+        .where(Conversation.id == conversation_id)
+        .values({_unread_column(conversation, current_user.id): remaining_result.scalar() or 0})
+    )
+    last = next((m for m in unread if m.id == conversation.last_message_id), None)
+    if last is not None:
+        await _refresh_snapshot_if_last(db, conversation, last)
     await db.commit()
 
     if unread:
@@ -560,17 +677,18 @@ async def get_unread_count(
     db: AsyncSession = Depends(get_async_session)
 ):
     """Total unread DMs across all conversations (for the tab badge)."""
+    mine = case(
+        (Conversation.user1_id == current_user.id, Conversation.user1_unread),
+        else_=Conversation.user2_unread,
+    )
+    pending_result = await db.execute(
+        select(Conversation).where(_participant_filter(current_user.id), mine.is_(None))
+    )
+    pending = pending_result.scalars().all()
+    if pending:
+        await _backfill_inbox(db, pending)
+
     result = await db.execute(
-        select(func.count(DirectMessage.id))
-        .join(Conversation, DirectMessage.conversation_id == Conversation.id)
-        .where(
-            or_(
-                Conversation.user1_id == current_user.id,
-                Conversation.user2_id == current_user.id
-            ),
-            DirectMessage.sender_id != current_user.id,
-            DirectMessage.read_at.is_(None),
-            DirectMessage.deleted_at.is_(None)
-        )
+        select(func.coalesce(func.sum(mine), 0)).where(_participant_filter(current_user.id))
     )
     return {"unread_count": result.scalar() or 0}
@@ -242,7 +242,10 @@ async def test_push_notification(
         return diagnostics
 
     # 2. Check device tokens
-    tokens = await apns._get_user_tokens(db, current_user.id, NotificationType.BOUNCE_INVITE)
+    result = await db.execute(
+        select(DeviceToken).where(DeviceToken.user_id == current_user.id, DeviceToken.is_active == True)
+    )
+    tokens = result.scalars().all()
     diagnostics["active_tokens"] = len(tokens)
     diagnostics["tokens"] = [
         {"token": t.device_token[:20] + "...", "sandbox": t.is_sandbox, "active": t.is_active}
@@ -275,7 +278,7 @@ async def test_push_notification(
 
     results = []
     for token in tokens:
-        sent, error = await apns._send_to_token(token.device_token, token.is_sandbox, aps_payload)
+        sent, error = await apns._send_to_token(token.device_token, aps_payload)
         results.append({"token": token.device_token[:20] + "...", "sent": sent, "error": error})
     diagnostics["send_results"] = results
 
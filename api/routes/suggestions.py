@@ -50,5 +50,6 @@ async def get_model_info(
         "interactions": model.n_interactions,
         "ranker_learned": model.ranker_learned,
         "network_walk_enabled": model.W_joint is not None,
+        "candidate_index": model.mf_index.kind,
         "eval": model.metrics,
     }
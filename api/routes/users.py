@@ -1,28 +1,31 @@
 from fastapi import APIRouter, Depends, HTTPException, UploadFile, File, Request, Query
 from sqlalchemy.ext.asyncio import AsyncSession
-from sqlalchemy import select, delete, or_, func
+from sqlalchemy import select, delete, and_, or_, func
+from sqlalchemy.orm import aliased
 from pydantic import BaseModel
 from typing import Optional, List, Literal
 import aiofiles
+import asyncio
 from pathlib import Path
 import uuid
 import os
 import hashlib
 import logging
-import base64
 from datetime import datetime, timezone
 from math import radians, cos, sin, asin, sqrt
 
-from db.database import get_async_session
+from db.database import get_async_session, get_read_session
 from db.models import User, Follow, FollowRequest, RefreshToken, DeviceToken, NotificationPreference, CheckIn
-from api.dependencies import get_current_user, limiter
+from api.dependencies import get_current_user, get_loaders, limiter
 from core.config import settings
 from api.routes.websocket import manager as ws_manager
 from services.geofence import haversine_distance
 from services.cache import cache_get, cache_set, cache_delete
-from services.redis import get_redis
 from services.tasks import enqueue_notification, payload_to_dict
 from api.routes.checkins import auto_checkout_if_needed
+from services.loaders import Loaders
+from services.location_store import record_location
+from services.blob_store import put_image
 from services.instagram import fetch_instagram_profile
 import re
 
@@ -505,7 +508,8 @@ async def upload_profile_picture(
     current_user: User = Depends(get_current_user),
     db: AsyncSession = Depends(get_async_session)
 ):
-    """Upload profile picture to a specific slot (1, 2, or 3). Stored as base64 in database."""
+    """Upload profile picture to a specific slot (1, 2, or 3). Bytes go to the blob
+    store; the row keeps the /img/blob/... ref."""
     # Validate file type
     allowed_types = ["image/jpeg", "image/jpg", "image/png", "image/webp"]
     if file.content_type not in allowed_types:
@@ -519,24 +523,23 @@ async def upload_profile_picture(
             detail=f"File size exceeds maximum allowed size of {settings.MAX_FILE_SIZE} bytes"
         )
 
-    # Encode to base64 with data URI prefix
     content_type = file.content_type or "image/jpeg"
-    base64_data = base64.b64encode(content).decode('utf-8')
-    data_uri = f"data:{content_type};base64,{base64_data}"
+    ref = await put_image(content, content_type)
 
     # Store in the appropriate slot
     if slot == 1:
-        current_user.profile_picture_1 = data_uri
+        current_user.profile_picture_1 = ref
     elif slot == 2:
-        current_user.profile_picture_2 = data_uri
+        current_user.profile_picture_2 = ref
     else:
-        current_user.profile_picture_3 = data_uri
+        current_user.profile_picture_3 = ref
 
     await db.commit()
 
     return {
         "success": True,
         "slot": slot,
+        "url": ref,
         "message": f"Profile picture uploaded to slot {slot}"
     }
 
@@ -725,8 +728,12 @@ async def unfollow_user(
             return {"status": "request_cancelled"}
         raise HTTPException(status_code=404, detail="Not following this user")
 
+    was_sharing = follow.is_sharing_location
     await db.delete(follow)
     await db.commit()
+    if was_sharing:
+        from services.silent_push import refresh_sharer
+        await refresh_sharer(db, current_user.id)
 
     # Invalidate cache for both users' stats
     await cache_delete(f"user_stats:{user_id}")
@@ -875,7 +882,7 @@ async def decline_follow_request(
 @router.get("/me/following", response_model=List[SimpleUserResponse])
 async def get_following(
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get list of users current user is following"""
     result = await db.execute(
@@ -901,7 +908,7 @@ async def get_following(
 @router.get("/me/followers", response_model=List[SimpleUserResponse])
 async def get_followers(
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get list of users following current user"""
     result = await db.execute(
@@ -928,7 +935,7 @@ async def get_followers(
 async def get_user_following(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get list of users that a specific user is following"""
     # Verify user exists
@@ -971,7 +978,7 @@ async def get_user_following(
 async def get_user_followers(
     user_id: int,
     current_user: User = Depends(get_current_user),
-    db: AsyncSession = Depends(get_async_session)
+    db: AsyncSession = Depends(get_read_session)
 ):
     """Get list of users following a specific user"""
     # Verify user exists
@@ -1014,7 +1021,8 @@ async def get_user_followers(
 async def get_user_profile(
     user_id: int,
     db: AsyncSession = Depends(get_async_session),
-    current_user: User = Depends(get_current_user)
+    current_user: User = Depends(get_current_user),
+    loaders: Loaders = Depends(get_loaders)
 ):
     """
     Get another user's profile with privacy controls and stats.
@@ -1025,8 +1033,11 @@ async def get_user_profile(
 
     Returns posts count, followers count, following count, and follow state.
     """
-    result = await db.execute(select(User).where(User.id == user_id))
-    user = result.scalar_one_or_none()
+    # The user and both follow edges resolve together (two queries, not three)
+    user, (follow_record, reverse_follow) = await asyncio.gather(
+        loaders.users.load(user_id),
+        loaders.follow_pair(current_user.id, user_id),
+    )
 
     if not user:
         raise HTTPException(status_code=404, detail="User not found")
@@ -1057,25 +1068,10 @@ async def get_user_profile(
             "following": following_count
         }, ttl=300)
 
-    # Check if current user follows this user (and get close friend status)
-    follow_check = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == current_user.id,
-            Follow.following_id == user_id
-        )
-    )
-    follow_record = follow_check.scalar_one_or_none()
+    # Follow state (and close friend status), mutual check
     is_followed = follow_record is not None
     is_close_friend = follow_record.is_close_friend if follow_record else False
-
-    # Check if this user follows current user (mutual check)
-    reverse_follow_check = await db.execute(
-        select(Follow).where(
-            Follow.follower_id == user_id,
-            Follow.following_id == current_user.id
-        )
-    )
-    is_mutual = is_followed and reverse_follow_check.scalar_one_or_none() is not None
+    is_mutual = is_followed and reverse_follow is not None
 
     # Conditional privacy: only show phone/email to geolocated users
     can_see_private = current_user.can_post  # Geolocated at Art Basel Miami
@@ -1134,19 +1130,20 @@ async def update_location(
 
     city, distance_km = nearest_launch_city(location.latitude, location.longitude)
 
-    # Update user location
-    current_user.last_location_lat = location.latitude
-    current_user.last_location_lon = location.longitude
-    current_user.last_location_update = datetime.now(timezone.utc)
-
-    # Check if within the nearest city's geofence
+    # Check if within the nearest city's geofence (rarely flips — only then touch the row)
     can_post = distance_km <= city["radius_km"]
-    current_user.can_post = can_post
-
-    await db.commit()
+    if current_user.can_post != can_post:
+        current_user.can_post = can_post
+        await db.commit()
 
-    # Auto-checkout from venue if user has moved far enough away
-    await auto_checkout_if_needed(db, current_user.id, location.latitude, location.longitude)
+    # Position goes through the write-behind buffer; its flusher also runs
+    # auto-checkout. Without Redis, write the row and check out inline.
+    if not await record_location(current_user.id, location.latitude, location.longitude):
+        current_user.last_location_lat = location.latitude
+        current_user.last_location_lon = location.longitude
+        current_user.last_location_update = datetime.now(timezone.utc)
+        await db.commit()
+        await auto_checkout_if_needed(db, current_user.id, location.latitude, location.longitude)
 
     city_label = city["name"].title()
     if can_post:
@@ -1176,15 +1173,14 @@ async def heartbeat(
 ):
     """
     Location heartbeat — called every ~30s by the iOS app.
-    Updates the user's last known position and sets a Redis online flag with 90s TTL.
+    Buffers the user's last known position (services/location_store.py) and
+    sets a Redis online flag with 90s TTL, in one pipeline.
     """
-    current_user.last_location_lat = data.latitude
-    current_user.last_location_lon = data.longitude
-    current_user.last_location_update = datetime.now(timezone.utc)
-    await db.commit()
-
-    r = await get_redis()
-    await r.set(f"user:alive:{current_user.id}", "1", ex=90)
+    if not await record_location(current_user.id, data.latitude, data.longitude, alive_ttl=90):
+        current_user.last_location_lat = data.latitude
+        current_user.last_location_lon = data.longitude
+        current_user.last_location_update = datetime.now(timezone.utc)
+        await db.commit()
 
 
 @router.delete("/me", response_model=DeleteAccountResponse)
@@ -1252,11 +1248,11 @@ async def delete_account(
         )
         active_checkin = checkin_result.scalar_one_or_none()
         if active_checkin:
-            # Broadcast checkout to all connected clients before deleting
-            await ws_manager.broadcast({
+            # Checkout goes to clients around the venue before deleting
+            await ws_manager.publish_geo(active_checkin.latitude, active_checkin.longitude, {
                 "type": "venue_checkout",
                 "place_id": active_checkin.place_id,
-                "venue_name": active_checkin.venue_name,
+                "venue_name": active_checkin.location_name,
                 "user_id": current_user.id,
                 "nickname": current_user.nickname,
                 "timestamp": datetime.now(timezone.utc).isoformat()
@@ -1419,6 +1415,38 @@ async def qr_connect(
     )
 
 
+SEARCH_SOCIAL_CANDIDATES = 50
+THUMBNAIL_WIDTH = 96
+
+# Both columns have a C-collation expression index (db/database.py), so a
+# prefix becomes a btree range scan that stops after `limit` rows in order
+_nickname_key = func.lower(User.nickname).collate("C")
+_instagram_key = func.lower(User.instagram_handle).collate("C")
+
+
+def _prefix_range(key, prefix: str):
+    """key LIKE 'prefix%' as a range: index-friendly even as a bound
+    parameter, and `_` in nicknames needs no escaping."""
+    # Successor of the last code point that has one: U+10FFFF has none (drop
+    # it and carry), and the one after U+D7FF skips the surrogate block
+    stem = prefix.rstrip("\U0010ffff")
+    if not stem:
+        return key >= prefix
+    nxt = ord(stem[-1]) + 1
+    upper = stem[:-1] + chr(0xE000 if 0xD800 <= nxt <= 0xDFFF else nxt)
+    return and_(key >= prefix, key < upper)
+
+
+def _search_columns():
+    has_picture = or_(
+        User.profile_picture_1.isnot(None),
+        User.profile_picture.isnot(None),
+        User.instagram_profile_pic.isnot(None),
+    ).label("has_picture")
+    return (User.id, User.nickname, User.first_name, User.last_name,
+            User.instagram_handle, has_picture)
+
+
 @router.get("/search", response_model=UserSearchResponse)
 async def search_users(
     q: str,
@@ -1430,7 +1458,10 @@ async def search_users(
     Search users by nickname or Instagram handle for autocomplete.
 
     Designed for debounce-style search - returns matches as user types.
-    Returns profile pictures for display in autocomplete dropdown.
+    Mutuals rank first, then people you follow, then everyone else; exact
+    matches and shorter names first within each group. Only the columns the
+    dropdown shows are read: profile_picture is an /img/user thumbnail URL,
+    never the stored picture.
 
     Parameters:
     - q: Search query (min 1 character). Searches both nickname and Instagram handle.
@@ -1447,31 +1478,42 @@ async def search_users(
     # Cap limit to prevent abuse
     limit = min(limit, 50)
 
-    # Search for users matching nickname or instagram_handle (case-insensitive prefix match)
-    # Uses ILIKE for case-insensitive matching with wildcard suffix for autocomplete
-    search_pattern = f"{query}%"
+    matches = or_(_prefix_range(_nickname_key, query), _prefix_range(_instagram_key, query))
+    cols = _search_columns()
+
+    # People the current user follows (small set via the follows index), with
+    # the reverse edge marking mutuals
+    reverse = aliased(Follow)
+    social = await db.execute(
+        select(*cols, reverse.id.isnot(None).label("mutual"))
+        .select_from(User)
+        .join(Follow, and_(Follow.following_id == User.id, Follow.follower_id == current_user.id))
+        .outerjoin(reverse, and_(reverse.follower_id == User.id, reverse.following_id == current_user.id))
+        .where(User.is_active == True, matches)
+        .limit(SEARCH_SOCIAL_CANDIDATES)
+    )
+    rows = {row.id: (0 if row.mutual else 1, row) for row in social.all()}
 
-    result = await db.execute(
-        select(User)
-        .where(
-            User.is_active == True,
-            User.id != current_user.id,  # Exclude current user
-            or_(
-                func.lower(User.nickname).like(search_pattern),
-                func.lower(User.instagram_handle).like(search_pattern)
-            )
-        )
-        .order_by(
-            # Prioritize exact matches, then prefix matches
-            func.length(User.nickname).asc()
+    # Everyone else: one ordered range scan per indexed column
+    for key in (_nickname_key, _instagram_key):
+        result = await db.execute(
+            select(*cols)
+            .where(User.is_active == True, User.id != current_user.id, _prefix_range(key, query))
+            .order_by(key)
+            .limit(limit)
         )
-        .limit(limit)
-    )
-    users = result.scalars().all()
+        for row in result.all():
+            rows.setdefault(row.id, (2, row))
+
+    def rank(item):
+        group, row = item
+        nickname_lower = (row.nickname or "").lower()
+        exact = query in (nickname_lower, (row.instagram_handle or "").lower())
+        return (group, not exact, len(nickname_lower), row.id)
 
     # Build results with match type indicator
     search_results = []
-    for user in users:
+    for _, user in sorted(rows.values(), key=rank)[:limit]:
         # Determine which field matched
         nickname_lower = (user.nickname or "").lower()
         instagram_lower = (user.instagram_handle or "").lower()
@@ -1488,7 +1530,7 @@ async def search_users(
             nickname=user.nickname,
             first_name=user.first_name,
             last_name=user.last_name,
-            profile_picture=user.profile_picture or user.instagram_profile_pic,
+            profile_picture=f"/img/user/{user.id}?w={THUMBNAIL_WIDTH}" if user.has_picture else None,
             instagram_handle=user.instagram_handle,
             match_type=match_type
         ))
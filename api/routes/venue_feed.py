@@ -1,4 +1,4 @@
-from fastapi import APIRouter, Depends, HTTPException, WebSocket, WebSocketDisconnect, Query, UploadFile, File, Form
+from fastapi import APIRouter, Depends, HTTPException, WebSocket, WebSocketDisconnect, Query, UploadFile, File, Form, Response
 from sqlalchemy.ext.asyncio import AsyncSession
 from sqlalchemy import select, and_, desc
 from pydantic import BaseModel
@@ -6,16 +6,16 @@ from typing import List, Optional
 from datetime import datetime, timezone, timedelta
 from uuid import uuid4
 import asyncio
-import base64
 import json
 import logging
-import httpx
 
 from db.database import get_async_session, create_async_session
 from db.models import VenueFeedMessage, CheckIn, User, Place
 from api.dependencies import get_current_user
 from api.routes.websocket import manager
 from api.routes.checkins import CHECKIN_EXPIRY_HOURS
+from services import venue_feed_ring
+from services.blob_store import put_image
 from core.config import settings
 
 logger = logging.getLogger(__name__)
@@ -65,13 +65,16 @@ async def enforce_post_rate(db: AsyncSession, user_id: int, place_id: str):
 
 
 def _format_message(msg: VenueFeedMessage, user: User, ws_safe: bool = False) -> dict:
-    """Format a feed message. When ws_safe=True, strip large base64 blobs."""
+    """Format a feed message. When ws_safe=True, no large base64 blobs: legacy
+    data URI images are stripped and data URI pictures become /img/user URLs
+    (blob refs are short and always included)."""
     image = msg.image
     profile_pic = user.profile_picture or user.instagram_profile_pic
     if ws_safe:
-        image = None
+        if image and image.startswith("data:"):
+            image = None
         if profile_pic and profile_pic.startswith("data:"):
-            profile_pic = None
+            profile_pic = f"/img/user/{user.id}"
     return {
         "id": msg.id,
         "place_id": msg.place_id,
@@ -108,6 +111,22 @@ class FeedResponse(BaseModel):
     has_more: bool
 
 
+def _ring_entry(msg: VenueFeedMessage, user: User) -> dict:
+    """What the hot-page ring stores: the FeedMessageResponse fields, blob-free."""
+    data = _format_message(msg, user, ws_safe=True)
+    return {k: data[k] for k in FeedMessageResponse.model_fields}
+
+
+async def _publish_message(msg: VenueFeedMessage, user: User) -> dict:
+    """Ring + resume log + live broadcast for a new message; returns the WS event."""
+    event = {"type": "venue_feed_message", **_format_message(msg, user, ws_safe=True)}
+    cursor = await venue_feed_ring.record_message(msg.place_id, _ring_entry(msg, user), event)
+    if cursor is not None:
+        event["cursor"] = cursor
+    await manager.send_to_venue_feed(msg.place_id, event)
+    return event
+
+
 @router.get("/{place_id}", response_model=FeedResponse)
 async def get_venue_feed(
     place_id: str,
@@ -116,7 +135,25 @@ async def get_venue_feed(
     current_user: User = Depends(get_current_user),
     db: AsyncSession = Depends(get_async_session),
 ):
-    """Read venue feed (paginated). Any authenticated user can read."""
+    """Read venue feed (paginated). Any authenticated user can read.
+
+    The first page comes pre-serialized from the venue's Redis ring
+    (services/venue_feed_ring.py); older pages and ring misses read Postgres.
+    """
+    # Weak implicit signal for the recommender
+    from services.recommendations import log_place_event
+    log_place_event(current_user.id, place_id, "feed_view")
+
+    gen = None
+    if before_id is None:
+        entries, gen = await venue_feed_ring.read_page(place_id, limit)
+        if entries is not None:
+            body = '{"place_id":%s,"messages":[%s],"has_more":%s}' % (
+                json.dumps(place_id), ",".join(entries[:limit]),
+                "true" if len(entries) > limit else "false",
+            )
+            return Response(content=body, media_type="application/json")
+
     query = (
         select(VenueFeedMessage, User)
         .join(User, VenueFeedMessage.user_id == User.id)
@@ -125,19 +162,24 @@ async def get_venue_feed(
     if before_id is not None:
         query = query.where(VenueFeedMessage.id < before_id)
 
-    query = query.order_by(desc(VenueFeedMessage.id)).limit(limit + 1)
+    # A first-page miss reads a whole ring's worth to refill it
+    fetch = venue_feed_ring.RING_SIZE if before_id is None else limit + 1
+    query = query.order_by(desc(VenueFeedMessage.id)).limit(fetch)
     result = await db.execute(query)
     rows = result.all()
 
+    # Legacy inline images can't go into the ring; those venues stay on SQL
+    # until scripts/migrate_images_to_blobs.py has run
+    if before_id is None and not any(msg.image and msg.image.startswith("data:") for msg, _ in rows):
+        await venue_feed_ring.fill(
+            place_id, [json.dumps(_ring_entry(msg, user)) for msg, user in rows], gen
+        )
+
     has_more = len(rows) > limit
     rows = rows[:limit]
 
     messages = [_format_message(msg, user) for msg, user in rows]
 
-    # Weak implicit signal for the recommender
-    from services.recommendations import log_place_event
-    log_place_event(current_user.id, place_id, "feed_view")
-
     return FeedResponse(place_id=place_id, messages=messages, has_more=has_more)
 
 
@@ -170,13 +212,12 @@ async def post_venue_message(
     await db.commit()
     await db.refresh(msg)
 
-    payload = {
-        "type": "venue_feed_message",
+    event = await _publish_message(msg, current_user)
+
+    return {
+        **event,
         **_format_message(msg, current_user),
     }
-    await manager.send_to_venue_feed(place_id, payload)
-
-    return payload
 
 
 @router.post("/{place_id}/image")
@@ -206,8 +247,7 @@ async def post_venue_image(
     await enforce_post_rate(db, current_user.id, place_id)
 
     content_type = image.content_type or "image/jpeg"
-    base64_data = base64.b64encode(content).decode("utf-8")
-    data_uri = f"data:{content_type};base64,{base64_data}"
+    image_ref = await put_image(content, content_type)
 
     place_result = await db.execute(select(Place).where(Place.place_id == place_id))
     place = place_result.scalar_one_or_none()
@@ -217,24 +257,15 @@ async def post_venue_image(
         places_fk_id=place.id if place else None,
         user_id=current_user.id,
         text=text.strip() if text else None,
-        image=data_uri,
+        image=image_ref,
     )
     db.add(msg)
     await db.commit()
     await db.refresh(msg)
 
-    # WS broadcast without image data (too large for WS frame)
-    ws_payload = {
-        "type": "venue_feed_message",
-        **_format_message(msg, current_user, ws_safe=True),
-    }
-    await manager.send_to_venue_feed(place_id, ws_payload)
-
-    # REST response — strip image (client already has it), just return metadata
-    return {
-        "type": "venue_feed_message",
-        **_format_message(msg, current_user, ws_safe=True),
-    }
+    # WS broadcast without image data (too large for WS frame); the REST
+    # response is the same metadata (client already has the image)
+    return await _publish_message(msg, current_user)
 
 
 # ---------- Delete ----------
@@ -260,11 +291,15 @@ async def delete_venue_message(
     await db.delete(msg)
     await db.commit()
 
-    await manager.send_to_venue_feed(place_id, {
+    event = {
         "type": "venue_feed_remove",
         "id": message_id,
         "place_id": place_id,
-    })
+    }
+    cursor = await venue_feed_ring.record_removal(place_id, event)
+    if cursor is not None:
+        event["cursor"] = cursor
+    await manager.send_to_venue_feed(place_id, event)
 
     return {"deleted": True, "message_id": message_id}
 
@@ -276,31 +311,12 @@ CATEGORIZE_PROMPT = """Categorize this reported social media message in one shor
 
 async def _groq_categorize(text: str):
     """Fire-and-forget: ask Groq to categorize a reported message. Returns category string."""
-    if not settings.GROQ_API_KEY:
-        return "uncategorized"
-    try:
-        async with httpx.AsyncClient(timeout=10) as client:
-            resp = await client.post(
-                "https://api.groq.com/openai/v1/chat/completions",
-                headers={
-                    "Authorization": f"Bearer {settings.GROQ_API_KEY}",
-                    "Content-Type": "application/json",
-                },
-                json={
-                    "model": "llama-3.1-8b-instant",
-                    "max_tokens": 20,
-                    "temperature": 0,
-                    "messages": [
-                        {"role": "system", "content": CATEGORIZE_PROMPT},
-                        {"role": "user", "content": text or "(image only, no text)"},
-                    ],
-                },
-            )
-            if resp.status_code == 200:
-                return resp.json()["choices"][0]["message"]["content"].strip()
-    except Exception as e:
-        logger.error(f"Groq categorize error: {e}")
-    return "uncategorized"
+    from services import llm
+    category = await llm.complete(
+        "moderation", CATEGORIZE_PROMPT, text or "(image only, no text)",
+        max_tokens=20, temperature=0, priority=llm.PRIORITY_BACKGROUND,
+    )
+    return category or "uncategorized"
 
 
 @router.post("/report/{message_id}")
@@ -338,12 +354,7 @@ async def report_message(
 
 # ---------- Live room: viewer presence + ephemeral reactions ----------
 
-from services.live_room import (
-    ReactionThrottle,
-    register_viewer,
-    unregister_viewer,
-    viewer_refresh_loop,
-)
+from services.live_room import ReactionThrottle, presence
 
 
 def _viewer_key(place_id: str) -> str:
@@ -365,11 +376,15 @@ async def venue_feed_websocket(
     websocket: WebSocket,
     place_id: str,
     token: str = Query(...),
+    cursor: Optional[int] = Query(None),
 ):
     """Real-time venue feed socket.
 
     Server -> client: venue_feed_message, venue_feed_remove, venue_checkin,
     venue_checkout, reaction, viewer_count.
+    Feed messages / removals carry a per-venue "cursor" ("connected" carries
+    the current one). Reconnect with ?cursor=<last seen> to receive what was
+    missed, or a "resync" frame when too much was (reload the first page).
     Client -> server: "ping" keepalive, or {"type": "reaction", "count": n}
     (ephemeral hearts — rate-limited, broadcast to the room, never stored).
     Posting messages stays REST.
@@ -399,24 +414,32 @@ async def venue_feed_websocket(
     await manager.connect_venue_feed(websocket, place_id)
     logger.debug(f"Venue feed WS connected: place_id={place_id} user={user_id}")
 
+    # Presence is batched per worker; the count is broadcast on its next tick
     conn_id = uuid4().hex
-    viewer_count = None
-    try:
-        viewer_count = await register_viewer(_viewer_key(place_id), conn_id)
-    except Exception as e:
-        logger.warning(f"Viewer register failed for {place_id}: {e}")
-
-    refresh_task = asyncio.create_task(viewer_refresh_loop(_viewer_key(place_id), conn_id))
+    viewer_count = presence.join(
+        _viewer_key(place_id), conn_id, lambda count: _broadcast_viewer_count(place_id, count)
+    )
     throttle = ReactionThrottle()
 
     try:
+        # Subscribed before reading the log, so nothing falls in between
+        # (an event may arrive twice; clients skip cursors they have seen)
+        missed = None
+        if cursor is not None:
+            missed, current = await venue_feed_ring.events_since(place_id, cursor)
+        else:
+            current = await venue_feed_ring.current_cursor(place_id)
         await websocket.send_json({
             "type": "connected",
             "place_id": place_id,
             "viewer_count": viewer_count,
+            "cursor": current,
         })
-        if viewer_count is not None:
-            await _broadcast_viewer_count(place_id, viewer_count)
+        if cursor is not None:
+            if missed is None:
+                await websocket.send_json({"type": "resync", "place_id": place_id})
+            for event in missed or []:
+                await websocket.send_json(event)
 
         while True:
             data = await websocket.receive_text()
@@ -445,10 +468,5 @@ async def venue_feed_websocket(
     except Exception as e:
         logger.error(f"Venue feed WS error for place_id={place_id}: {e}")
     finally:
-        refresh_task.cancel()
         manager.disconnect_venue_feed(websocket, place_id)
-        try:
-            count = await unregister_viewer(_viewer_key(place_id), conn_id)
-            await _broadcast_viewer_count(place_id, count)
-        except Exception as e:
-            logger.warning(f"Viewer unregister failed for {place_id}: {e}")
+        presence.leave(_viewer_key(place_id), conn_id)
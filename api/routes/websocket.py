@@ -3,81 +3,238 @@ from typing import List, Dict
 import asyncio
 import json
 import logging
+import time
+import zlib
 
+from core.config import settings
+from services.geohash import covering_cells, encode as geohash_encode
+from services.location_store import get_positions
+from services.metrics import observe_fanout
 from services.redis import get_redis
+from services.ws_fanout import FanoutStats, Outbox
 
 router = APIRouter(tags=["websocket"])
 logger = logging.getLogger(__name__)
 
 REDIS_CHANNEL_BROADCAST = "ws:broadcast"
-REDIS_CHANNEL_USER = "ws:user:{user_id}"
-REDIS_CHANNEL_BOUNCE = "ws:bounce:{bounce_id}"
-REDIS_CHANNEL_VENUE_FEED = "ws:venue_feed:{place_id}"
+REDIS_CHANNEL_SHARD = "ws:shard:{shard}"
+REDIS_CHANNEL_GEO = "ws:geo"  # "<cell>,<cell>,...\n<json payload>"
+
+# How often locally connected users' cells are re-read from the location buffer
+GEO_REFRESH_SECONDS = 30.0
+
+# Route keys carried in the shard envelope: "<kind>:<id>\n<json payload>"
+ROUTE_USER = "u"
+ROUTE_BOUNCE = "b"
+ROUTE_VENUE_FEED = "v"
+
+
+def shard_for(route_key: str) -> int:
+    """Stable across processes (unlike hash(), which is salted per process)."""
+    return zlib.crc32(route_key.encode()) % settings.WS_PUBSUB_SHARDS
 
 
 class ConnectionManager:
-    """WebSocket manager with Redis pub/sub for multi-instance support"""
+    """WebSocket manager with Redis pub/sub for multi-instance support.
+
+    Cross-instance messages go over a fixed set of WS_PUBSUB_SHARDS shard
+    channels instead of one channel per user/bounce/venue: a target id is
+    hashed to a shard, the payload is wrapped in a one-line route envelope,
+    and every instance runs one reader per shard that routes by id to its
+    local sockets (dropping messages for ids it doesn't hold). Subscriptions
+    are fixed at startup, so connects and disconnects never touch Redis.
+
+    Venue-scoped events (check-ins, checkouts, public bounces) go through
+    publish_geo instead of broadcast: each connected user is bucketed by the
+    geohash cell of their last heartbeat (refreshed from the location buffer)
+    and of the map viewport the client reports, and an event only reaches
+    users in the cells covering the venue and its neighbours. Users with no
+    known position yet get every geo event, as with broadcast.
+
+    Local delivery goes through services.ws_fanout: each socket has a bounded
+    Outbox, payloads are serialized once per fan-out (messages arriving over
+    pub/sub are forwarded as the raw JSON text), and slow consumers are
+    dropped/disconnected instead of blocking everyone behind them."""
 
     def __init__(self):
         self.active_connections: Dict[int, List[WebSocket]] = {}
         self.bounce_connections: Dict[int, List[WebSocket]] = {}  # bounce_id -> guest websockets
         self.venue_feed_connections: Dict[str, List[WebSocket]] = {}  # place_id -> websockets
-        self._subscriber_task: asyncio.Task | None = None
-        self._pubsub = None  # Redis pubsub instance for dynamic subscriptions
+        self._subscriber_tasks: List[asyncio.Task] = []
+        self._outboxes: Dict[WebSocket, Outbox] = {}
+        self.fanout_stats = FanoutStats()
+        self.pubsub_received = 0
+        self.pubsub_unrouted = 0  # shard messages for ids with no local sockets
+        # user_id -> cell, per source; _cell_users indexes their union
+        self._heartbeat_cell: Dict[int, str] = {}
+        self._viewport_cell: Dict[int, str] = {}
+        self._cell_users: Dict[str, set] = {}
+        self._user_cells: Dict[int, set] = {}
+        self._unlocated: set = set()
+        self._geo_refresh_task: asyncio.Task | None = None
+
+    def _open_outbox(self, websocket: WebSocket, on_dead):
+        self._outboxes[websocket] = Outbox(websocket, on_dead, self.fanout_stats)
+
+    def _close_outbox(self, websocket: WebSocket):
+        outbox = self._outboxes.pop(websocket, None)
+        if outbox is not None:
+            outbox.close()
+
+    def _fanout(self, kind: str, sockets: List[WebSocket], message) -> int:
+        """Serialize once and enqueue to every target without awaiting.
+        Returns how many sockets accepted the message."""
+        if not sockets:
+            return 0
+        text = message if isinstance(message, str) else json.dumps(message)
+        stats = self.fanout_stats.channel(kind)
+        stats.fanouts += 1
+        stats.recipients += len(sockets)
+        observe_fanout(kind, len(sockets))
+        now = time.perf_counter()
+        accepted = 0
+        for ws in list(sockets):
+            outbox = self._outboxes.get(ws)
+            if outbox is not None and outbox.offer(text, kind, now):
+                accepted += 1
+        return accepted
+
+    def stats(self) -> dict:
+        """Local connection counts + per-channel fan-out counters/latency."""
+        return {
+            "user_connections": sum(len(c) for c in self.active_connections.values()),
+            "users": len(self.active_connections),
+            "bounce_connections": sum(len(c) for c in self.bounce_connections.values()),
+            "venue_feed_connections": sum(len(c) for c in self.venue_feed_connections.values()),
+            "geo_cells": len(self._cell_users),
+            "unlocated_users": len(self._unlocated),
+            "pubsub": {
+                "shards": settings.WS_PUBSUB_SHARDS,
+                "readers": sum(1 for t in self._subscriber_tasks if not t.done()),
+                "received": self.pubsub_received,
+                "unrouted": self.pubsub_unrouted,
+            },
+            "channels": self.fanout_stats.snapshot(),
+        }
+
+    async def _publish_routed(self, route: str, target, message: dict):
+        """Publish `message` for one target id on its shard channel."""
+        route_key = f"{route}:{target}"
+        redis = await get_redis()
+        await redis.publish(
+            REDIS_CHANNEL_SHARD.format(shard=shard_for(route_key)),
+            f"{route_key}\n{json.dumps(message)}",
+        )
 
     async def connect(self, websocket: WebSocket, user_id: int):
         await websocket.accept()
+        self._open_outbox(websocket, lambda: self.disconnect(websocket, user_id))
         is_new_user = user_id not in self.active_connections
+        self.active_connections.setdefault(user_id, []).append(websocket)
         if is_new_user:
-            self.active_connections[user_id] = []
-        self.active_connections[user_id].append(websocket)
-
-        # Subscribe to user-specific channel if this is their first connection
-        if is_new_user and self._pubsub is not None:
+            self._reindex_geo(user_id)
             try:
-                channel = REDIS_CHANNEL_USER.format(user_id=user_id)
-                await self._pubsub.subscribe(channel)
-                logger.debug(f"Subscribed to Redis channel for user {user_id}")
-            except Exception as e:
-                logger.warning(f"Failed to subscribe to user channel: {e}")
+                asyncio.create_task(self._seed_cell(user_id))
+            except RuntimeError:
+                pass
 
     def disconnect(self, websocket: WebSocket, user_id: int):
+        self._close_outbox(websocket)
         if user_id in self.active_connections:
             if websocket in self.active_connections[user_id]:
                 self.active_connections[user_id].remove(websocket)
             if not self.active_connections[user_id]:
                 del self.active_connections[user_id]
-                # Unsubscribe from user channel when they have no more connections
-                if self._pubsub is not None:
-                    asyncio.create_task(self._unsubscribe_user(user_id))
+                self._heartbeat_cell.pop(user_id, None)
+                self._viewport_cell.pop(user_id, None)
+                self._reindex_geo(user_id)
+
+    # ---- geo topics ----
+
+    def _reindex_geo(self, user_id: int):
+        """Sync _cell_users / _unlocated with the user's current cells."""
+        for cell in self._user_cells.pop(user_id, ()):
+            users = self._cell_users.get(cell)
+            if users is not None:
+                users.discard(user_id)
+                if not users:
+                    del self._cell_users[cell]
+        self._unlocated.discard(user_id)
+        if user_id not in self.active_connections:
+            return
+        cells = {c for c in (self._heartbeat_cell.get(user_id), self._viewport_cell.get(user_id)) if c}
+        if not cells:
+            self._unlocated.add(user_id)
+            return
+        self._user_cells[user_id] = cells
+        for cell in cells:
+            self._cell_users.setdefault(cell, set()).add(user_id)
+
+    def set_viewport(self, user_id: int, lat: float, lon: float):
+        """Client-reported map center; sticks until the next one or disconnect."""
+        cell = geohash_encode(lat, lon)
+        if self._viewport_cell.get(user_id) != cell:
+            self._viewport_cell[user_id] = cell
+            self._reindex_geo(user_id)
+
+    def _set_heartbeat_cells(self, positions: dict):
+        for user_id, (lat, lon, _) in positions.items():
+            if user_id not in self.active_connections:
+                continue
+            cell = geohash_encode(lat, lon)
+            if self._heartbeat_cell.get(user_id) != cell:
+                self._heartbeat_cell[user_id] = cell
+                self._reindex_geo(user_id)
 
-    async def _unsubscribe_user(self, user_id: int):
-        """Unsubscribe from a user's Redis channel"""
+    async def _seed_cell(self, user_id: int):
+        self._set_heartbeat_cells(await get_positions([user_id]))
+
+    async def _geo_refresh_loop(self):
+        """Heartbeats may land on any worker; pick up moved users from Redis."""
+        while True:
+            try:
+                await asyncio.sleep(GEO_REFRESH_SECONDS)
+                if self.active_connections:
+                    self._set_heartbeat_cells(await get_positions(list(self.active_connections)))
+            except asyncio.CancelledError:
+                break
+            except Exception as e:
+                logger.warning(f"Geo cell refresh failed: {e}")
+
+    def _send_geo_local(self, cells, message: dict | str):
+        users = set(self._unlocated)
+        for cell in cells:
+            users |= self._cell_users.get(cell, set())
+        sockets = [ws for uid in users for ws in self.active_connections.get(uid, [])]
+        self._fanout("geo", sockets, message)
+
+    async def publish_geo(self, lat: float | None, lon: float | None, message: dict):
+        """Send a venue-scoped event to clients near (lat, lon) on all instances.
+        Without coordinates this degrades to broadcast."""
+        if lat is None or lon is None:
+            await self.broadcast(message)
+            return
+        cells = covering_cells(lat, lon)
         try:
-            channel = REDIS_CHANNEL_USER.format(user_id=user_id)
-            await self._pubsub.unsubscribe(channel)
-            logger.debug(f"Unsubscribed from Redis channel for user {user_id}")
+            redis = await get_redis()
+            await redis.publish(REDIS_CHANNEL_GEO, f"{','.join(cells)}\n{json.dumps(message)}")
         except Exception as e:
-            logger.warning(f"Failed to unsubscribe from user channel: {e}")
+            logger.warning(f"Redis publish_geo failed, falling back to local: {e}")
+            self._send_geo_local(cells, message)
 
-    async def _send_local(self, message: dict, user_id: int | None = None):
+    async def _send_local(self, message: dict | str, user_id: int | None = None):
         """Send to local connections only"""
-        dead_connections = []
-
         if user_id is not None:
-            connections_to_send = [(user_id, self.active_connections.get(user_id, []))]
-        else:
-            connections_to_send = list(self.active_connections.items())
-
-        for uid, connections in connections_to_send:
-            for connection in connections:
-                try:
-                    await connection.send_json(message)
-                except Exception:
-                    dead_connections.append((uid, connection))
+            self._fanout("user", self.active_connections.get(user_id, []), message)
+            return
+        sockets = [ws for conns in self.active_connections.values() for ws in conns]
+        self._fanout("broadcast", sockets, message)
 
-        for uid, connection in dead_connections:
-            self.disconnect(connection, uid)
+    def send_to_users_local(self, user_ids, message: dict) -> int:
+        """One serialization for several users' local connections."""
+        sockets = [ws for uid in dict.fromkeys(user_ids)
+                   for ws in self.active_connections.get(uid, [])]
+        return self._fanout("user", sockets, message)
 
     async def broadcast(self, message: dict):
         """Broadcast to all connected clients across all instances via Redis"""
@@ -91,9 +248,7 @@ class ConnectionManager:
     async def send_to_user(self, user_id: int, message: dict):
         """Send to specific user across all instances via Redis"""
         try:
-            redis = await get_redis()
-            channel = REDIS_CHANNEL_USER.format(user_id=user_id)
-            await redis.publish(channel, json.dumps(message))
+            await self._publish_routed(ROUTE_USER, user_id, message)
             return True
         except Exception as e:
             logger.warning(f"Redis send_to_user failed, falling back to local: {e}")
@@ -103,56 +258,26 @@ class ConnectionManager:
     async def connect_guest(self, websocket: WebSocket, bounce_id: int):
         """Accept and track a guest WebSocket for a bounce share page"""
         await websocket.accept()
-        is_new_bounce = bounce_id not in self.bounce_connections
-        if is_new_bounce:
-            self.bounce_connections[bounce_id] = []
-        self.bounce_connections[bounce_id].append(websocket)
-
-        # Subscribe to bounce channel if new
-        if is_new_bounce and self._pubsub is not None:
-            try:
-                channel = REDIS_CHANNEL_BOUNCE.format(bounce_id=bounce_id)
-                await self._pubsub.subscribe(channel)
-                logger.debug(f"Subscribed to Redis channel for bounce {bounce_id}")
-            except Exception as e:
-                logger.warning(f"Failed to subscribe to bounce channel: {e}")
+        self._open_outbox(websocket, lambda: self.disconnect_guest(websocket, bounce_id))
+        self.bounce_connections.setdefault(bounce_id, []).append(websocket)
 
     def disconnect_guest(self, websocket: WebSocket, bounce_id: int):
         """Remove a guest WebSocket from bounce tracking"""
+        self._close_outbox(websocket)
         if bounce_id in self.bounce_connections:
             if websocket in self.bounce_connections[bounce_id]:
                 self.bounce_connections[bounce_id].remove(websocket)
             if not self.bounce_connections[bounce_id]:
                 del self.bounce_connections[bounce_id]
-                if self._pubsub is not None:
-                    asyncio.create_task(self._unsubscribe_bounce(bounce_id))
 
-    async def _unsubscribe_bounce(self, bounce_id: int):
-        """Unsubscribe from a bounce's Redis channel"""
-        try:
-            channel = REDIS_CHANNEL_BOUNCE.format(bounce_id=bounce_id)
-            await self._pubsub.unsubscribe(channel)
-            logger.debug(f"Unsubscribed from Redis channel for bounce {bounce_id}")
-        except Exception as e:
-            logger.warning(f"Failed to unsubscribe from bounce channel: {e}")
-
-    async def _send_to_bounce_local(self, bounce_id: int, message: dict):
+    async def _send_to_bounce_local(self, bounce_id: int, message: dict | str):
         """Send to all local guest connections for a bounce"""
-        dead_connections = []
-        for ws in self.bounce_connections.get(bounce_id, []):
-            try:
-                await ws.send_json(message)
-            except Exception:
-                dead_connections.append(ws)
-        for ws in dead_connections:
-            self.disconnect_guest(ws, bounce_id)
+        self._fanout("bounce", self.bounce_connections.get(bounce_id, []), message)
 
     async def send_to_bounce(self, bounce_id: int, message: dict):
         """Send to all guest WebSockets for a bounce across all instances via Redis"""
         try:
-            redis = await get_redis()
-            channel = REDIS_CHANNEL_BOUNCE.format(bounce_id=bounce_id)
-            await redis.publish(channel, json.dumps(message))
+            await self._publish_routed(ROUTE_BOUNCE, bounce_id, message)
         except Exception as e:
             logger.warning(f"Redis send_to_bounce failed, falling back to local: {e}")
             await self._send_to_bounce_local(bounce_id, message)
@@ -162,114 +287,106 @@ class ConnectionManager:
     async def connect_venue_feed(self, websocket: WebSocket, place_id: str):
         """Accept and track a WebSocket for a venue feed"""
         await websocket.accept()
-        is_new = place_id not in self.venue_feed_connections
-        if is_new:
-            self.venue_feed_connections[place_id] = []
-        self.venue_feed_connections[place_id].append(websocket)
-
-        if is_new and self._pubsub is not None:
-            try:
-                channel = REDIS_CHANNEL_VENUE_FEED.format(place_id=place_id)
-                await self._pubsub.subscribe(channel)
-                logger.debug(f"Subscribed to Redis channel for venue feed {place_id}")
-            except Exception as e:
-                logger.warning(f"Failed to subscribe to venue feed channel: {e}")
+        self._open_outbox(websocket, lambda: self.disconnect_venue_feed(websocket, place_id))
+        self.venue_feed_connections.setdefault(place_id, []).append(websocket)
 
     def disconnect_venue_feed(self, websocket: WebSocket, place_id: str):
         """Remove a WebSocket from venue feed tracking"""
+        self._close_outbox(websocket)
         if place_id in self.venue_feed_connections:
             if websocket in self.venue_feed_connections[place_id]:
                 self.venue_feed_connections[place_id].remove(websocket)
             if not self.venue_feed_connections[place_id]:
                 del self.venue_feed_connections[place_id]
-                if self._pubsub is not None:
-                    asyncio.create_task(self._unsubscribe_venue_feed(place_id))
-
-    async def _unsubscribe_venue_feed(self, place_id: str):
-        try:
-            channel = REDIS_CHANNEL_VENUE_FEED.format(place_id=place_id)
-            await self._pubsub.unsubscribe(channel)
-            logger.debug(f"Unsubscribed from Redis channel for venue feed {place_id}")
-        except Exception as e:
-            logger.warning(f"Failed to unsubscribe from venue feed channel: {e}")
 
-    async def _send_to_venue_feed_local(self, place_id: str, message: dict):
+    async def _send_to_venue_feed_local(self, place_id: str, message: dict | str):
         """Send to all local connections for a venue feed"""
-        dead_connections = []
-        for ws in self.venue_feed_connections.get(place_id, []):
-            try:
-                await ws.send_json(message)
-            except Exception:
-                dead_connections.append(ws)
-        for ws in dead_connections:
-            self.disconnect_venue_feed(ws, place_id)
+        self._fanout("venue_feed", self.venue_feed_connections.get(place_id, []), message)
 
     async def send_to_venue_feed(self, place_id: str, message: dict):
         """Send to all venue feed WebSockets across all instances via Redis"""
         try:
-            redis = await get_redis()
-            channel = REDIS_CHANNEL_VENUE_FEED.format(place_id=place_id)
-            await redis.publish(channel, json.dumps(message))
+            await self._publish_routed(ROUTE_VENUE_FEED, place_id, message)
         except Exception as e:
             logger.warning(f"Redis send_to_venue_feed failed, falling back to local: {e}")
             await self._send_to_venue_feed_local(place_id, message)
 
     async def start_subscriber(self):
-        """Start Redis subscriber for cross-instance messages"""
-        if self._subscriber_task is not None:
+        """Start one Redis reader per shard channel plus the broadcast reader"""
+        if self._subscriber_tasks:
             return
 
-        self._subscriber_task = asyncio.create_task(self._subscribe_loop())
+        channels = [REDIS_CHANNEL_BROADCAST, REDIS_CHANNEL_GEO] + [
+            REDIS_CHANNEL_SHARD.format(shard=n) for n in range(settings.WS_PUBSUB_SHARDS)
+        ]
+        self._subscriber_tasks = [asyncio.create_task(self._subscribe_loop(c)) for c in channels]
+        self._geo_refresh_task = asyncio.create_task(self._geo_refresh_loop())
+        logger.info(f"Redis subscriber started: {settings.WS_PUBSUB_SHARDS} shard readers + broadcast")
+
+    async def stop_subscriber(self):
+        for task in self._subscriber_tasks:
+            task.cancel()
+        self._subscriber_tasks = []
+        if self._geo_refresh_task is not None:
+            self._geo_refresh_task.cancel()
+            self._geo_refresh_task = None
+
+    def _route(self, data: str):
+        """Dispatch one shard envelope to local sockets by id."""
+        route_key, sep, payload = data.partition("\n")
+        route, _, target = route_key.partition(":")
+        if not sep or not target:
+            return
+        if route == ROUTE_USER:
+            sockets = self.active_connections.get(int(target))
+            kind = "user"
+        elif route == ROUTE_VENUE_FEED:
+            sockets = self.venue_feed_connections.get(target)
+            kind = "venue_feed"
+        elif route == ROUTE_BOUNCE:
+            sockets = self.bounce_connections.get(int(target))
+            kind = "bounce"
+        else:
+            return
+        if not sockets:
+            self.pubsub_unrouted += 1
+            return
+        # Already JSON text: forwarded as-is, never re-serialized
+        self._fanout(kind, sockets, payload)
 
-    async def _subscribe_loop(self):
-        """Subscribe to Redis channels and dispatch to local connections"""
+    async def _subscribe_loop(self, channel: str):
+        """Read one fixed channel and dispatch to local connections"""
         while True:
+            pubsub = None
             try:
                 redis = await get_redis()
                 pubsub = redis.pubsub()
-                self._pubsub = pubsub  # Store for dynamic subscriptions
-
-                await pubsub.subscribe(REDIS_CHANNEL_BROADCAST)
-                # Subscribe to user-specific channels for connected users
-                for user_id in self.active_connections.keys():
-                    await pubsub.subscribe(REDIS_CHANNEL_USER.format(user_id=user_id))
-                # Subscribe to bounce channels for connected guests
-                for bounce_id in self.bounce_connections.keys():
-                    await pubsub.subscribe(REDIS_CHANNEL_BOUNCE.format(bounce_id=bounce_id))
-                # Subscribe to venue feed channels
-                for place_id in self.venue_feed_connections.keys():
-                    await pubsub.subscribe(REDIS_CHANNEL_VENUE_FEED.format(place_id=place_id))
-
-                logger.info(f"Redis subscriber started, subscribed to {len(self.active_connections)} user channels, {len(self.bounce_connections)} bounce channels, {len(self.venue_feed_connections)} venue feed channels")
+                await pubsub.subscribe(channel)
 
                 async for msg in pubsub.listen():
                     if msg["type"] != "message":
                         continue
-
+                    self.pubsub_received += 1
                     try:
-                        data = json.loads(msg["data"])
-                        channel = msg["channel"]
-
-                        if isinstance(channel, bytes):
-                            channel = channel.decode('utf-8')
-
                         if channel == REDIS_CHANNEL_BROADCAST:
-                            await self._send_local(data)
-                        elif channel.startswith("ws:user:"):
-                            user_id = int(channel.split(":")[-1])
-                            await self._send_local(data, user_id)
-                        elif channel.startswith("ws:venue_feed:"):
-                            place_id = channel.split(":", 2)[-1]
-                            await self._send_to_venue_feed_local(place_id, data)
-                        elif channel.startswith("ws:bounce:"):
-                            bounce_id = int(channel.split(":")[-1])
-                            await self._send_to_bounce_local(bounce_id, data)
+                            await self._send_local(msg["data"])
+                        elif channel == REDIS_CHANNEL_GEO:
+                            cells, _, payload = msg["data"].partition("\n")
+                            self._send_geo_local(cells.split(","), payload)
+                        else:
+                            self._route(msg["data"])
                     except Exception as e:
-                        logger.error(f"Error processing Redis message: {e}")
+                        logger.error(f"Error processing Redis message on {channel}: {e}")
 
+            except asyncio.CancelledError:
+                if pubsub is not None:
+                    try:
+                        await pubsub.reset()
+                    except Exception:
+                        pass
+                raise
             except Exception as e:
-                logger.error(f"Redis subscriber error, reconnecting: {e}")
-                self._pubsub = None
+                logger.error(f"Redis subscriber error on {channel}, reconnecting: {e}")
                 await asyncio.sleep(1)
 
 
@@ -319,13 +436,19 @@ async def notifications_websocket(
                 await websocket.send_text("pong")
                 continue
 
-            # Client-to-server events (currently just DM typing indicators)
+            # Client-to-server events: map viewport updates and DM typing indicators
             try:
                 event = json.loads(data)
             except json.JSONDecodeError:
                 continue
 
-            if event.get("type") == "typing":
+            if event.get("type") == "viewport":
+                # Map viewport center: scopes geo events (check-ins etc.) to this area
+                lat, lng = event.get("latitude"), event.get("longitude")
+                if isinstance(lat, (int, float)) and isinstance(lng, (int, float)) \
+                        and -90 <= lat <= 90 and -180 <= lng <= 180:
+                    manager.set_viewport(user_id, float(lat), float(lng))
+            elif event.get("type") == "typing":
                 to_user_id = event.get("to_user_id")
                 conversation_id = event.get("conversation_id")
                 if isinstance(to_user_id, int) and isinstance(conversation_id, int):
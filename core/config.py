@@ -8,6 +8,17 @@ class Settings:
     # Railway provides DATABASE_URL as postgresql://, we need to convert to postgresql+asyncpg://
     _db_url = os.getenv("DATABASE_URL", "postgresql+asyncpg://kerim@localhost:5432/artbasel_db")
     DATABASE_URL: str = _db_url.replace("postgresql://", "postgresql+asyncpg://") if _db_url.startswith("postgresql://") else _db_url
+    # Optional read replica for get_read_session routes (db/database.py)
+    _read_url = os.getenv("DATABASE_READ_URL", "")
+    DATABASE_READ_URL: str = _read_url.replace("postgresql://", "postgresql+asyncpg://") if _read_url.startswith("postgresql://") else _read_url
+    REPLICA_MAX_LAG_SECONDS: float = float(os.getenv("REPLICA_MAX_LAG_SECONDS", "2"))
+    # Connection budget per database for this whole service, split across
+    # DB_WORKERS processes (defaults to uvicorn's WEB_CONCURRENCY)
+    DB_WORKERS: int = int(os.getenv("DB_WORKERS", os.getenv("WEB_CONCURRENCY", "1")))
+    DB_MAX_CONNECTIONS: int = int(os.getenv("DB_MAX_CONNECTIONS", "80"))
+    DB_READ_MAX_CONNECTIONS: int = int(os.getenv("DB_READ_MAX_CONNECTIONS", "80"))
+    # Behind PgBouncer in transaction mode: no server-side prepared statement caching
+    DB_PGBOUNCER: bool = os.getenv("DB_PGBOUNCER", "false").lower() == "true"
 
     SECRET_KEY: str = os.getenv("SECRET_KEY", "change-this-secret-key-in-production")
     ALGORITHM: str = os.getenv("ALGORITHM", "HS256")
@@ -20,6 +31,13 @@ class Settings:
     UPLOAD_DIR: str = os.getenv("UPLOAD_DIR", "uploads")
     MAX_FILE_SIZE: int = int(os.getenv("MAX_FILE_SIZE", str(10 * 1024 * 1024)))
 
+    # Content-addressed image blobs (services/blob_store.py): local dir, or an
+    # S3-compatible bucket when BLOB_S3_BUCKET is set (endpoint for R2/MinIO etc.)
+    BLOB_DIR: str = os.getenv("BLOB_DIR", "blobs")
+    BLOB_S3_BUCKET: str = os.getenv("BLOB_S3_BUCKET", "")
+    BLOB_S3_ENDPOINT: str = os.getenv("BLOB_S3_ENDPOINT", "")
+    BLOB_S3_PREFIX: str = os.getenv("BLOB_S3_PREFIX", "blobs/")
+
     # Apple Sign In
     APPLE_TEAM_ID: str = os.getenv("APPLE_TEAM_ID", "")
     APPLE_KEY_ID: str = os.getenv("APPLE_KEY_ID", "")
@@ -50,14 +68,33 @@ class Settings:
     # Google Maps API
     GOOGLE_MAPS_API_KEY: str = os.getenv("GOOGLE_MAPS_API_KEY", "")
 
-    # Groq (AI commentator)
+    # Groq (AI commentator, profile agents, moderation)
     GROQ_API_KEY: str = os.getenv("GROQ", "")
+    # Shared across all instances (per-minute windows in Redis), see services/llm.py
+    LLM_REQUESTS_PER_MINUTE: int = int(os.getenv("LLM_REQUESTS_PER_MINUTE", "30"))
+    LLM_TOKENS_PER_MINUTE: int = int(os.getenv("LLM_TOKENS_PER_MINUTE", "20000"))
+    LLM_MAX_CONCURRENCY: int = int(os.getenv("LLM_MAX_CONCURRENCY", "4"))  # per instance
 
     # Base URL for share links
     BASE_URL: str = os.getenv("BASE_URL", "http://localhost:8000")
 
+    # Instrumentation (services/metrics.py): requests slower than this log their
+    # query breakdown; /metrics requires "Bearer <METRICS_TOKEN>" when set
+    SLOW_REQUEST_MS: int = int(os.getenv("SLOW_REQUEST_MS", "500"))
+    METRICS_TOKEN: str = os.getenv("METRICS_TOKEN", "")
+
     # Redis
     REDIS_URL: str = os.getenv("REDIS_URL", "redis://localhost:6379")
+    # WebSocket pub/sub fans out over this many fixed shard channels; every
+    # instance must use the same value (it decides which channel an id maps to)
+    WS_PUBSUB_SHARDS: int = int(os.getenv("WS_PUBSUB_SHARDS", "16"))
+
+    # Recsys / matching model builds
+    # "process": a dedicated builder (services/model_builder.py, spawned by
+    # startup.py) fits both models and publishes snapshots that workers mmap.
+    # "inline": each worker fits its own copy (dev / single-process setups).
+    MODEL_BUILDER_MODE: str = os.getenv("MODEL_BUILDER_MODE", "process")
+    MODEL_SNAPSHOT_DIR: str = os.getenv("MODEL_SNAPSHOT_DIR", "model_snapshots")
 
     # APNs (Apple Push Notification Service)
     # Falls back to APPLE_KEY_BASE64 if APNS_KEY_BASE64 not set
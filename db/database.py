@@ -1,30 +1,97 @@
+"""Engines and sessions.
+
+Writes (and anything that must read its own writes) use the primary through
+get_async_session. Read-only routes that tolerate a couple of seconds of
+staleness use get_read_session, which goes to DATABASE_READ_URL while the
+replica monitor sees it within REPLICA_MAX_LAG_SECONDS and falls back to the
+primary otherwise. Never fill a shared cache from a read session: a lagging
+replica would pin stale rows there until the TTL.
+
+Pools are sized from a per-service connection budget split across
+DB_WORKERS, so scaling workers doesn't multiply past what Postgres (or
+PgBouncer) allows. DB_PGBOUNCER disables asyncpg's prepared statement caches,
+which transaction pooling can't carry between server connections.
+"""
+
+import asyncio
+import hashlib
+import logging
+import re
+import time
 from sqlalchemy.ext.asyncio import AsyncSession, create_async_engine
 from sqlalchemy.orm import sessionmaker, declarative_base
-from typing import AsyncGenerator
+from typing import AsyncGenerator, Optional
 from core.config import settings
 
+logger = logging.getLogger(__name__)
+
 DATABASE_URL = settings.DATABASE_URL
 
+REPLICA_CHECK_SECONDS = 5
+REPLICA_CHECK_TIMEOUT = 2.0
+# 0 on a primary or a caught-up standby (an idle primary leaves the last
+# replay timestamp old, which is not lag). NULL — unhealthy — on a standby
+# without a streaming WAL receiver: once disconnected, receive = replay
+# forever and would read as caught up. The receiver's row exists for any
+# role while it runs; status needs pg_read_all_stats, and is checked when
+# visible.
+REPLICA_LAG_SQL = (
+    "SELECT CASE WHEN NOT pg_is_in_recovery() THEN 0 "
+    "WHEN NOT EXISTS (SELECT 1 FROM pg_stat_wal_receiver "
+    "WHERE coalesce(status, 'streaming') = 'streaming') THEN NULL "
+    "WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+    "ELSE EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) END"
+)
+
 engine = None
 async_session_maker = None
+read_engine = None
+read_session_maker = None
+_primary_read_session_maker = None
+_replica_ok = False
+_replica_lag: Optional[float] = None
+_replica_task: Optional[asyncio.Task] = None
 Base = declarative_base()
 
 
+def _engine_args(max_connections: int) -> dict:
+    per_worker = max(2, max_connections // max(1, settings.DB_WORKERS))
+    pool_size = max(1, per_worker * 2 // 3)
+    args = dict(
+        echo=False,
+        pool_size=pool_size,
+        max_overflow=per_worker - pool_size,
+        pool_timeout=30,
+        pool_recycle=3600,
+        pool_pre_ping=True,
+    )
+    if settings.DB_PGBOUNCER:
+        args["connect_args"] = {"statement_cache_size": 0, "prepared_statement_cache_size": 0}
+    return args
+
+
+def _create_engine(url: str, max_connections: int):
+    new_engine = create_async_engine(url, **_engine_args(max_connections))
+    from services.metrics import instrument_engine
+    instrument_engine(new_engine.sync_engine)
+    return new_engine
+
+
 def get_engine():
     global engine
     if engine is None:
-        engine = create_async_engine(
-            DATABASE_URL,
-            echo=False,
-            pool_size=50,
-            max_overflow=30,
-            pool_timeout=30,
-            pool_recycle=3600,
-            pool_pre_ping=True
-        )
+        engine = _create_engine(DATABASE_URL, settings.DB_MAX_CONNECTIONS)
     return engine
 
 
+def get_read_engine():
+    """Replica engine, or None when no DATABASE_READ_URL is configured."""
+    global read_engine
+    if read_engine is None and settings.DATABASE_READ_URL:
+        read_engine = _create_engine(settings.DATABASE_READ_URL, settings.DB_READ_MAX_CONNECTIONS)
+    return read_engine
+
+
 def get_session_maker():
     global async_session_maker
     if async_session_maker is None:
@@ -34,84 +101,257 @@ def get_session_maker():
     return async_session_maker
 
 
-async def create_db_and_tables():
+def get_read_session_maker():
+    """Replica sessions while it's healthy, primary ones otherwise. Both skip
+    autoflush: read sessions never write."""
+    global read_session_maker, _primary_read_session_maker
+    if _replica_ok and get_read_engine() is not None:
+        if read_session_maker is None:
+            read_session_maker = sessionmaker(
+                get_read_engine(), class_=AsyncSession, expire_on_commit=False, autoflush=False
+            )
+        return read_session_maker
+    if _primary_read_session_maker is None:
+        _primary_read_session_maker = sessionmaker(
+            get_engine(), class_=AsyncSession, expire_on_commit=False, autoflush=False
+        )
+    return _primary_read_session_maker
+
+
+# Schema steps, applied in order and recorded in the schema_migrations ledger.
+# Append only; every step must be idempotent (IF NOT EXISTS / backfills that
+# only touch unset rows), since a step whose text changes runs again. Index
+# steps build CONCURRENTLY so they never block writes to hot tables.
+MIGRATIONS = [
+    # Users table
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS instagram_handle VARCHAR(30)",
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS instagram_profile_pic TEXT",
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS linkedin_handle VARCHAR(100)",
+    # Profile pictures (base64 stored in DB)
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_1 TEXT",
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_2 TEXT",
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_3 TEXT",
+    # Private profiles
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS is_private BOOLEAN NOT NULL DEFAULT FALSE",
+    # Direct message: replies, bounce shares, unsend
+    "ALTER TABLE direct_messages ALTER COLUMN text DROP NOT NULL",
+    "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS reply_to_id INTEGER REFERENCES direct_messages(id) ON DELETE SET NULL",
+    "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS bounce_id INTEGER REFERENCES bounces(id) ON DELETE SET NULL",
+    "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS deleted_at TIMESTAMP WITH TIME ZONE",
+    # Places table
+    "ALTER TABLE places ADD COLUMN IF NOT EXISTS bounce_count INTEGER DEFAULT 0",
+    "ALTER TABLE places ADD COLUMN IF NOT EXISTS updated_at TIMESTAMP WITH TIME ZONE",
+    # Bounces table
+    "ALTER TABLE bounces ADD COLUMN IF NOT EXISTS place_id INTEGER REFERENCES places(id) ON DELETE SET NULL",
+    # Check-ins table
+    "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS place_id VARCHAR(255)",
+    "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS places_fk_id INTEGER REFERENCES places(id) ON DELETE SET NULL",
+    "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS last_seen_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()",
+    "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS is_active BOOLEAN DEFAULT TRUE",
+    # Indexes
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS ix_bounces_place_id ON bounces(place_id)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_checkins_place_id ON check_ins(place_id)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_checkins_places_fk ON check_ins(places_fk_id)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_checkins_last_seen ON check_ins(last_seen_at)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_checkins_active ON check_ins(is_active) WHERE is_active = true",
+    # Deactivate duplicate active check-ins (keep only the most recent per user)
+    """UPDATE check_ins SET is_active = false
+       WHERE is_active = true AND id NOT IN (
+           SELECT MAX(id) FROM check_ins WHERE is_active = true GROUP BY user_id
+       )""",
+    "CREATE UNIQUE INDEX CONCURRENTLY IF NOT EXISTS idx_checkins_one_active_per_user ON check_ins(user_id) WHERE is_active = true",
+    # Follows table - close friend feature
+    "ALTER TABLE follows ADD COLUMN IF NOT EXISTS is_close_friend BOOLEAN DEFAULT FALSE",
+    # Performance indexes for high-traffic queries
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_follows_follower_following ON follows(follower_id, following_id)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_device_tokens_user_active ON device_tokens(user_id, is_active) WHERE is_active = true",
+    # Admin dashboard
+    "ALTER TABLE users ADD COLUMN IF NOT EXISTS is_admin BOOLEAN NOT NULL DEFAULT FALSE",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_users_is_admin ON users(is_admin) WHERE is_admin = TRUE",
+    # Bounce share link
+    "ALTER TABLE bounces ADD COLUMN IF NOT EXISTS share_token VARCHAR(64) UNIQUE",
+    "CREATE UNIQUE INDEX CONCURRENTLY IF NOT EXISTS idx_bounces_share_token ON bounces(share_token)",
+    # Venue feed messages
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_venue_feed_place_id ON venue_feed_messages(place_id)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_venue_feed_place_id_desc ON venue_feed_messages(place_id, id DESC)",
+    "ALTER TABLE venue_feed_messages ADD COLUMN IF NOT EXISTS is_hidden BOOLEAN DEFAULT FALSE NOT NULL",
+    "ALTER TABLE venue_feed_messages ADD COLUMN IF NOT EXISTS moderation_reason VARCHAR(500)",
+    # Bounce map: denormalized invite count (backfill only touches NULL rows)
+    "ALTER TABLE bounces ADD COLUMN IF NOT EXISTS invite_count INTEGER",
+    """UPDATE bounces b SET invite_count = (
+           SELECT COUNT(*) FROM bounce_invites i WHERE i.bounce_id = b.id
+       ) WHERE b.invite_count IS NULL""",
+    "ALTER TABLE bounces ALTER COLUMN invite_count SET DEFAULT 0",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_bounces_active_public ON bounces(is_public, latitude, longitude) WHERE status = 'active'",
+    # Denormalized DM inbox (snapshot + unread counters, backfilled lazily)
+    "ALTER TABLE conversations ADD COLUMN IF NOT EXISTS last_message_id INTEGER",
+    "ALTER TABLE conversations ADD COLUMN IF NOT EXISTS last_message_snapshot TEXT",
+    "ALTER TABLE conversations ADD COLUMN IF NOT EXISTS user1_unread INTEGER",
+    "ALTER TABLE conversations ADD COLUMN IF NOT EXISTS user2_unread INTEGER",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_conversations_user1_recent ON conversations(user1_id, last_message_at DESC, id DESC)",
+    "CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_conversations_user2_recent ON conversations(user2_id, last_message_at DESC, id DESC)",
+    # User search: prefix range scans on lower(name) in byte order
+    'CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_users_nickname_search ON users ((lower(nickname) COLLATE "C")) WHERE is_active = true',
+    'CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_users_instagram_search ON users ((lower(instagram_handle) COLLATE "C")) WHERE is_active = true',
+]
+
+
+MIGRATION_LOCK_ID = 4242_0001          # pg advisory lock key for schema steps, shared by every instance
+INDEX_LOCK_ID = 4242_0002              # separate key so index builds don't hold up schema waiters
+MIGRATION_LOCK_TIMEOUT = "5s"           # give up on a step rather than queue behind live traffic
+_CONCURRENT_INDEX_RE = re.compile(r"INDEX CONCURRENTLY IF NOT EXISTS (\w+)", re.IGNORECASE)
+_index_build_task: Optional[asyncio.Task] = None
+
+
+def _step_id(statement: str) -> str:
+    return hashlib.sha1(" ".join(statement.split()).encode()).hexdigest()[:16]
+
+
+def _schema_steps() -> list[tuple[str, Optional[str]]]:
+    """(step id, statement) in order. The first is metadata.create_all, keyed
+    by the model table names so adding a model reruns it."""
     from . import models
-    engine = get_engine()
-    async with engine.begin() as conn:
-        await conn.run_sync(Base.metadata.create_all)
+    tables = ",".join(sorted(Base.metadata.tables))
+    steps: list[tuple[str, Optional[str]]] = [(f"create_all:{_step_id(tables)}", None)]
+    steps.extend((_step_id(m), m) for m in MIGRATIONS)
+    return steps
 
-    # Run migrations for new columns
-    await run_migrations()
 
+async def create_db_and_tables(background_indexes: bool = True):
+    """Bring the schema up to date.
 
-async def run_migrations():
-    """Run any pending column additions"""
+    Fast path: one SELECT against the ledger proves every step is applied,
+    and startup moves on without touching any other table. Otherwise the
+    tables, columns and backfills are applied under a blocking advisory lock:
+    one instance runs them while the others wait on the lock, then find them
+    in the ledger, so nobody serves against a half-migrated schema. Only the
+    CONCURRENTLY index builds, which the app works without, continue in the
+    background on whichever instance gets there first (inline with
+    background_indexes=False, for scripts that exit right after).
+    """
+    global _index_build_task
     from sqlalchemy import text
 
-    migrations = [
-        # Users table
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS instagram_handle VARCHAR(30)",
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS instagram_profile_pic TEXT",
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS linkedin_handle VARCHAR(100)",
-        # Profile pictures (base64 stored in DB)
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_1 TEXT",
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_2 TEXT",
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS profile_picture_3 TEXT",
-        # Private profiles
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS is_private BOOLEAN NOT NULL DEFAULT FALSE",
-        # Direct message: replies, bounce shares, unsend
-        "ALTER TABLE direct_messages ALTER COLUMN text DROP NOT NULL",
-        "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS reply_to_id INTEGER REFERENCES direct_messages(id) ON DELETE SET NULL",
-        "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS bounce_id INTEGER REFERENCES bounces(id) ON DELETE SET NULL",
-        "ALTER TABLE direct_messages ADD COLUMN IF NOT EXISTS deleted_at TIMESTAMP WITH TIME ZONE",
-        # Places table
-        "ALTER TABLE places ADD COLUMN IF NOT EXISTS bounce_count INTEGER DEFAULT 0",
-        "ALTER TABLE places ADD COLUMN IF NOT EXISTS updated_at TIMESTAMP WITH TIME ZONE",
-        # Bounces table
-        "ALTER TABLE bounces ADD COLUMN IF NOT EXISTS place_id INTEGER REFERENCES places(id) ON DELETE SET NULL",
-        # Check-ins table
-        "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS place_id VARCHAR(255)",
-        "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS places_fk_id INTEGER REFERENCES places(id) ON DELETE SET NULL",
-        "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS last_seen_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()",
-        "ALTER TABLE check_ins ADD COLUMN IF NOT EXISTS is_active BOOLEAN DEFAULT TRUE",
-        # Indexes
-        "CREATE INDEX IF NOT EXISTS ix_bounces_place_id ON bounces(place_id)",
-        "CREATE INDEX IF NOT EXISTS idx_checkins_place_id ON check_ins(place_id)",
-        "CREATE INDEX IF NOT EXISTS idx_checkins_places_fk ON check_ins(places_fk_id)",
-        "CREATE INDEX IF NOT EXISTS idx_checkins_last_seen ON check_ins(last_seen_at)",
-        "CREATE INDEX IF NOT EXISTS idx_checkins_active ON check_ins(is_active) WHERE is_active = true",
-        # Deactivate duplicate active check-ins (keep only the most recent per user)
-        """UPDATE check_ins SET is_active = false
-           WHERE is_active = true AND id NOT IN (
-               SELECT MAX(id) FROM check_ins WHERE is_active = true GROUP BY user_id
-           )""",
-        "CREATE UNIQUE INDEX IF NOT EXISTS idx_checkins_one_active_per_user ON check_ins(user_id) WHERE is_active = true",
-        # Follows table - close friend feature
-        "ALTER TABLE follows ADD COLUMN IF NOT EXISTS is_close_friend BOOLEAN DEFAULT FALSE",
-        # Performance indexes for high-traffic queries
-        "CREATE INDEX IF NOT EXISTS idx_follows_follower_following ON follows(follower_id, following_id)",
-        "CREATE INDEX IF NOT EXISTS idx_device_tokens_user_active ON device_tokens(user_id, is_active) WHERE is_active = true",
-        # Admin dashboard
-        "ALTER TABLE users ADD COLUMN IF NOT EXISTS is_admin BOOLEAN NOT NULL DEFAULT FALSE",
-        "CREATE INDEX IF NOT EXISTS idx_users_is_admin ON users(is_admin) WHERE is_admin = TRUE",
-        # Bounce share link
-        "ALTER TABLE bounces ADD COLUMN IF NOT EXISTS share_token VARCHAR(64) UNIQUE",
-        "CREATE UNIQUE INDEX IF NOT EXISTS idx_bounces_share_token ON bounces(share_token)",
-        # Venue feed messages
-        "CREATE INDEX IF NOT EXISTS idx_venue_feed_place_id ON venue_feed_messages(place_id)",
-        "CREATE INDEX IF NOT EXISTS idx_venue_feed_place_id_desc ON venue_feed_messages(place_id, id DESC)",
-        "ALTER TABLE venue_feed_messages ADD COLUMN IF NOT EXISTS is_hidden BOOLEAN DEFAULT FALSE NOT NULL",
-        "ALTER TABLE venue_feed_messages ADD COLUMN IF NOT EXISTS moderation_reason VARCHAR(500)",
-    ]
-
+    steps = _schema_steps()
     engine = get_engine()
-    async with engine.begin() as conn:
-        for migration in migrations:
+    async with engine.connect() as conn:
+        try:
+            applied = (await conn.execute(
+                text("SELECT count(*) FROM schema_migrations WHERE step_id = ANY(:ids)"),
+                {"ids": [step_id for step_id, _ in steps]},
+            )).scalar()
+            if applied == len(steps):
+                return
+        except Exception:
+            pass  # no ledger yet
+        await conn.rollback()
+
+    index_steps = [step for step in steps if _CONCURRENT_INDEX_RE.search(step[1] or "")]
+    await run_migrations([step for step in steps if step not in index_steps], MIGRATION_LOCK_ID, wait=True)
+    if not background_indexes:
+        await run_migrations(index_steps, INDEX_LOCK_ID, wait=True)
+    elif index_steps and _index_build_task is None:
+        _index_build_task = asyncio.create_task(_build_indexes(index_steps))
+
+
+async def _build_indexes(steps: list[tuple[str, Optional[str]]]):
+    try:
+        await run_migrations(steps, INDEX_LOCK_ID, wait=False)
+    except Exception as e:
+        logger.error(f"Background index build failed, will retry next boot: {e}")
+
+
+def _migration_engine():
+    # NullPool: the session-level advisory lock and lock_timeout go away with
+    # the connection instead of riding a pooled one into app queries
+    from sqlalchemy.pool import NullPool
+    args = {}
+    if settings.DB_PGBOUNCER:
+        args["connect_args"] = {"statement_cache_size": 0, "prepared_statement_cache_size": 0}
+    return create_async_engine(DATABASE_URL, poolclass=NullPool, **args)
+
+
+async def run_migrations(steps: Optional[list[tuple[str, Optional[str]]]] = None,
+                         lock_id: int = MIGRATION_LOCK_ID, wait: bool = True):
+    """Apply the steps missing from the ledger (default: all of them) under
+    the advisory lock lock_id. wait=True blocks until the lock is free (the
+    holder's steps are in the ledger by then); wait=False skips if another
+    instance holds it."""
+    from sqlalchemy import text
+
+    if steps is None:
+        steps = _schema_steps()
+    migration_engine = _migration_engine()
+    try:
+        async with migration_engine.connect() as conn:
+            conn = await conn.execution_options(isolation_level="AUTOCOMMIT")
+            if wait:
+                if not (await conn.execute(text("SELECT pg_try_advisory_lock(:k)"), {"k": lock_id})).scalar():
+                    logger.info("Schema migration running on another instance, waiting for it")
+                    await conn.execute(text("SELECT pg_advisory_lock(:k)"), {"k": lock_id})
+            elif not (await conn.execute(text("SELECT pg_try_advisory_lock(:k)"), {"k": lock_id})).scalar():
+                logger.info("Index builds running on another instance, skipping")
+                return
             try:
-                await conn.execute(text(migration))
-            except Exception as e:
-                # Column might already exist or other non-critical error
-                pass
+                await _apply_steps(conn, steps)
+            finally:
+                await conn.execute(text("RESET lock_timeout"))
+                await conn.execute(text("SELECT pg_advisory_unlock(:k)"), {"k": lock_id})
+    finally:
+        await migration_engine.dispose()
+
+
+async def _apply_steps(conn, steps: list[tuple[str, Optional[str]]]):
+    from sqlalchemy import text
+
+    await conn.execute(text(
+        "CREATE TABLE IF NOT EXISTS schema_migrations ("
+        "step_id VARCHAR(64) PRIMARY KEY, "
+        "statement TEXT, "
+        "applied_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW())"
+    ))
+    await conn.execute(text(f"SET lock_timeout = '{MIGRATION_LOCK_TIMEOUT}'"))
+    applied = set((await conn.execute(text("SELECT step_id FROM schema_migrations"))).scalars().all())
+
+    started = time.monotonic()
+    done = failed = 0
+    for step_id, statement in steps:
+        if step_id in applied:
+            continue
+        match = _CONCURRENT_INDEX_RE.search(statement or "")
+        try:
+            if statement is None:
+                await conn.run_sync(Base.metadata.create_all)
+            else:
+                if match:
+                    # An interrupted build (worker killed mid-way) leaves an
+                    # INVALID index that IF NOT EXISTS would skip forever
+                    invalid = (await conn.execute(
+                        text("SELECT NOT indisvalid FROM pg_index WHERE indexrelid = to_regclass(:name)"),
+                        {"name": match.group(1)},
+                    )).scalar()
+                    if invalid:
+                        await conn.execute(text(f"DROP INDEX CONCURRENTLY IF EXISTS {match.group(1)}"))
+                await conn.execute(text(statement))
+        except Exception as e:
+            failed += 1
+            logger.warning(f"Migration step {step_id} failed, will retry next boot: {e}")
+            # Same for a build that failed outright
+            if match:
+                try:
+                    await conn.execute(text(f"DROP INDEX CONCURRENTLY IF EXISTS {match.group(1)}"))
+                except Exception:
+                    pass
+            continue
+        await conn.execute(
+            text("INSERT INTO schema_migrations (step_id, statement) VALUES (:id, :stmt) "
+                 "ON CONFLICT (step_id) DO NOTHING"),
+            {"id": step_id, "stmt": statement},
+        )
+        done += 1
+    if done or failed:
+        logger.info(f"Schema migration: {done} step(s) applied, {failed} failed "
+                    f"in {time.monotonic() - started:.1f}s")
 
 
 async def get_async_session() -> AsyncGenerator[AsyncSession, None]:
@@ -120,7 +360,70 @@ async def get_async_session() -> AsyncGenerator[AsyncSession, None]:
         yield session
 
 
+async def get_read_session() -> AsyncGenerator[AsyncSession, None]:
+    """Session for read-only routes: replica when healthy (see module docstring)."""
+    session_maker = get_read_session_maker()
+    async with session_maker() as session:
+        yield session
+
+
 def create_async_session() -> AsyncSession:
     """Create a new AsyncSession for WebSocket. Caller must close it."""
     session_maker = get_session_maker()
     return session_maker()
+
+
+# ---------------------------------------------------------------- replica monitor
+
+
+async def _check_replica() -> None:
+    global _replica_ok, _replica_lag
+    from sqlalchemy import text
+
+    try:
+        async with get_read_engine().connect() as conn:
+            lag = (await asyncio.wait_for(conn.execute(text(REPLICA_LAG_SQL)), REPLICA_CHECK_TIMEOUT)).scalar()
+        _replica_lag = float(lag) if lag is not None else None
+        healthy = _replica_lag is not None and _replica_lag <= settings.REPLICA_MAX_LAG_SECONDS
+    except Exception as e:
+        _replica_lag = None
+        healthy = False
+        if _replica_ok:
+            logger.warning(f"Read replica check failed: {e}")
+    if healthy != _replica_ok:
+        logger.warning(
+            f"Read replica {'healthy' if healthy else 'unhealthy'} "
+            f"({'no streaming WAL receiver' if _replica_lag is None else f'lag {_replica_lag}s'}): "
+            f"routing reads to the {'replica' if healthy else 'primary'}"
+        )
+    _replica_ok = healthy
+
+
+async def _replica_monitor_loop():
+    while True:
+        try:
+            await _check_replica()
+            await asyncio.sleep(REPLICA_CHECK_SECONDS)
+        except asyncio.CancelledError:
+            break
+
+
+def replica_status() -> Optional[dict]:
+    if not settings.DATABASE_READ_URL:
+        return None
+    return {"healthy": _replica_ok, "lag_seconds": _replica_lag}
+
+
+async def start_replica_monitor():
+    global _replica_task
+    if _replica_task is None and get_read_engine() is not None:
+        _replica_task = asyncio.create_task(_replica_monitor_loop())
+
+
+async def stop_replica_monitor():
+    global _replica_task
+    if _replica_task is not None:
+        _replica_task.cancel()
+        _replica_task = None
+    if read_engine is not None:
+        await read_engine.dispose()
@@ -28,9 +28,9 @@ class User(Base):
     phone = Column(String(20), nullable=True)
     email = Column(String(255), nullable=True)
     profile_picture = Column(String, nullable=True)  # Legacy - kept for backwards compatibility
-    profile_picture_1 = Column(Text, nullable=True)  # Base64 encoded image
-    profile_picture_2 = Column(Text, nullable=True)  # Base64 encoded image
-    profile_picture_3 = Column(Text, nullable=True)  # Base64 encoded image
+    profile_picture_1 = Column(Text, nullable=True)  # Blob ref (/img/blob/<sha256>.<ext>); legacy rows: base64 data URI
+    profile_picture_2 = Column(Text, nullable=True)  # Blob ref (/img/blob/<sha256>.<ext>); legacy rows: base64 data URI
+    profile_picture_3 = Column(Text, nullable=True)  # Blob ref (/img/blob/<sha256>.<ext>); legacy rows: base64 data URI
     instagram_handle = Column(String(30), nullable=True, index=True)
 
     # Privacy settings for Art Basel Miami access control
@@ -203,6 +203,9 @@ class Bounce(Base):
     # Share link token for web map
     share_token = Column(String(64), unique=True, index=True, nullable=True)
 
+    # Denormalized COUNT(bounce_invites), kept by the invite/remove handlers
+    invite_count = Column(Integer, default=0, nullable=True)
+
     # Timestamps
     created_at = Column(DateTime(timezone=True), server_default=func.now(), index=True)
 
@@ -446,7 +449,7 @@ class VenueFeedMessage(Base):
     places_fk_id = Column(Integer, ForeignKey("places.id", ondelete="SET NULL"), nullable=True)
     user_id = Column(Integer, ForeignKey("users.id", ondelete="CASCADE"), nullable=False, index=True)
     text = Column(Text, nullable=True)
-    image = Column(Text, nullable=True)           # base64 data URI
+    image = Column(Text, nullable=True)           # blob ref (/img/blob/...); legacy rows: base64 data URI
     is_hidden = Column(Boolean, default=False, nullable=False)
     moderation_reason = Column(String(500), nullable=True)
     created_at = Column(DateTime(timezone=True), server_default=func.now(), index=True)
@@ -488,6 +491,15 @@ class Conversation(Base):
     user2_id = Column(Integer, ForeignKey("users.id", ondelete="CASCADE"), nullable=False, index=True)
     created_at = Column(DateTime(timezone=True), server_default=func.now())
     last_message_at = Column(DateTime(timezone=True), server_default=func.now(), index=True)
+    # Denormalized inbox (maintained by api/routes/messages.py on send / read /
+    # unsend / react) so the inbox is one indexed range read. No FK on
+    # last_message_id: it would make the two tables mutually dependent.
+    last_message_id = Column(Integer, nullable=True)
+    last_message_snapshot = Column(Text, nullable=True)  # JSON: serialized last message
+    # Unread messages for each side; NULL = not computed yet (rows from before
+    # the columns existed), filled lazily on first inbox load
+    user1_unread = Column(Integer, nullable=True, default=0)
+    user2_unread = Column(Integer, nullable=True, default=0)
 
     user1 = relationship("User", foreign_keys=[user1_id])
     user2 = relationship("User", foreign_keys=[user2_id])
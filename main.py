@@ -4,7 +4,7 @@ from pathlib import Path
 
 from fastapi import FastAPI, Request
 from fastapi.middleware.cors import CORSMiddleware
-from fastapi.responses import JSONResponse
+from fastapi.responses import JSONResponse, PlainTextResponse
 from fastapi.staticfiles import StaticFiles
 from slowapi import _rate_limit_exceeded_handler
 from slowapi.errors import RateLimitExceeded
@@ -33,9 +33,23 @@ from api.routes import (
     websocket,
 )
 from api.routes.close_friends import start_silent_push_loop, stop_silent_push_loop
+from api.routes.images import close_http_client as close_image_http_client
 from api.routes.websocket import manager as ws_manager
 from core.config import settings
-from db.database import create_db_and_tables
+from db.database import create_db_and_tables, start_replica_monitor, stop_replica_monitor
+from services.ai_commentator import stop_commentator_scheduler
+from services.cache import start_invalidation_listener, stop_invalidation_listener
+from services.live_room import start_presence_loop, stop_presence_loop
+from services.llm import close_llm
+from services.location_store import start_location_flusher, stop_location_flusher
+from services.metrics import MetricsMiddleware
+from services.places.local_index import start_autocomplete_sync, stop_autocomplete_sync
+from services.recommendations import (
+    start_event_flusher,
+    start_interaction_listener,
+    stop_event_flusher,
+    stop_interaction_listener,
+)
 from services.redis import close_redis
 
 # Configure logging
@@ -60,15 +74,19 @@ async def lifespan(app: FastAPI):
 
     logger = logging.getLogger(__name__)
 
-    # Initialize database (with timeout so slow DB doesn't block startup)
+    # Initialize database.
+    # Up to date this is one ledger read. Otherwise wait for the schema steps
+    # (here or on the instance holding the migration lock) before serving;
+    # only concurrent index builds carry on in the background.
     try:
-        await asyncio.wait_for(create_db_and_tables(), timeout=30)
+        await create_db_and_tables()
         logger.info("Database initialized")
-    except asyncio.TimeoutError:
-        logger.error("Database initialization timed out after 30s — continuing anyway")
     except Exception as e:
         logger.error(f"Database initialization failed: {e} — continuing anyway")
 
+    # Route get_read_session to the replica while it keeps up
+    await start_replica_monitor()
+
     # Start WebSocket Redis subscriber (non-blocking)
     try:
         await asyncio.wait_for(ws_manager.start_subscriber(), timeout=10)
@@ -78,6 +96,24 @@ async def lifespan(app: FastAPI):
     except Exception as e:
         logger.warning(f"Redis subscriber failed: {e}")
 
+    # Cross-worker fan-in of incremental recsys interactions
+    await start_interaction_listener()
+
+    # Buffered multi-row writes of place / feed view events
+    await start_event_flusher()
+
+    # Cross-worker L1 cache invalidation (services/cache.py)
+    await start_invalidation_listener()
+
+    # Write-behind flush of buffered location heartbeats
+    await start_location_flusher()
+
+    # Batched live-room viewer presence
+    await start_presence_loop()
+
+    # Per-worker copy of the places autocomplete index
+    await start_autocomplete_sync()
+
     # Start silent push loop for background location sharing
     await start_silent_push_loop()
     # Instagram 2FA poller - uncomment when ready to use
@@ -88,6 +124,17 @@ async def lifespan(app: FastAPI):
     # Cleanup
     # await stop_ig_poller()
     await stop_silent_push_loop()
+    await stop_presence_loop()
+    await stop_commentator_scheduler()
+    await close_llm()
+    await stop_event_flusher()
+    await stop_interaction_listener()
+    await stop_invalidation_listener()
+    await stop_location_flusher()
+    await stop_autocomplete_sync()
+    await ws_manager.stop_subscriber()
+    await close_image_http_client()
+    await stop_replica_monitor()
     await close_redis()
 
 
@@ -119,6 +166,9 @@ app.add_middleware(
     expose_headers=["*"],
 )
 
+# Per-route latency / SQL / Redis counters and the slow-request log (services/metrics.py)
+app.add_middleware(MetricsMiddleware)
+
 # Create upload directory
 uploads_dir = Path(settings.UPLOAD_DIR)
 uploads_dir.mkdir(exist_ok=True)
@@ -167,4 +217,20 @@ async def health():
     except Exception:
         pass
 
-    return {"status": "healthy", "redis": "connected" if redis_ok else "disconnected"}
+    from db.database import replica_status
+
+    status = {"status": "healthy", "redis": "connected" if redis_ok else "disconnected"}
+    replica = replica_status()
+    if replica is not None:
+        status["replica"] = replica
+    return status
+
+
+@app.get("/metrics", include_in_schema=False)
+async def metrics(request: Request):
+    """Prometheus scrape endpoint for this worker."""
+    from services.metrics import render
+
+    if settings.METRICS_TOKEN and request.headers.get("authorization") != f"Bearer {settings.METRICS_TOKEN}":
+        return JSONResponse(status_code=401, content={"detail": "Unauthorized"})
+    return PlainTextResponse(render(ws_stats=ws_manager.stats()), media_type="text/plain; version=0.0.4")
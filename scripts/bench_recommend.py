@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Offline micro-benchmark for recsys ranking.
+
+Fits a model on a synthetic city (no DB needed), then times ranking the
+same candidate sets two ways:
+- legacy: one feature vector per (user, venue) in a Python loop, sigmoid
+  per candidate (the pre-vectorization recommend_for_user path)
+- vectorized: _feature_matrix + _score over the whole candidate array
+and checks both produce the same scores. --fit-reps repeats the model fit
+(_build_rows + _fit_core) for a stable timing. The online counterpart is
+scripts/loadtest.py (suggestions scenario).
+
+    python scripts/bench_recommend.py --users 3000 --venues 1500 --candidates 400
+"""
+
+import argparse
+import json
+import math
+import random
+import statistics
+import sys
+import time
+from datetime import datetime, timedelta, timezone
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+
+import numpy as np
+
+from services import recommendations as rec
+
+VENUE_TYPES = ["bar", "night_club", "restaurant", "cafe", "art_gallery", "museum",
+               "point_of_interest", "establishment", "lodging"]
+
+
+def synthetic_raw(n_users: int, n_venues: int, checkins_per_user: int, seed: int = 1) -> dict:
+    """Rows shaped exactly like services.recommendations._load_raw output."""
+    rnd = random.Random(seed)
+    now = datetime.now(timezone.utc)
+    center = (25.79, -80.13)
+    places = []
+    for i in range(n_venues):
+        lat = center[0] + rnd.uniform(-0.15, 0.15)
+        lng = center[1] + rnd.uniform(-0.15, 0.15)
+        types = rnd.sample(VENUE_TYPES, k=rnd.randint(1, 3))
+        places.append((i + 1, f"venue_{i}", f"Venue {i}", f"{i} Collins Ave", lat, lng,
+                       json.dumps(types), rnd.randint(0, 200)))
+    # Zipf-ish venue popularity so the matrix looks like real nightlife
+    weights = [1.0 / (k + 1) ** 0.8 for k in range(n_venues)]
+    checkins = []
+    for u in range(1, n_users + 1):
+        for _ in range(rnd.randint(1, checkins_per_user)):
+            vi = rnd.choices(range(n_venues), weights=weights)[0]
+            p = places[vi]
+            ts = now - timedelta(days=rnd.uniform(0, rec.HISTORY_WINDOW_DAYS))
+            checkins.append((u, p[1], ts, p[4], p[5]))
+    follows = []
+    for u in range(1, n_users + 1):
+        for g in rnd.sample(range(1, n_users + 1), k=min(8, n_users)):
+            if g != u:
+                follows.append((u, g, "accepted" if rnd.random() < 0.05 else None))
+    return {"checkins": checkins, "old_checkins": [], "bounces": [], "feed_posts": [],
+            "events": [], "follows": follows, "places": places, "now": now}
+
+
+def legacy_features(m, uid, ui, vi, origin, ppr) -> np.ndarray:
+    """The per-candidate feature builder recommend_for_user used to call."""
+    meta = m.venue_meta[vi]
+    mf = float(m.X[ui] @ m.Y[vi]) if ui is not None and ui < m.X.shape[0] else 0.0
+    graph = float(m.G[ui] @ m.GV[vi]) if ui is not None and ui < m.G.shape[0] else 0.0
+    cat = 0.0
+    if ui is not None:
+        uvec = m.user_cat.get(ui, {})
+        if uvec and meta["types"]:
+            hit = sum(w for t, w in uvec.items() if t in meta["types"])
+            norm = math.sqrt(sum(w * w for w in uvec.values())) * math.sqrt(len(meta["types"]))
+            cat = hit / norm if norm > 0 else 0.0
+    pop = math.log1p(meta["pop"]) / math.log1p(max(m.popularity.max(), 1.0))
+    social = 0.0
+    for fid, s in m.ties.get(uid, {}).items():
+        w = m.venue_visitors.get(vi, {}).get(fid)
+        if w:
+            social += s * w
+    social = math.tanh(social / 3.0)
+    own = m.R_sparse.get(ui, {}).get(vi, 0.0) if ui is not None else 0.0
+    novelty = 1.0 / (1.0 + own)
+    dist = 0.5
+    if origin and meta["lat"] is not None and meta["lng"] is not None:
+        d = rec._haversine_m(origin[0], origin[1], meta["lat"], meta["lng"])
+        dist = math.exp(-d / rec.DISTANCE_SCALE_M)
+    network_flow = float(ppr[vi]) if ppr is not None and vi < len(ppr) else 0.0
+    return np.array([mf, graph, cat, pop, social, novelty, dist, network_flow])
+
+
+def legacy_scores(m, uid, ui, vis, origin, ppr) -> np.ndarray:
+    out = []
+    for vi in vis.tolist():
+        f = legacy_features(m, uid, ui, vi, origin, ppr)
+        fz = (f - m.feat_mean) / m.feat_std if m.ranker_learned else f
+        z = float(fz @ m.ranker_w + m.ranker_b)
+        out.append(1.0 / (1.0 + math.exp(-max(min(z, 30), -30))))
+    return np.array(out)
+
+
+def vectorized_scores(m, uid, ui, vis, origin, ppr) -> np.ndarray:
+    return rec._score(m, rec._feature_matrix(m, uid, ui, vis, origin, ppr))
+
+
+def _time(fn, reps: int) -> list[float]:
+    out = []
+    for _ in range(reps):
+        t0 = time.perf_counter()
+        fn()
+        out.append((time.perf_counter() - t0) * 1000)
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--users", type=int, default=3000)
+    ap.add_argument("--venues", type=int, default=1500)
+    ap.add_argument("--checkins-per-user", type=int, default=12)
+    ap.add_argument("--candidates", type=int, default=400)
+    ap.add_argument("--queries", type=int, default=50)
+    ap.add_argument("--fit-reps", type=int, default=1, help="time the fit this many times")
+    args = ap.parse_args()
+
+    raw = synthetic_raw(args.users, args.venues, args.checkins_per_user)
+    fit_s = []
+    for _ in range(args.fit_reps):
+        t0 = time.perf_counter()
+        rows, coords = rec._build_rows(raw)
+        m = rec._fit_core(raw, rows, coords)
+        fit_s.append(time.perf_counter() - t0)
+    print(f"fit: p50 {statistics.median(fit_s):.2f}s  max {max(fit_s):.2f}s over {args.fit_reps} "
+          f"({len(m.user_index)} users, {len(m.venue_ids)} venues, {len(rows)} interactions)")
+
+    rng = np.random.default_rng(5)
+    uids = rng.choice(list(m.user_index), size=min(args.queries, len(m.user_index)), replace=False)
+    legacy_ms, vector_ms, worst = [], [], 0.0
+    for uid in uids.tolist():
+        ui = m.user_index[uid]
+        origin = m.centroids.get(uid)
+        ppr = rec._ppr_venue_scores(m, uid)
+        vis = rng.choice(len(m.venue_ids), size=min(args.candidates, len(m.venue_ids)),
+                         replace=False).astype(np.int64)
+        a = legacy_scores(m, uid, ui, vis, origin, ppr)
+        b = vectorized_scores(m, uid, ui, vis, origin, ppr)
+        worst = max(worst, float(np.abs(a - b).max()))
+        legacy_ms += _time(lambda: legacy_scores(m, uid, ui, vis, origin, ppr), 3)
+        vector_ms += _time(lambda: vectorized_scores(m, uid, ui, vis, origin, ppr), 3)
+
+    lp50, vp50 = statistics.median(legacy_ms), statistics.median(vector_ms)
+    print(f"candidates/request: {args.candidates}")
+    print(f"legacy     p50 {lp50:8.3f} ms   p99 {np.percentile(legacy_ms, 99):8.3f} ms")
+    print(f"vectorized p50 {vp50:8.3f} ms   p99 {np.percentile(vector_ms, 99):8.3f} ms")
+    print(f"speedup    {lp50 / max(vp50, 1e-9):.1f}x   max |score diff| {worst:.2e}")
+    if worst > 1e-6:
+        print("❌ vectorized scores diverge from the legacy path")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
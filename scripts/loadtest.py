@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""
+Mixed-traffic load test against a running server.
+
+Drives the hot paths with the dataset written by seed_bench_data.py:
+
+    heartbeat       POST /users/me/heartbeat
+    checkin         POST /checkins/venue/{place_id}
+    map             GET  /bounces/map
+    suggestions     GET  /suggestions/for-you
+    conversations   GET  /messages/conversations
+    feed_read       GET  /venue-feed/{place_id}
+    feed_post       POST /venue-feed/{place_id}
+
+`--concurrency` virtual users each loop: pick a scenario by weight, call it,
+record latency. Alongside, `--ws-users` sockets hold /ws/notifications and
+`--ws-venue` sockets hold /venue-feed/ws/{place_id} (busy venues get more),
+counting connect latency and messages received.
+
+DB and Redis work per request comes from the server's /metrics
+(services/metrics.py), scraped before and after: the deltas of
+http_request_db_queries and http_request_redis_commands per route. /metrics
+is per worker, so run the server with one worker for exact op counts.
+
+    python scripts/loadtest.py --base-url http://localhost:8000 --duration 60 \\
+        --concurrency 200 --ws-users 2000 --ws-venue 1000 --json run.json
+    python scripts/loadtest.py ... --baseline run.json    # print deltas vs a saved run
+
+Run with the server's SECRET_KEY: access tokens are minted locally.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import re
+import sys
+import time
+from collections import defaultdict
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+
+import httpx
+import numpy as np
+import websockets
+
+from services.auth_service import create_access_token
+
+DEFAULT_MIX = "heartbeat=40,checkin=4,map=14,suggestions=10,conversations=10,feed_read=17,feed_post=5"
+
+# scenario -> (method, route template) as labelled by services.metrics
+ROUTES = {
+    "heartbeat": ("POST", "/users/me/heartbeat"),
+    "checkin": ("POST", "/checkins/venue/{place_id}"),
+    "map": ("GET", "/bounces/map"),
+    "suggestions": ("GET", "/suggestions/for-you"),
+    "conversations": ("GET", "/messages/conversations"),
+    "feed_read": ("GET", "/venue-feed/{place_id}"),
+    "feed_post": ("POST", "/venue-feed/{place_id}"),
+}
+
+WS_CONNECT_PARALLELISM = 200
+_SAMPLE_RE = re.compile(r'^(\w+)\{(.*)\} (\S+)$')
+_LABEL_RE = re.compile(r'(\w+)="((?:[^"\\]|\\.)*)"')
+
+
+class Dataset:
+    def __init__(self, path: str, rnd: random.Random):
+        raw = json.loads(Path(path).read_text())
+        self.rnd = rnd
+        self.user_ids = raw["user_ids"]
+        self.venues = raw["venues"]
+        self.weights = raw["venue_weights"]
+        self.tokens = {uid: create_access_token({"sub": str(uid)}) for uid in self.user_ids}
+
+    def user(self) -> tuple[int, dict]:
+        uid = self.rnd.choice(self.user_ids)
+        return uid, {"Authorization": f"Bearer {self.tokens[uid]}"}
+
+    def venue(self) -> dict:
+        return self.rnd.choices(self.venues, weights=self.weights)[0]
+
+    def near(self, venue: dict, meters: float = 30) -> tuple[float, float]:
+        d = meters / 111_000
+        return venue["lat"] + self.rnd.uniform(-d, d), venue["lng"] + self.rnd.uniform(-d, d)
+
+
+# ---------------------------------------------------------------- scenarios
+
+
+async def heartbeat(client, ds):
+    _, headers = ds.user()
+    lat, lng = ds.near(ds.venue(), 500)
+    return await client.post("/users/me/heartbeat", headers=headers, json={"latitude": lat, "longitude": lng})
+
+
+async def checkin(client, ds):
+    _, headers = ds.user()
+    v = ds.venue()
+    lat, lng = ds.near(v)
+    return await client.post(f"/checkins/venue/{v['place_id']}", headers=headers, json={
+        "latitude": lat, "longitude": lng, "venue_name": v["name"],
+        "venue_lat": v["lat"], "venue_lng": v["lng"],
+    })
+
+
+async def map_bounces(client, ds):
+    _, headers = ds.user()
+    lat, lng = ds.near(ds.venue(), 2000)
+    return await client.get("/bounces/map", headers=headers, params={"lat": lat, "lng": lng})
+
+
+async def suggestions(client, ds):
+    _, headers = ds.user()
+    lat, lng = ds.near(ds.venue(), 2000)
+    return await client.get("/suggestions/for-you", headers=headers, params={"lat": lat, "lng": lng})
+
+
+async def conversations(client, ds):
+    _, headers = ds.user()
+    return await client.get("/messages/conversations", headers=headers)
+
+
+async def feed_read(client, ds):
+    _, headers = ds.user()
+    return await client.get(f"/venue-feed/{ds.venue()['place_id']}", headers=headers)
+
+
+async def feed_post(client, ds):
+    _, headers = ds.user()
+    return await client.post(f"/venue-feed/{ds.venue()['place_id']}", headers=headers,
+                             json={"text": f"load test {ds.rnd.randint(0, 1_000_000)}"})
+
+
+SCENARIOS = {
+    "heartbeat": heartbeat,
+    "checkin": checkin,
+    "map": map_bounces,
+    "suggestions": suggestions,
+    "conversations": conversations,
+    "feed_read": feed_read,
+    "feed_post": feed_post,
+}
+
+
+# ---------------------------------------------------------------- drivers
+
+
+class Recorder:
+    def __init__(self):
+        self.latencies: dict[str, list[float]] = defaultdict(list)
+        self.errors: dict[str, int] = defaultdict(int)
+        self.statuses: dict[str, dict[int, int]] = defaultdict(lambda: defaultdict(int))
+
+    def record(self, name: str, ms: float, status: int):
+        self.latencies[name].append(ms)
+        self.statuses[name][status] += 1
+        if status >= 400:
+            self.errors[name] += 1
+
+
+async def virtual_user(client, ds, mix, rec: Recorder, deadline: float):
+    names, weights = zip(*mix.items())
+    while time.monotonic() < deadline:
+        name = ds.rnd.choices(names, weights=weights)[0]
+        started = time.perf_counter()
+        try:
+            resp = await SCENARIOS[name](client, ds)
+            status = resp.status_code
+        except Exception:
+            status = 599
+        rec.record(name, (time.perf_counter() - started) * 1000, status)
+
+
+class SocketStats:
+    def __init__(self):
+        self.connect_ms: dict[str, list[float]] = defaultdict(list)
+        self.failed: dict[str, int] = defaultdict(int)
+        self.received: dict[str, int] = defaultdict(int)
+        self.open: dict[str, int] = defaultdict(int)
+
+
+async def hold_socket(kind: str, url: str, headers: dict, stats: SocketStats, gate: asyncio.Semaphore,
+                      deadline: float):
+    started = time.perf_counter()
+    try:
+        async with gate:
+            ws = await websockets.connect(url, extra_headers=headers, open_timeout=15, max_size=None)
+        stats.connect_ms[kind].append((time.perf_counter() - started) * 1000)
+    except Exception:
+        stats.failed[kind] += 1
+        return
+    stats.open[kind] += 1
+    try:
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            try:
+                await asyncio.wait_for(ws.recv(), timeout=min(remaining, 25))
+                stats.received[kind] += 1
+            except asyncio.TimeoutError:
+                await ws.send("ping")
+    except Exception:
+        pass
+    finally:
+        stats.open[kind] -= 1
+        await ws.close()
+
+
+async def scrape_metrics(client, token: str) -> dict:
+    """{(method, route): {"requests", "db", "redis"}} summed over this worker."""
+    headers = {"Authorization": f"Bearer {token}"} if token else {}
+    try:
+        resp = await client.get("/metrics", headers=headers)
+        resp.raise_for_status()
+    except Exception as e:
+        print(f"⚠️  /metrics unavailable ({e}) — no DB/Redis op counts")
+        return {}
+    out: dict = defaultdict(lambda: {"requests": 0.0, "db": 0.0, "redis": 0.0})
+    for line in resp.text.splitlines():
+        m = _SAMPLE_RE.match(line)
+        if not m:
+            continue
+        name, labels, value = m.group(1), dict(_LABEL_RE.findall(m.group(2))), float(m.group(3))
+        key = (labels.get("method"), labels.get("route"))
+        if name == "http_request_db_queries_sum":
+            out[key]["db"] += value
+        elif name == "http_request_db_queries_count":
+            out[key]["requests"] += value
+        elif name == "http_request_redis_commands_sum":
+            out[key]["redis"] += value
+    return out
+
+
+def _pct(values: list[float], q: float):
+    return round(float(np.percentile(values, q)), 2) if values else None
+
+
+async def run(args):
+    rnd = random.Random(args.seed)
+    ds = Dataset(args.dataset, rnd)
+    mix = {}
+    for part in args.mix.split(","):
+        name, _, weight = part.partition("=")
+        if name.strip() not in SCENARIOS:
+            sys.exit(f"unknown scenario {name!r}; have {sorted(SCENARIOS)}")
+        if float(weight) > 0:
+            mix[name.strip()] = float(weight)
+
+    limits = httpx.Limits(max_connections=args.concurrency, max_keepalive_connections=args.concurrency)
+    async with httpx.AsyncClient(base_url=args.base_url, limits=limits, timeout=30) as client:
+        before = await scrape_metrics(client, args.metrics_token)
+
+        ws_base = args.base_url.replace("http", "ws", 1)
+        sockets = SocketStats()
+        gate = asyncio.Semaphore(WS_CONNECT_PARALLELISM)
+        deadline = time.monotonic() + args.duration
+        tasks = []
+        for _ in range(args.ws_users):
+            _, headers = ds.user()
+            tasks.append(hold_socket("notifications", f"{ws_base}/ws/notifications", headers,
+                                     sockets, gate, deadline))
+        for _ in range(args.ws_venue):
+            uid, _ = ds.user()
+            url = f"{ws_base}/venue-feed/ws/{ds.venue()['place_id']}?token={ds.tokens[uid]}"
+            tasks.append(hold_socket("venue_feed", url, {}, sockets, gate, deadline))
+
+        rec = Recorder()
+        started = time.monotonic()
+        socket_tasks = [asyncio.create_task(t) for t in tasks]
+        await asyncio.gather(*(virtual_user(client, ds, mix, rec, deadline) for _ in range(args.concurrency)))
+        elapsed = time.monotonic() - started
+        await asyncio.gather(*socket_tasks)
+
+        after = await scrape_metrics(client, args.metrics_token)
+
+    report = {"duration_s": round(elapsed, 1), "concurrency": args.concurrency, "scenarios": {}, "websockets": {}}
+    for name in mix:
+        lat = rec.latencies.get(name, [])
+        entry = {
+            "requests": len(lat),
+            "errors": rec.errors.get(name, 0),
+            "rps": round(len(lat) / elapsed, 1),
+            "p50_ms": _pct(lat, 50),
+            "p99_ms": _pct(lat, 99),
+            "max_ms": round(max(lat), 2) if lat else None,
+            "statuses": dict(rec.statuses.get(name, {})),
+        }
+        key = ROUTES[name]
+        if key in after:
+            b = before.get(key, {"requests": 0.0, "db": 0.0, "redis": 0.0})
+            n = after[key]["requests"] - b["requests"]
+            if n:
+                entry["db_queries_per_req"] = round((after[key]["db"] - b["db"]) / n, 2)
+                entry["redis_cmds_per_req"] = round((after[key]["redis"] - b["redis"]) / n, 2)
+        report["scenarios"][name] = entry
+    for kind in set(sockets.connect_ms) | set(sockets.failed):
+        report["websockets"][kind] = {
+            "connected": len(sockets.connect_ms[kind]),
+            "failed": sockets.failed[kind],
+            "connect_p50_ms": _pct(sockets.connect_ms[kind], 50),
+            "connect_p99_ms": _pct(sockets.connect_ms[kind], 99),
+            "messages_received": sockets.received[kind],
+        }
+    return report
+
+
+def print_report(report: dict, baseline: dict = None):
+    def delta(name, field):
+        if not baseline:
+            return ""
+        old = baseline.get("scenarios", {}).get(name, {}).get(field)
+        new = report["scenarios"][name].get(field)
+        if not old or new is None:
+            return ""
+        return f" ({(new - old) / old * 100:+.0f}%)"
+
+    total = sum(s["requests"] for s in report["scenarios"].values())
+    print(f"\n{total} requests in {report['duration_s']}s "
+          f"({total / max(report['duration_s'], 1e-9):.0f} req/s, {report['concurrency']} virtual users)\n")
+    print(f"{'scenario':<14} {'reqs':>7} {'err':>5} {'rps':>7} {'p50 ms':>16} {'p99 ms':>16} {'db/req':>7} {'redis/req':>9}")
+    for name, s in report["scenarios"].items():
+        print(f"{name:<14} {s['requests']:>7} {s['errors']:>5} {s['rps']:>7} "
+              f"{str(s['p50_ms']) + delta(name, 'p50_ms'):>16} {str(s['p99_ms']) + delta(name, 'p99_ms'):>16} "
+              f"{str(s.get('db_queries_per_req', '-')):>7} {str(s.get('redis_cmds_per_req', '-')):>9}")
+    for kind, w in report["websockets"].items():
+        print(f"ws {kind:<11} connected {w['connected']:>6}  failed {w['failed']:>5}  "
+              f"connect p50 {w['connect_p50_ms']} ms  p99 {w['connect_p99_ms']} ms  "
+              f"received {w['messages_received']}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--base-url", default="http://localhost:8000")
+    ap.add_argument("--dataset", default="bench_dataset.json")
+    ap.add_argument("--duration", type=float, default=60)
+    ap.add_argument("--concurrency", type=int, default=100)
+    ap.add_argument("--ws-users", type=int, default=0, help="sockets on /ws/notifications")
+    ap.add_argument("--ws-venue", type=int, default=0, help="sockets on /venue-feed/ws/{place_id}")
+    ap.add_argument("--mix", default=DEFAULT_MIX, help="scenario=weight,... (weight 0 disables)")
+    ap.add_argument("--metrics-token", default="", help="METRICS_TOKEN of the server, if set")
+    ap.add_argument("--seed", type=int, default=7)
+    ap.add_argument("--json", help="write the report here")
+    ap.add_argument("--baseline", help="a previous --json report to compare against")
+    args = ap.parse_args()
+
+    report = asyncio.run(run(args))
+    baseline = json.loads(Path(args.baseline).read_text()) if args.baseline else None
+    print_report(report, baseline)
+    if args.json:
+        Path(args.json).write_text(json.dumps(report, indent=2))
+
+
+if __name__ == "__main__":
+    main()
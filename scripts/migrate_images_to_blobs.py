@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Move base64 data-URI images out of Postgres into the blob store.
+
+Rewrites users.profile_picture_1..3 and venue_feed_messages.image from
+`data:<type>;base64,...` to `/img/blob/<sha256>.<ext>` refs (thumbnails are
+generated on the way). Idempotent and resumable: only rows still holding a
+data URI are touched, in batches, one commit per batch.
+
+    python scripts/migrate_images_to_blobs.py [--batch 200] [--dry-run]
+
+--dry-run decodes and hashes every image but writes neither blobs nor rows.
+"""
+
+import argparse
+import asyncio
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+
+from sqlalchemy import or_, select, update
+
+from db.database import create_async_session
+from db.models import User, VenueFeedMessage
+from services.blob_store import BLOB_URL_PREFIX, image_name, parse_data_uri, put_image
+
+USER_COLUMNS = ("profile_picture_1", "profile_picture_2", "profile_picture_3")
+
+
+async def _to_ref(value: str, dry_run: bool):
+    """Blob ref for a data URI; a dry run only hashes, writing nothing."""
+    data, content_type = parse_data_uri(value)
+    if data is None:
+        return None
+    if dry_run:
+        return BLOB_URL_PREFIX + image_name(data, content_type or "image/jpeg")
+    return await put_image(data, content_type or "image/jpeg")
+
+
+async def migrate_users(batch: int, dry_run: bool) -> tuple[int, int]:
+    rows = moved = 0
+    last_id = 0
+    while True:
+        async with create_async_session() as db:
+            cols = [getattr(User, c) for c in USER_COLUMNS]
+            result = await db.execute(
+                select(User.id, *cols)
+                .where(User.id > last_id, or_(*[c.like("data:%") for c in cols]))
+                .order_by(User.id)
+                .limit(batch)
+            )
+            chunk = result.all()
+            if not chunk:
+                return rows, moved
+            for row in chunk:
+                last_id = row[0]
+                updates = {}
+                for name, value in zip(USER_COLUMNS, row[1:]):
+                    if value and value.startswith("data:"):
+                        ref = await _to_ref(value, dry_run)
+                        if ref:
+                            updates[name] = ref
+                if updates and not dry_run:
+                    await db.execute(update(User).where(User.id == row[0]).values(**updates))
+                rows += 1
+                moved += len(updates)
+            if not dry_run:
+                await db.commit()
+        print(f"  users: {rows} rows scanned, {moved} images moved")
+
+
+async def migrate_feed(batch: int, dry_run: bool) -> tuple[int, int]:
+    rows = moved = 0
+    last_id = 0
+    while True:
+        async with create_async_session() as db:
+            result = await db.execute(
+                select(VenueFeedMessage)
+                .where(VenueFeedMessage.id > last_id, VenueFeedMessage.image.like("data:%"))
+                .order_by(VenueFeedMessage.id)
+                .limit(batch)
+            )
+            chunk = result.scalars().all()
+            if not chunk:
+                return rows, moved
+            for msg in chunk:
+                last_id = msg.id
+                ref = await _to_ref(msg.image, dry_run)
+                rows += 1
+                if ref:
+                    moved += 1
+                    if not dry_run:
+                        msg.image = ref
+            if not dry_run:
+                await db.commit()
+        print(f"  venue feed: {rows} rows scanned, {moved} images moved")
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--batch", type=int, default=200)
+    ap.add_argument("--dry-run", action="store_true")
+    args = ap.parse_args()
+
+    print("🔄 Migrating profile pictures...")
+    u_rows, u_moved = await migrate_users(args.batch, args.dry_run)
+    print("🔄 Migrating venue feed images...")
+    f_rows, f_moved = await migrate_feed(args.batch, args.dry_run)
+    verb = "would move" if args.dry_run else "moved"
+    print(f"✅ Done: {verb} {u_moved} profile pictures ({u_rows} users) "
+          f"and {f_moved} feed images ({f_rows} messages)")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""
+Seed a synthetic city for load tests (scripts/loadtest.py).
+
+Everything it writes is tagged so it can be found and removed again: users
+have apple_user_id "bench_<n>", places have place_id "bench_venue_<n>".
+Venues cluster around the Miami spots from seed_user_data.py, popularity is
+Zipf-ish, and users get follows, check-in history, one active check-in for
+a share of them, DM conversations and venue feed messages — enough for the
+map, suggestions, inbox and feed endpoints to do real work.
+
+    python scripts/seed_bench_data.py --users 5000 --out bench_dataset.json
+    python scripts/seed_bench_data.py --reset      # delete bench rows only
+
+The dataset file lists the ids the load test drives; it mints its own access
+tokens, so run both with the server's SECRET_KEY. Seeded rows bypass the
+Redis indexes (bounce geo index, venue feed rings), so FLUSHDB the bench
+Redis after seeding and let the server rebuild them.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import sys
+import time
+from datetime import datetime, timedelta, timezone
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent.parent))
+
+from faker import Faker
+from sqlalchemy import text
+
+from db.database import create_async_session
+from scripts.seed_user_data import EMPLOYERS, MIAMI_VENUES
+
+BENCH_USER_PREFIX = "bench_"
+BENCH_PLACE_PREFIX = "bench_venue_"
+CHUNK = 2000
+VENUE_TYPES = ["bar", "night_club", "restaurant", "cafe", "art_gallery", "museum"]
+
+
+def _chunks(rows: list, size: int = CHUNK):
+    for i in range(0, len(rows), size):
+        yield rows[i:i + size]
+
+
+async def _insert(db, sql: str, rows: list, label: str):
+    started = time.perf_counter()
+    for chunk in _chunks(rows):
+        await db.execute(text(sql), chunk)
+    await db.commit()
+    print(f"   {label}: {len(rows)} rows in {time.perf_counter() - started:.1f}s")
+
+
+async def reset():
+    db = create_async_session()
+    try:
+        # users cascade to follows, bounces, check-ins, history, conversations, messages, feed posts
+        users = await db.execute(text("DELETE FROM users WHERE apple_user_id LIKE 'bench\\_%'"))
+        places = await db.execute(text("DELETE FROM places WHERE place_id LIKE 'bench\\_venue\\_%'"))
+        await db.commit()
+        print(f"Removed {users.rowcount} bench users, {places.rowcount} bench places")
+    finally:
+        await db.close()
+
+
+async def seed(args):
+    rnd = random.Random(args.seed)
+    fake = Faker()
+    Faker.seed(args.seed)
+    now = datetime.now(timezone.utc)
+    n_users = args.users
+    n_venues = args.venues or max(50, n_users // 4)
+
+    db = create_async_session()
+    try:
+        existing = (await db.execute(
+            text("SELECT count(*) FROM users WHERE apple_user_id LIKE 'bench\\_%'")
+        )).scalar()
+        if existing:
+            print(f"{existing} bench users already exist — run with --reset first")
+            return
+
+        print(f"Seeding {n_users} users, {n_venues} venues")
+
+        # ---- users
+        users = []
+        for i in range(n_users):
+            first, last = fake.first_name(), fake.last_name()
+            users.append({
+                "apple_id": f"{BENCH_USER_PREFIX}{i}",
+                "first_name": first,
+                "last_name": last,
+                "nickname": f"{first.lower()}{i}",
+                "employer": rnd.choice(EMPLOYERS),
+                "instagram": f"{first.lower()}.{last.lower()}{i}"[:30],
+            })
+        await _insert(db, """
+            INSERT INTO users (apple_user_id, first_name, last_name, nickname, employer,
+                               instagram_handle, can_post, phone_visible, email_visible, is_private,
+                               is_admin, is_active)
+            VALUES (:apple_id, :first_name, :last_name, :nickname, :employer,
+                    :instagram, true, false, false, false, false, true)
+        """, users, "users")
+        user_ids = list((await db.execute(
+            text("SELECT id FROM users WHERE apple_user_id LIKE 'bench\\_%' ORDER BY id")
+        )).scalars().all())
+
+        # ---- venues around the seed_user_data hot spots
+        venues = []
+        for i in range(n_venues):
+            anchor = MIAMI_VENUES[i % len(MIAMI_VENUES)]
+            venues.append({
+                "place_id": f"{BENCH_PLACE_PREFIX}{i}",
+                "name": f"{anchor['name']} {i}" if i >= len(MIAMI_VENUES) else anchor["name"],
+                "address": anchor["address"],
+                "lat": anchor["lat"] + rnd.uniform(-0.01, 0.01),
+                "lng": anchor["lon"] + rnd.uniform(-0.01, 0.01),
+                "types": json.dumps(rnd.sample(VENUE_TYPES, k=rnd.randint(1, 3))),
+            })
+        await _insert(db, """
+            INSERT INTO places (place_id, name, address, latitude, longitude, types, bounce_count)
+            VALUES (:place_id, :name, :address, :lat, :lng, :types, 0)
+        """, venues, "places")
+        place_pk = dict((await db.execute(
+            text("SELECT place_id, id FROM places WHERE place_id LIKE 'bench\\_venue\\_%'")
+        )).all())
+        weights = [1.0 / (k + 1) ** 0.8 for k in range(n_venues)]
+
+        # ---- follows: a few popular accounts plus random edges
+        follows = set()
+        popular = user_ids[:max(1, n_users // 50)]
+        for uid in user_ids:
+            for other in rnd.sample(user_ids, k=min(args.follows, n_users)) + rnd.sample(popular, k=min(3, len(popular))):
+                if other != uid:
+                    follows.add((uid, other))
+        await _insert(db, """
+            INSERT INTO follows (follower_id, following_id, is_close_friend, close_friend_status, is_sharing_location)
+            VALUES (:a, :b, false, 'none', false)
+        """, [{"a": a, "b": b} for a, b in follows], "follows")
+
+        # ---- check-in history (recsys input) and active check-ins
+        history, active = [], []
+        for uid in user_ids:
+            for _ in range(rnd.randint(1, args.checkins_per_user)):
+                v = venues[rnd.choices(range(n_venues), weights=weights)[0]]
+                history.append({
+                    "uid": uid, "place_id": v["place_id"], "fk": place_pk[v["place_id"]],
+                    "name": v["name"], "address": v["address"], "lat": v["lat"], "lng": v["lng"],
+                    "at": now - timedelta(days=rnd.uniform(0, 60)),
+                })
+            if rnd.random() < args.active_share:
+                v = venues[rnd.choices(range(n_venues), weights=weights)[0]]
+                active.append({"uid": uid, "place_id": v["place_id"], "fk": place_pk[v["place_id"]],
+                               "name": v["name"], "lat": v["lat"], "lng": v["lng"]})
+        await _insert(db, """
+            INSERT INTO check_in_history (user_id, place_id, places_fk_id, venue_name, venue_address,
+                                          latitude, longitude, checked_in_at)
+            VALUES (:uid, :place_id, :fk, :name, :address, :lat, :lng, :at)
+        """, history, "check-in history")
+        await _insert(db, """
+            INSERT INTO check_ins (user_id, latitude, longitude, location_name, place_id, places_fk_id,
+                                   last_seen_at, is_active)
+            VALUES (:uid, :lat, :lng, :name, :place_id, :fk, NOW(), true)
+        """, active, "active check-ins")
+
+        # ---- bounces: some now, some later, mostly public
+        bounces = []
+        for _ in range(max(10, n_users // 10)):
+            v = venues[rnd.choices(range(n_venues), weights=weights)[0]]
+            is_now = rnd.random() < 0.3
+            bounces.append({
+                "creator": rnd.choice(user_ids), "fk": place_pk[v["place_id"]],
+                "name": v["name"], "address": v["address"], "lat": v["lat"], "lng": v["lng"],
+                "at": now if is_now else now + timedelta(hours=rnd.uniform(1, 48)),
+                "is_now": is_now, "is_public": rnd.random() < 0.7,
+            })
+        await _insert(db, """
+            INSERT INTO bounces (creator_id, places_fk_id, venue_name, venue_address, latitude, longitude,
+                                 bounce_time, is_now, is_public, status, invite_count)
+            VALUES (:creator, :fk, :name, :address, :lat, :lng, :at, :is_now, :is_public, 'active', 0)
+        """, bounces, "bounces")
+
+        # ---- DM conversations between follow pairs
+        pairs = set()
+        for a, b in rnd.sample(sorted(follows), k=min(len(follows), n_users * args.conversations_per_user)):
+            pairs.add((min(a, b), max(a, b)))
+        await _insert(db, """
+            INSERT INTO conversations (user1_id, user2_id, last_message_at, user1_unread, user2_unread)
+            VALUES (:a, :b, :at, 0, 0)
+        """, [{"a": a, "b": b, "at": now - timedelta(minutes=rnd.uniform(0, 600))} for a, b in pairs],
+            "conversations")
+        conversations = (await db.execute(text(
+            "SELECT c.id, c.user1_id, c.user2_id FROM conversations c "
+            "JOIN users u ON u.id = c.user1_id WHERE u.apple_user_id LIKE 'bench\\_%'"
+        ))).all()
+        messages = []
+        for cid, a, b in conversations:
+            for k in range(args.messages_per_conversation):
+                messages.append({
+                    "cid": cid, "sender": rnd.choice((a, b)), "text": fake.sentence(nb_words=8),
+                    "at": now - timedelta(minutes=(args.messages_per_conversation - k) * 3),
+                })
+        await _insert(db, """
+            INSERT INTO direct_messages (conversation_id, sender_id, text, created_at)
+            VALUES (:cid, :sender, :text, :at)
+        """, messages, "direct messages")
+
+        # ---- venue feeds: busy venues get long feeds
+        feed = []
+        for i, v in enumerate(venues):
+            for _ in range(int(args.feed_messages * weights[i] / weights[0]) + 1):
+                feed.append({
+                    "place_id": v["place_id"], "fk": place_pk[v["place_id"]],
+                    "uid": rnd.choice(user_ids), "text": fake.sentence(nb_words=10),
+                    "at": now - timedelta(minutes=rnd.uniform(0, 1440)),
+                })
+        await _insert(db, """
+            INSERT INTO venue_feed_messages (place_id, places_fk_id, user_id, text, is_hidden, created_at)
+            VALUES (:place_id, :fk, :uid, :text, false, :at)
+        """, feed, "venue feed messages")
+    finally:
+        await db.close()
+
+    dataset = {
+        "seed": args.seed,
+        "created_at": now.isoformat(),
+        "user_ids": user_ids,
+        "venues": [{"place_id": v["place_id"], "name": v["name"], "lat": v["lat"], "lng": v["lng"]}
+                   for v in venues],
+        "venue_weights": weights,
+    }
+    Path(args.out).write_text(json.dumps(dataset))
+    print(f"Dataset written to {args.out}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--users", type=int, default=2000)
+    ap.add_argument("--venues", type=int, default=None, help="default: users / 4")
+    ap.add_argument("--follows", type=int, default=20, help="random follows per user")
+    ap.add_argument("--checkins-per-user", type=int, default=12)
+    ap.add_argument("--active-share", type=float, default=0.3, help="share of users checked in now")
+    ap.add_argument("--conversations-per-user", type=int, default=2)
+    ap.add_argument("--messages-per-conversation", type=int, default=10)
+    ap.add_argument("--feed-messages", type=int, default=150, help="messages at the busiest venue")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--out", default="bench_dataset.json")
+    ap.add_argument("--reset", action="store_true", help="delete bench rows and exit")
+    args = ap.parse_args()
+
+    asyncio.run(reset() if args.reset else seed(args))
+
+
+if __name__ == "__main__":
+    main()
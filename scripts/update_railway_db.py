@@ -37,7 +37,7 @@ async def main() -> None:
         engine = get_engine()
         print(f"🔌 Engine created (async). URL: {engine.url}\n")
 
-        await create_db_and_tables()
+        await create_db_and_tables(background_indexes=False)
         print("✅ Railway schema synchronized successfully!")
 
     except Exception as exc:
@@ -1,3 +1,12 @@
+"""Per-bounce AI colour commentary.
+
+Commentators are plain state (attendees, chat buffer, one pending event);
+a single scheduler loop per worker decides which of them are due — pending
+event past min_interval, or a quiet room past INACTIVITY_SECONDS — and hands
+generation to the shared LLM service (services/llm.py) at interactive
+priority, so hundreds of live bounces cost one task, not hundreds.
+"""
+
 import asyncio
 import time
 import logging
@@ -5,12 +14,16 @@ from collections import deque
 from math import radians, sin, cos, sqrt, atan2
 from typing import Optional, Callable, Awaitable
 
-import httpx
-
 from core.config import settings
+from services import llm
 
 logger = logging.getLogger(__name__)
 
+SCHEDULER_TICK_SECONDS = 1.0
+INACTIVITY_SECONDS = 120
+# Commentary older than this is stale by the time it would land
+COMMENT_DEADLINE_SECONDS = 20
+
 
 def _haversine(lat1: float, lng1: float, lat2: float, lng2: float) -> float:
     """Distance in metres between two lat/lng points."""
@@ -31,8 +44,9 @@ class BounceCommentator:
         self.chat_buffer: deque = deque(maxlen=50)
         self.last_ai_time: float = 0
         self.min_interval: float = 30.0
-        self._queue: asyncio.Queue = asyncio.Queue()
-        self._task: Optional[asyncio.Task] = None
+        self.last_event_time: float = time.time()
+        self._pending: Optional[dict] = None
+        self._generating: Optional[asyncio.Task] = None
         self._stopped = False
         self._send: Optional[Callable] = None
         self._persist: Optional[Callable] = None
@@ -44,22 +58,27 @@ class BounceCommentator:
     ):
         self._send = send_callback
         self._persist = persist_callback
-        self._task = asyncio.create_task(self._process_loop())
+        _ensure_scheduler()
 
     async def stop(self):
         self._stopped = True
-        if self._task:
-            self._task.cancel()
+        if self._generating:
+            self._generating.cancel()
             try:
-                await self._task
+                await self._generating
             except asyncio.CancelledError:
                 pass
 
     def push_event(self, event: dict):
-        try:
-            self._queue.put_nowait(event)
-        except asyncio.QueueFull:
-            pass
+        """Events during the cooldown (or while a comment is being written)
+        are dropped, as before; the first one after it becomes pending."""
+        self.last_event_time = time.time()
+        if self._pending is not None or self._generating is not None:
+            return
+        if time.time() - self.last_ai_time < self.min_interval:
+            return
+        if self._should_comment(event):
+            self._pending = event
 
     def add_chat(self, sender: str, text: str, is_ai: bool = False):
         self.chat_buffer.append({
@@ -74,54 +93,51 @@ class BounceCommentator:
 
     # -- internals --
 
-    async def _process_loop(self):
-        while not self._stopped:
-            try:
-                event = await asyncio.wait_for(self._queue.get(), timeout=120)
-            except asyncio.TimeoutError:
-                if self.attendees:
-                    event = {"type": "inactivity_check"}
-                else:
-                    continue
-            except asyncio.CancelledError:
-                break
-
-            if not settings.GROQ_API_KEY:
-                continue
-
-            now = time.time()
-            if now - self.last_ai_time < self.min_interval:
-                continue
-
-            if not self._should_comment(event):
-                continue
-
-            try:
-                commentary = await self._generate(event)
-                if commentary:
-                    self.last_ai_time = time.time()
-                    self.add_chat("Bounce AI", commentary, is_ai=True)
-                    await self._send(self.bounce_id, {
-                        "type": "chat_message",
-                        "sender": "Bounce AI",
-                        "text": commentary,
-                        "is_ai": True,
-                        "timestamp": self.last_ai_time,
-                    })
-                    if self._persist:
-                        try:
-                            await self._persist(self.bounce_id, commentary)
-                        except Exception as e:
-                            logger.warning(f"AI chat persist failed for bounce {self.bounce_id}: {e}")
-            except Exception as e:
-                logger.error(f"AI commentary error for bounce {self.bounce_id}: {e}")
+    def _due(self, now: float) -> Optional[dict]:
+        """The event to comment on now, if any (called by the scheduler)."""
+        if self._stopped or self._generating is not None:
+            return None
+        if self._pending is None and self.attendees and now - self.last_event_time >= INACTIVITY_SECONDS:
+            self.last_event_time = now
+            event = {"type": "inactivity_check"}
+            if self._should_comment(event):
+                self._pending = event
+        if self._pending is None or now - self.last_ai_time < self.min_interval:
+            return None
+        event, self._pending = self._pending, None
+        return event
+
+    async def _comment(self, event: dict):
+        try:
+            commentary = await self._generate(event)
+            if commentary and not self._stopped:
+                self.last_ai_time = time.time()
+                self.add_chat("Bounce AI", commentary, is_ai=True)
+                await self._send(self.bounce_id, {
+                    "type": "chat_message",
+                    "sender": "Bounce AI",
+                    "text": commentary,
+                    "is_ai": True,
+                    "timestamp": self.last_ai_time,
+                })
+                if self._persist:
+                    try:
+                        await self._persist(self.bounce_id, commentary)
+                    except Exception as e:
+                        logger.warning(f"AI chat persist failed for bounce {self.bounce_id}: {e}")
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            logger.error(f"AI commentary error for bounce {self.bounce_id}: {e}")
+        finally:
+            self._generating = None
 
     def _should_comment(self, event: dict) -> bool:
         t = event.get("type")
         if t in ("join", "leave", "chat"):
             return True
         if t == "inactivity_check":
-            return time.time() - self.last_ai_time > 120
+            return time.time() - self.last_ai_time > INACTIVITY_SECONDS
         if t == "location_update":
             return event.get("arrived_at_venue", False)
         return False
@@ -130,26 +146,12 @@ class BounceCommentator:
         system = self._system_prompt()
         user = self._event_prompt(event)
 
-        async with httpx.AsyncClient(timeout=10) as client:
-            resp = await client.post(
-                "https://api.groq.com/openai/v1/chat/completions",
-                headers={
-                    "Authorization": f"Bearer {settings.GROQ_API_KEY}",
-                    "Content-Type": "application/json",
-                },
-                json={
-                    "model": "llama-3.1-8b-instant",
-                    "max_tokens": 150,
-                    "messages": [
-                        {"role": "system", "content": system},
-                        {"role": "user", "content": user},
-                    ],
-                },
-            )
-            if resp.status_code != 200:
-                logger.warning(f"Groq API {resp.status_code}: {resp.text[:200]}")
-                return None
-            return resp.json()["choices"][0]["message"]["content"].strip()
+        return await llm.complete(
+            "commentator", system, user,
+            max_tokens=150,
+            priority=llm.PRIORITY_INTERACTIVE,
+            deadline_seconds=COMMENT_DEADLINE_SECONDS,
+        )
 
     def _system_prompt(self) -> str:
         names = [a["name"] for a in self.attendees.values()]
@@ -217,6 +219,37 @@ class BounceCommentator:
 
 # Global registry
 _commentators: dict[int, BounceCommentator] = {}
+_scheduler_task: Optional[asyncio.Task] = None
+
+
+async def _scheduler_loop():
+    while True:
+        try:
+            await asyncio.sleep(SCHEDULER_TICK_SECONDS)
+            if not settings.GROQ_API_KEY:
+                continue
+            now = time.time()
+            for c in list(_commentators.values()):
+                event = c._due(now)
+                if event is not None:
+                    c._generating = asyncio.create_task(c._comment(event))
+        except asyncio.CancelledError:
+            break
+        except Exception as e:
+            logger.error(f"AI commentator scheduler error: {e}")
+
+
+def _ensure_scheduler():
+    global _scheduler_task
+    if _scheduler_task is None or _scheduler_task.done():
+        _scheduler_task = asyncio.create_task(_scheduler_loop())
+
+
+async def stop_commentator_scheduler():
+    global _scheduler_task
+    if _scheduler_task is not None:
+        _scheduler_task.cancel()
+        _scheduler_task = None
 
 
 def get_or_create_commentator(
@@ -1,7 +1,14 @@
 """
 Apple Push Notification Service (APNs) handler for Basel Radar
 Uses httpx with HTTP/2 to avoid uvloop compatibility issues with aioapns
+
+Delivery is batched (send_bulk): preferences + active tokens for every
+recipient come from one query, badges from one Redis pipeline, and the POSTs
+are multiplexed as concurrent streams over the single HTTP/2 connection with
+at most APNS_SEND_CONCURRENCY in flight. Token bookkeeping (last_used_at,
+deactivating Unregistered/BadDeviceToken) is two bulk UPDATEs per batch.
 """
+import asyncio
 import base64
 import json
 import logging
@@ -28,6 +35,10 @@ logger = logging.getLogger(__name__)
 APNS_PRODUCTION_URL = "https://api.push.apple.com"
 APNS_SANDBOX_URL = "https://api.sandbox.push.apple.com"
 
+# Concurrent streams per batch; APNs allows ~1000 per connection, stay well under
+APNS_SEND_CONCURRENCY = 64
+INVALID_TOKEN_REASONS = ('BadDeviceToken', 'Unregistered', 'DeviceTokenNotForTopic')
+
 
 class NotificationType(str, Enum):
     NEW_FOLLOWER = "new_follower"
@@ -161,48 +172,37 @@ class APNsService:
         }
         return mapping.get(notification_type, "push_enabled")
 
-    async def _get_user_tokens(
+    async def _get_tokens_bulk(
         self,
         db: AsyncSession,
-        user_id: int,
+        user_ids: List[int],
         notification_type: NotificationType
-    ) -> List[DeviceToken]:
-        """Get active device tokens for user if notification type is enabled"""
-
-        # Check user's notification preferences
-        pref_result = await db.execute(
-            select(NotificationPreference).where(
-                NotificationPreference.user_id == user_id
+    ) -> Dict[int, List[str]]:
+        """user_id -> active device tokens, for users who have this notification
+        type enabled. One query for the whole batch (no preferences row means
+        everything is enabled)."""
+        if not user_ids:
+            return {}
+        pref_field = self._notification_type_to_preference_field(notification_type)
+        result = await db.execute(
+            select(
+                DeviceToken.user_id,
+                DeviceToken.device_token,
+                NotificationPreference.push_enabled,
+                getattr(NotificationPreference, pref_field),
             )
-        )
-        preferences = pref_result.scalar_one_or_none()
-
-        # If preferences exist, check if enabled
-        if preferences:
-            # Check master toggle
-            if not preferences.push_enabled:
-                logger.debug(f"Push disabled for user {user_id}")
-                return []
-
-            # Check specific notification type
-            pref_field = self._notification_type_to_preference_field(notification_type)
-            if not getattr(preferences, pref_field, True):
-                logger.debug(f"Notification type {notification_type} disabled for user {user_id}")
-                return []
-
-        # Get active device tokens
-        tokens_result = await db.execute(
-            select(DeviceToken).where(
-                DeviceToken.user_id == user_id
+            .outerjoin(NotificationPreference, NotificationPreference.user_id == DeviceToken.user_id)
+            .where(
+                DeviceToken.user_id.in_(user_ids),
+                DeviceToken.is_active == True
             )
         )
-        all_user_tokens = tokens_result.scalars().all()
-        logger.info(f"APNs: User {user_id} has {len(all_user_tokens)} total token(s) in DB")
-        for t in all_user_tokens:
-            logger.info(f"APNs:   - Token: {t.device_token[:20]}... active={t.is_active} sandbox={t.is_sandbox}")
-
-        active_tokens = [t for t in all_user_tokens if t.is_active]
-        return active_tokens
+        tokens: Dict[int, List[str]] = {}
+        for user_id, device_token, push_enabled, type_enabled in result.all():
+            if push_enabled is False or type_enabled is False:
+                continue
+            tokens.setdefault(user_id, []).append(device_token)
+        return tokens
 
     def _build_aps_payload(self, payload: NotificationPayload, badge_count: int = 1) -> Dict[str, Any]:
         """Build APNs payload with custom data"""
@@ -252,7 +252,7 @@ class APNsService:
             "data": custom_data
         }
 
-    async def _send_to_token(self, token: str, is_sandbox: bool, aps_payload: Dict[str, Any]) -> tuple[bool, Optional[str]]:
+    async def _send_to_token(self, token: str, aps_payload: Dict[str, Any]) -> tuple[bool, Optional[str]]:
         """Send notification to a single device token"""
         if not self._client or not self._private_key:
             return False, "APNs not initialized"
@@ -261,7 +261,6 @@ class APNsService:
         use_sandbox = settings.APNS_USE_SANDBOX
         base_url = APNS_SANDBOX_URL if use_sandbox else APNS_PRODUCTION_URL
         url = f"{base_url}/3/device/{token}"
-        logger.info(f"APNs: Sending to {'SANDBOX' if use_sandbox else 'PRODUCTION'} server")
 
         headers = {
             "authorization": f"bearer {self._get_jwt_token()}",
@@ -299,55 +298,77 @@ class APNsService:
         payload: NotificationPayload
     ) -> bool:
         """Send push notification to a user's devices"""
-        from services.redis import increment_badge_count
+        results = await self.send_bulk(db, [user_id], payload)
+        return results.get(user_id, False)
+
+    async def send_bulk(
+        self,
+        db: AsyncSession,
+        user_ids: List[int],
+        payload: NotificationPayload
+    ) -> Dict[int, bool]:
+        """Send the same notification to many users: O(1) DB and Redis round
+        trips per batch, sends multiplexed over the HTTP/2 client."""
+        from services.redis import increment_badge_counts
 
+        user_ids = list(dict.fromkeys(user_ids))
+        results = {uid: False for uid in user_ids}
         if not self._private_key:
             logger.warning("APNs not initialized - skipping push")
-            return False
-
-        device_tokens = await self._get_user_tokens(db, user_id, payload.notification_type)
-        logger.info(f"APNs: Found {len(device_tokens)} token(s) for user {user_id}")
-
-        if not device_tokens:
-            logger.warning(f"APNs: No active tokens for user {user_id} or notification disabled")
-            return False
-
-        # Increment badge count for user
-        badge_count = await increment_badge_count(user_id)
-        aps_payload = self._build_aps_payload(payload, badge_count)
-
-        success = False
-        for device_token in device_tokens:
-            sent, error = await self._send_to_token(
-                device_token.device_token,
-                device_token.is_sandbox,
-                aps_payload
-            )
-
+            return results
+
+        tokens = await self._get_tokens_bulk(db, user_ids, payload.notification_type)
+        if not tokens:
+            logger.debug(f"APNs: no active tokens for {len(user_ids)} user(s) or notification disabled")
+            return results
+
+        badges = await increment_badge_counts(list(tokens))
+        # One payload per distinct badge count — usually a handful per batch
+        aps_by_badge: Dict[int, Dict[str, Any]] = {}
+        window = asyncio.Semaphore(APNS_SEND_CONCURRENCY)
+
+        async def send(user_id: int, device_token: str):
+            badge = badges.get(user_id, 1)
+            aps = aps_by_badge.get(badge)
+            if aps is None:
+                aps = aps_by_badge[badge] = self._build_aps_payload(payload, badge)
+            async with window:
+                sent, error = await self._send_to_token(device_token, aps)
+            return user_id, device_token, sent, error
+
+        outcomes = await asyncio.gather(*(
+            send(uid, tok) for uid, toks in tokens.items() for tok in toks
+        ))
+
+        delivered, invalid = [], []
+        for user_id, device_token, sent, error in outcomes:
             if sent:
-                logger.info(f"Push sent to user {user_id}, token {device_token.device_token[:20]}...")
-                success = True
-
-                # Update last_used_at
-                await db.execute(
-                    update(DeviceToken)
-                    .where(DeviceToken.device_token == device_token.device_token)
-                    .values(last_used_at=datetime.now(timezone.utc))
-                )
+                results[user_id] = True
+                delivered.append(device_token)
             else:
                 logger.warning(f"Push failed for user {user_id}: {error}")
+                if error in INVALID_TOKEN_REASONS:
+                    invalid.append(device_token)
+
+        if delivered:
+            await db.execute(
+                update(DeviceToken)
+                .where(DeviceToken.device_token.in_(delivered))
+                .values(last_used_at=datetime.now(timezone.utc))
+            )
+        if invalid:
+            await db.execute(
+                update(DeviceToken)
+                .where(DeviceToken.device_token.in_(invalid))
+                .values(is_active=False)
+            )
+            logger.info(f"Deactivated {len(invalid)} invalid token(s)")
+        if delivered or invalid:
+            await db.commit()
 
-                # Handle invalid tokens
-                if error in ['BadDeviceToken', 'Unregistered', 'DeviceTokenNotForTopic']:
-                    await db.execute(
-                        update(DeviceToken)
-                        .where(DeviceToken.device_token == device_token.device_token)
-                        .values(is_active=False)
-                    )
-                    logger.info(f"Deactivated invalid token for user {user_id}")
-
-        await db.commit()
-        return success
+        logger.info(f"APNs {payload.notification_type.value}: {len(delivered)}/{len(outcomes)} "
+                    f"token(s) delivered for {len(user_ids)} user(s)")
+        return results
 
     async def send_to_multiple_users(
         self,
@@ -356,69 +377,62 @@ class APNsService:
         payload: NotificationPayload
     ) -> Dict[int, bool]:
         """Send notification to multiple users"""
-        results = {}
-        for user_id in user_ids:
-            results[user_id] = await self.send_notification(db, user_id, payload)
-        return results
+        return await self.send_bulk(db, user_ids, payload)
 
-    async def send_silent_push(self, db: AsyncSession, user_id: int) -> bool:
-        """Send a silent push notification to wake the app in background for location broadcasting"""
-        if not self._private_key:
-            return False
+    async def send_silent_push_bulk(self, db: AsyncSession, user_ids: List[int]) -> int:
+        """Silent push to many users: one token query, concurrent sends, one
+        bulk deactivation. Returns how many users got at least one delivery."""
+        if not self._private_key or not user_ids:
+            return 0
 
-        # Get active device tokens directly (skip notification preference check)
         tokens_result = await db.execute(
-            select(DeviceToken).where(
-                DeviceToken.user_id == user_id,
+            select(DeviceToken.user_id, DeviceToken.device_token).where(
+                DeviceToken.user_id.in_(user_ids),
                 DeviceToken.is_active == True
             )
         )
-        device_tokens = tokens_result.scalars().all()
+        targets = tokens_result.all()
+        if not targets:
+            return 0
 
-        if not device_tokens:
-            return False
-
-        silent_payload = {
-            "aps": {
-                "content-available": 1
-            },
-            "type": "location_wake"
-        }
-
-        success = False
-        for device_token in device_tokens:
-            base_url = APNS_SANDBOX_URL if settings.APNS_USE_SANDBOX else APNS_PRODUCTION_URL
-            url = f"{base_url}/3/device/{device_token.device_token}"
+        base_url = APNS_SANDBOX_URL if settings.APNS_USE_SANDBOX else APNS_PRODUCTION_URL
+        body = json.dumps({"aps": {"content-available": 1}, "type": "location_wake"})
+        window = asyncio.Semaphore(APNS_SEND_CONCURRENCY)
 
+        async def send(device_token: str) -> Optional[str]:
             headers = {
                 "authorization": f"bearer {self._get_jwt_token()}",
                 "apns-topic": settings.APNS_BUNDLE_ID,
                 "apns-push-type": "background",
                 "apns-priority": "5",
+                "content-type": "application/json",
             }
-
+            async with window:
+                try:
+                    response = await self._client.post(
+                        f"{base_url}/3/device/{device_token}", content=body, headers=headers
+                    )
+                except Exception as e:
+                    logger.error(f"Silent push error: {e}")
+                    return "error"
+            if response.status_code == 200:
+                return None
             try:
-                response = await self._client.post(url, json=silent_payload, headers=headers)
-                if response.status_code == 200:
-                    success = True
-                else:
-                    try:
-                        error_data = response.json()
-                        reason = error_data.get("reason", "Unknown")
-                    except:
-                        reason = f"HTTP {response.status_code}"
-
-                    if reason in ['BadDeviceToken', 'Unregistered', 'DeviceTokenNotForTopic']:
-                        await db.execute(
-                            update(DeviceToken)
-                            .where(DeviceToken.device_token == device_token.device_token)
-                            .values(is_active=False)
-                        )
-            except Exception as e:
-                logger.error(f"Silent push error for user {user_id}: {e}")
-
-        await db.commit()
-        return success
+                return response.json().get("reason", "Unknown")
+            except Exception:
+                return f"HTTP {response.status_code}"
+
+        errors = await asyncio.gather(*(send(tok) for _, tok in targets))
+        delivered = {uid for (uid, _), err in zip(targets, errors) if err is None}
+        invalid = [tok for (_, tok), err in zip(targets, errors) if err in INVALID_TOKEN_REASONS]
+        if invalid:
+            await db.execute(
+                update(DeviceToken)
+                .where(DeviceToken.device_token.in_(invalid))
+                .values(is_active=False)
+            )
+            await db.commit()
+        return len(delivered)
 
 
 # Singleton accessor
@@ -0,0 +1,241 @@
+"""Content-addressed blob store for user-uploaded images.
+
+Profile pictures and venue-feed images used to live in Postgres as base64
+data URIs, so every `select(User)` hauled megabytes of text and /img had to
+re-decode it. Now the bytes are stored once under their SHA-256 and rows keep
+a short reference — the URL path the image is served from:
+
+    /img/blob/<sha256>.<ext>          original upload
+    /img/blob/<sha256>.thumb.jpg      THUMB_PX JPEG thumbnail, made at upload
+    /img/blob/<sha256>.w<px>.<ext>    resized / re-encoded variant, made on
+                                      first request (api/routes/images.py)
+
+Blob names never change meaning (same name -> same bytes), so they are served
+with the name as a strong ETag and an immutable Cache-Control.
+
+Backends: local disk under settings.BLOB_DIR (default), or any S3-compatible
+bucket when BLOB_S3_BUCKET is set (needs boto3, imported lazily). Blocking
+I/O runs in a thread.
+"""
+
+import asyncio
+import base64
+import hashlib
+import io
+import logging
+import os
+import re
+from pathlib import Path
+from typing import Optional
+
+from core.config import settings
+
+logger = logging.getLogger(__name__)
+
+BLOB_URL_PREFIX = "/img/blob/"
+THUMB_PX = 256
+THUMB_SUFFIX = ".thumb.jpg"
+
+_EXT_BY_TYPE = {
+    "image/jpeg": "jpg",
+    "image/jpg": "jpg",
+    "image/png": "png",
+    "image/webp": "webp",
+    "image/gif": "gif",
+    "image/heic": "heic",
+}
+_TYPE_BY_EXT = {"jpg": "image/jpeg", "png": "image/png", "webp": "image/webp",
+                "gif": "image/gif", "heic": "image/heic"}
+
+# <64 hex>.<ext>, <64 hex>.thumb.jpg or <64 hex>.w<px>.<ext> — nothing else is a valid name
+_NAME_RE = re.compile(r"^[0-9a-f]{64}(\.thumb|\.w\d{2,4})?\.[a-z0-9]{2,5}$")
+# Formats a variant can be re-encoded to without an explicit ?fmt=
+_VARIANT_EXTS = ("jpg", "png", "webp")
+
+
+def is_blob_ref(value: Optional[str]) -> bool:
+    return bool(value) and value.startswith(BLOB_URL_PREFIX)
+
+
+def name_from_ref(ref: str) -> str:
+    return ref[len(BLOB_URL_PREFIX):]
+
+
+def content_type_for(name: str) -> str:
+    return _TYPE_BY_EXT.get(name.rsplit(".", 1)[-1], "application/octet-stream")
+
+
+def etag_for(name: str) -> str:
+    """Strong ETag: the name itself (thumbnails and variants are a pure
+    function of the content hash plus their suffix)."""
+    return f'"{name}"'
+
+
+def variant_name(name: str, width: Optional[int], fmt: Optional[str]) -> Optional[str]:
+    """Blob name of the `width` / `fmt` variant of original `name`, or None
+    when that would just be the original (or `name` is not an original)."""
+    if name.endswith(THUMB_SUFFIX) or ".w" in name:
+        return None
+    digest, ext = name.split(".", 1)
+    if fmt:
+        out_ext = "jpg" if fmt == "jpeg" else fmt
+    else:
+        out_ext = ext if ext in _VARIANT_EXTS else "jpg"
+    if not width and out_ext == ext:
+        return None
+    return f"{digest}{f'.w{width}' if width else ''}.{out_ext}"
+
+
+# ---------------------------------------------------------------- backends
+
+
+class _LocalBackend:
+    def __init__(self, root: str):
+        self.root = Path(root)
+
+    def path(self, name: str) -> Path:
+        # Two-level fan-out keeps directories small
+        return self.root / name[:2] / name[2:4] / name
+
+    def exists(self, name: str) -> bool:
+        return self.path(name).exists()
+
+    def put(self, name: str, data: bytes, content_type: str) -> None:
+        dest = self.path(name)
+        if dest.exists():
+            return
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        tmp = dest.with_name(f".{name}.{os.getpid()}")
+        tmp.write_bytes(data)
+        os.replace(tmp, dest)
+
+    def get(self, name: str) -> Optional[bytes]:
+        try:
+            return self.path(name).read_bytes()
+        except FileNotFoundError:
+            return None
+
+
+class _S3Backend:
+    def __init__(self):
+        import boto3  # optional dependency, only when BLOB_S3_BUCKET is set
+
+        self.bucket = settings.BLOB_S3_BUCKET
+        self.prefix = settings.BLOB_S3_PREFIX
+        self.client = boto3.client("s3", endpoint_url=settings.BLOB_S3_ENDPOINT or None)
+
+    def _key(self, name: str) -> str:
+        return f"{self.prefix}{name}"
+
+    def exists(self, name: str) -> bool:
+        try:
+            self.client.head_object(Bucket=self.bucket, Key=self._key(name))
+            return True
+        except Exception:
+            return False
+
+    def put(self, name: str, data: bytes, content_type: str) -> None:
+        if self.exists(name):
+            return
+        self.client.put_object(
+            Bucket=self.bucket, Key=self._key(name), Body=data, ContentType=content_type,
+            CacheControl="public, max-age=31536000, immutable",
+        )
+
+    def get(self, name: str) -> Optional[bytes]:
+        try:
+            obj = self.client.get_object(Bucket=self.bucket, Key=self._key(name))
+            return obj["Body"].read()
+        except Exception:
+            return None
+
+
+_backend = None
+
+
+def backend():
+    global _backend
+    if _backend is None:
+        _backend = _S3Backend() if settings.BLOB_S3_BUCKET else _LocalBackend(settings.BLOB_DIR)
+    return _backend
+
+
+def local_path(name: str) -> Optional[Path]:
+    """On-disk path when the local backend holds `name` (for zero-copy serving)."""
+    b = backend()
+    if isinstance(b, _LocalBackend):
+        p = b.path(name)
+        return p if p.exists() else None
+    return None
+
+
+# ---------------------------------------------------------------- API
+
+
+def _make_thumbnail(data: bytes) -> Optional[bytes]:
+    try:
+        from PIL import Image, ImageOps
+    except ImportError:
+        return None
+    try:
+        with Image.open(io.BytesIO(data)) as im:
+            im = ImageOps.exif_transpose(im)
+            im.thumbnail((THUMB_PX, THUMB_PX))
+            out = io.BytesIO()
+            im.convert("RGB").save(out, "JPEG", quality=80, optimize=True)
+            return out.getvalue()
+    except Exception as e:
+        logger.warning(f"Thumbnail generation failed: {e}")
+        return None
+
+
+def image_name(data: bytes, content_type: str) -> str:
+    """Content-addressed blob name put_image stores `data` under."""
+    ext = _EXT_BY_TYPE.get(content_type.lower(), "jpg")
+    return f"{hashlib.sha256(data).hexdigest()}.{ext}"
+
+
+def _put_image_sync(data: bytes, content_type: str) -> str:
+    name = image_name(data, content_type)
+    digest = name.split(".", 1)[0]
+    b = backend()
+    if not b.exists(name):
+        b.put(name, data, content_type)
+        thumb = _make_thumbnail(data)
+        if thumb is not None:
+            b.put(digest + THUMB_SUFFIX, thumb, "image/jpeg")
+    return BLOB_URL_PREFIX + name
+
+
+async def put_image(data: bytes, content_type: str) -> str:
+    """Store an uploaded image (+ thumbnail). Returns the ref to put in the row."""
+    return await asyncio.to_thread(_put_image_sync, data, content_type)
+
+
+async def get_blob(name: str) -> Optional[bytes]:
+    if not _NAME_RE.match(name):
+        return None
+    return await asyncio.to_thread(backend().get, name)
+
+
+async def put_blob(name: str, data: bytes, content_type: str) -> None:
+    """Store derived bytes (a variant) under a precomputed valid name."""
+    if not _NAME_RE.match(name):
+        raise ValueError(f"invalid blob name: {name}")
+    await asyncio.to_thread(backend().put, name, data, content_type)
+
+
+def parse_data_uri(uri: str) -> tuple[Optional[bytes], Optional[str]]:
+    """Decode a legacy `data:<type>;base64,...` column value."""
+    try:
+        header, b64 = uri.split(",", 1)
+        content_type = "image/jpeg"
+        if header.startswith("data:") and ";" in header:
+            content_type = header[5:].split(";")[0] or "image/jpeg"
+        return base64.b64decode(b64), content_type
+    except Exception:
+        return None, None
+
+
+def valid_name(name: str) -> bool:
+    return bool(_NAME_RE.match(name))
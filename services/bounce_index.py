@@ -0,0 +1,137 @@
+"""Spatial index + cached visibility sets for the bounce map.
+
+The map used to load every active public/invited/created bounce, count invites
+with a correlated subquery per row, and radius-filter in Python. Now:
+
+    bounces:geo:public      GEO set of active public bounce ids
+    bounces:geo:built       marker; when missing the GEO set is rebuilt
+    bounces:visible:<uid>   cached ids of active bounces uid created / is invited to
+
+`public_within` is a GEOSEARCH, the personal set is one cache read, and the
+rows themselves are a primary-key IN (...) load. The GEO set is maintained by
+index_bounce / unindex_bounce on create / archive / delete and fully rebuilt
+every REBUILD_SECONDS (and whenever the marker is gone, e.g. after a Redis
+flush) to heal paths that bypass it — account deletion cascades, scripts.
+Stale ids are harmless: callers still filter on status = 'active'.
+
+Personal sets are invalidated by the handlers that change them: per user
+(invalidate_visible) when someone gains a bounce — create, invite — or loses
+one — invite removal; per bounce (invalidate_bounce, via the `bounce:<id>`
+cache tag every set containing it is registered under) on archive / delete.
+
+Every function degrades: a None return means "index unavailable, use SQL".
+"""
+
+import logging
+from typing import Iterable, Optional
+
+from sqlalchemy import or_, select
+from sqlalchemy.ext.asyncio import AsyncSession
+
+from db.models import Bounce, BounceInvite
+from services.cache import cache_delete, cache_get, cache_invalidate_tags, cache_set
+from services.redis import circuit_is_open, get_redis
+
+logger = logging.getLogger(__name__)
+
+GEO_KEY = "bounces:geo:public"
+BUILT_KEY = "bounces:geo:built"
+REBUILD_LOCK_KEY = "locks:bounces_geo_rebuild"
+VISIBLE_KEY = "bounces:visible:{user_id}"
+
+REBUILD_SECONDS = 3600
+VISIBLE_TTL = 300
+MAX_RESULTS = 2000
+
+
+async def index_bounce(bounce: Bounce) -> None:
+    """Add or drop one bounce in the GEO set according to its current state."""
+    try:
+        r = await get_redis()
+        if bounce.status == 'active' and bounce.is_public:
+            await r.geoadd(GEO_KEY, (bounce.longitude, bounce.latitude, bounce.id))
+        else:
+            await r.zrem(GEO_KEY, bounce.id)
+    except Exception as e:
+        logger.warning(f"Bounce geo index update failed for {bounce.id}: {e}")
+
+
+async def unindex_bounce(bounce_id: int) -> None:
+    try:
+        r = await get_redis()
+        await r.zrem(GEO_KEY, bounce_id)
+    except Exception as e:
+        logger.warning(f"Bounce geo index removal failed for {bounce_id}: {e}")
+
+
+async def rebuild(db: AsyncSession) -> int:
+    """Replace the GEO set from Postgres. Returns the indexed count."""
+    result = await db.execute(
+        select(Bounce.id, Bounce.latitude, Bounce.longitude)
+        .where(Bounce.status == 'active', Bounce.is_public == True)
+    )
+    rows = result.all()
+    r = await get_redis()
+    pipe = r.pipeline(transaction=True)
+    pipe.delete(GEO_KEY)
+    if rows:
+        pipe.geoadd(GEO_KEY, [v for row in rows for v in (row.longitude, row.latitude, row.id)])
+    pipe.setex(BUILT_KEY, REBUILD_SECONDS, "1")
+    await pipe.execute()
+    return len(rows)
+
+
+async def _ensure_built(db: AsyncSession) -> None:
+    r = await get_redis()
+    if await r.exists(BUILT_KEY):
+        return
+    if await r.set(REBUILD_LOCK_KEY, "1", nx=True, ex=60):
+        count = await rebuild(db)
+        logger.info(f"Bounce geo index rebuilt: {count} public bounces")
+
+
+async def public_within(db: AsyncSession, lat: float, lng: float, radius_km: float) -> Optional[list[int]]:
+    """Ids of active public bounces within radius_km, nearest first; None if
+    the index is unavailable."""
+    if circuit_is_open():
+        return None
+    try:
+        await _ensure_built(db)
+        r = await get_redis()
+        members = await r.geosearch(GEO_KEY, longitude=lng, latitude=lat, radius=radius_km,
+                                    unit="km", sort="ASC", count=MAX_RESULTS)
+        return [int(m) for m in members]
+    except Exception as e:
+        logger.warning(f"Bounce geo search failed: {e}")
+        return None
+
+
+async def visible_ids(db: AsyncSession, user_id: int) -> list[int]:
+    """Active bounces user_id created or is invited to (any invite status —
+    same rule the map has always used), cached for VISIBLE_TTL."""
+    key = VISIBLE_KEY.format(user_id=user_id)
+    cached = await cache_get(key)
+    if cached is not None:
+        return cached
+    result = await db.execute(
+        select(Bounce.id).where(
+            Bounce.status == 'active',
+            or_(
+                Bounce.creator_id == user_id,
+                Bounce.id.in_(select(BounceInvite.bounce_id).where(BounceInvite.user_id == user_id))
+            )
+        )
+    )
+    ids = [row[0] for row in result.all()]
+    await cache_set(key, ids, ttl=VISIBLE_TTL, tags=[f"bounce:{bid}" for bid in ids])
+    return ids
+
+
+async def invalidate_visible(user_ids: Iterable[int]) -> None:
+    for user_id in set(user_ids):
+        await cache_delete(VISIBLE_KEY.format(user_id=user_id))
+
+
+async def invalidate_bounce(bounce_id: int) -> None:
+    """Drop every cached personal set that contains bounce_id."""
+    await cache_invalidate_tags(f"bounce:{bounce_id}")
@@ -8,12 +8,21 @@ Rules learned the hard way:
   can serve a stale value instantly and refresh in the background.
 - single_flight(key) hands out a per-key asyncio.Lock so concurrent misses
   don't stampede the upstream.
+- Hot, rarely-changing namespaces (L1_PREFIXES) also sit in a per-process
+  LRU in front of Redis. Entries live at most the prefix's cap; deletes are
+  published on CACHE_INVALIDATION_CHANNEL so every worker drops its copy.
+  An overwrite without a delete (SWR refresh) is only bounded by the cap.
+  cache_stats() reports L1 / Redis / miss counts per namespace.
+- Group invalidation is by tag, never by key pattern: cache_set(..., tags=)
+  adds the key to `cache:tag:<tag>` sets and cache_invalidate_tags deletes
+  exactly those members in one pipeline — no SCAN over the keyspace.
 """
 
 import asyncio
 import json
 import logging
 import time
+from collections import OrderedDict
 from typing import Any, Optional
 
 from services.redis import (
@@ -27,6 +36,18 @@ logger = logging.getLogger(__name__)
 
 DEFAULT_TTL = 86400  # 1 day
 
+# key prefix -> max seconds an entry may be served from L1
+L1_PREFIXES = {
+    "venue_count:": 15,
+    "place_details:": 300,
+    "user_stats:": 30,
+    "bounces:visible:": 30,
+}
+L1_MAX_ITEMS = 10000
+CACHE_INVALIDATION_CHANNEL = "cache:invalidate"
+
+TAG_KEY = "cache:tag:{tag}"
+
 _LOG_INTERVAL = 60.0
 _last_error_log = 0.0
 
@@ -39,10 +60,121 @@ def _log_error(op: str, e: Exception):
         logger.warning(f"Redis cache {op} failed: {e}")
 
 
+# ---------- L1 (per-process) ----------
+
+_l1: "OrderedDict[str, tuple[float, str]]" = OrderedDict()
+_stats: dict[str, dict[str, int]] = {}
+_invalidation_task: Optional[asyncio.Task] = None
+
+
+def _namespace(key: str) -> str:
+    return key.split(":", 1)[0]
+
+
+def _count(key: str, outcome: str) -> None:
+    ns = _stats.get(_namespace(key))
+    if ns is None:
+        ns = _stats[_namespace(key)] = {"l1": 0, "redis": 0, "miss": 0}
+    ns[outcome] += 1
+
+
+def _l1_cap(key: str) -> Optional[int]:
+    for prefix, cap in L1_PREFIXES.items():
+        if key.startswith(prefix):
+            return cap
+    return None
+
+
+def _l1_get(key: str) -> Optional[str]:
+    item = _l1.get(key)
+    if item is None:
+        return None
+    if item[0] < time.monotonic():
+        del _l1[key]
+        return None
+    _l1.move_to_end(key)
+    return item[1]
+
+
+def _l1_put(key: str, raw: str, ttl: Optional[int] = None) -> None:
+    cap = _l1_cap(key)
+    if cap is None or _invalidation_task is None:
+        return  # no listener, no coherence: never serve from L1
+    _l1[key] = (time.monotonic() + min(cap, ttl or cap), raw)
+    _l1.move_to_end(key)
+    while len(_l1) > L1_MAX_ITEMS:
+        _l1.popitem(last=False)
+
+
+def _l1_drop(keys) -> None:
+    for key in keys:
+        _l1.pop(key, None)
+
+
+async def _publish_invalidation(keys: list) -> None:
+    """One message, newline-separated keys (only the ones L1 may hold)."""
+    keys = [k for k in keys if _l1_cap(k) is not None]
+    if not keys:
+        return
+    try:
+        redis = await get_redis()
+        await redis.publish(CACHE_INVALIDATION_CHANNEL, "\n".join(keys))
+    except Exception as e:
+        _log_error("invalidation publish", e)
+
+
+async def _invalidation_loop():
+    while True:
+        try:
+            redis = await get_redis()
+            pubsub = redis.pubsub()
+            await pubsub.subscribe(CACHE_INVALIDATION_CHANNEL)
+            # Anything cached before (re)subscribing may have missed a delete
+            _l1.clear()
+            async for msg in pubsub.listen():
+                if msg["type"] == "message":
+                    _l1_drop(msg["data"].split("\n"))
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            logger.warning(f"Cache invalidation listener error, reconnecting: {e}")
+            _l1.clear()
+            await asyncio.sleep(1)
+
+
+async def start_invalidation_listener():
+    global _invalidation_task
+    if _invalidation_task is None:
+        _invalidation_task = asyncio.create_task(_invalidation_loop())
+
+
+async def stop_invalidation_listener():
+    global _invalidation_task
+    if _invalidation_task is not None:
+        _invalidation_task.cancel()
+        _invalidation_task = None
+
+
+def cache_stats() -> dict:
+    """Per-namespace hit counts since start, plus L1 occupancy."""
+    out = {}
+    for ns, c in sorted(_stats.items()):
+        total = c["l1"] + c["redis"] + c["miss"]
+        out[ns] = {**c, "hit_rate": round((c["l1"] + c["redis"]) / total, 3) if total else 0.0}
+    return {"l1_items": len(_l1), "namespaces": out}
+
+
+# ---------- Redis (shared) ----------
+
 async def cache_get(key: str, reset_ttl: bool = False) -> Optional[Any]:
     """Get JSON value from cache. Returns None if missing or Redis unavailable.
     reset_ttl is opt-in ONLY (sliding expiry to DEFAULT_TTL) — never default."""
+    raw = _l1_get(key)
+    if raw is not None:
+        _count(key, "l1")
+        return json.loads(raw)
     if circuit_is_open():
+        _count(key, "miss")
         return None
     try:
         redis = await get_redis()
@@ -51,7 +183,10 @@ async def cache_get(key: str, reset_ttl: bool = False) -> Optional[Any]:
         if value:
             if reset_ttl:
                 await redis.expire(key, DEFAULT_TTL)
+            _l1_put(key, value)
+            _count(key, "redis")
             return json.loads(value)
+        _count(key, "miss")
         return None
     except Exception as e:
         record_failure()
@@ -59,49 +194,72 @@ async def cache_get(key: str, reset_ttl: bool = False) -> Optional[Any]:
         return None
 
 
-async def cache_set(key: str, value: Any, ttl: int = DEFAULT_TTL) -> None:
-    """Set value in cache with TTL in seconds (default 1 day)."""
+async def cache_set(key: str, value: Any, ttl: int = DEFAULT_TTL, tags: Optional[list] = None) -> None:
+    """Set value in cache with TTL in seconds (default 1 day). `tags` register
+    the key for cache_invalidate_tags."""
     if circuit_is_open():
         return
     try:
+        raw = json.dumps(value)
         redis = await get_redis()
-        await redis.setex(key, ttl, json.dumps(value))
+        if tags:
+            pipe = redis.pipeline(transaction=False)
+            pipe.setex(key, ttl, raw)
+            for tag in set(tags):
+                tag_key = TAG_KEY.format(tag=tag)
+                pipe.sadd(tag_key, key)
+                # Outlive every member; members that expired first are harmless
+                pipe.expire(tag_key, max(ttl, DEFAULT_TTL))
+            await pipe.execute()
+        else:
+            await redis.setex(key, ttl, raw)
         record_success()
+        _l1_put(key, raw, ttl)
     except Exception as e:
         record_failure()
         _log_error("set", e)
 
 
 async def cache_delete(key: str) -> None:
-    """Delete a single cache key"""
+    """Delete a single cache key (and every worker's L1 copy)"""
+    _l1_drop([key])
     if circuit_is_open():
         return
     try:
         redis = await get_redis()
         await redis.delete(key)
         record_success()
+        await _publish_invalidation([key])
     except Exception as e:
         record_failure()
         _log_error("delete", e)
 
 
-async def cache_delete_pattern(pattern: str) -> None:
-    """Delete all keys matching pattern (e.g., 'user_stats:*')"""
-    if circuit_is_open():
-        return
+async def cache_invalidate_tags(*tags: str) -> int:
+    """Delete every key registered under any of `tags` (plus the tag sets).
+    Two pipelined round trips regardless of keyspace size. Returns keys hit."""
+    if not tags or circuit_is_open():
+        return 0
     try:
         redis = await get_redis()
-        cursor = 0
-        while True:
-            cursor, keys = await redis.scan(cursor, match=pattern, count=100)
-            if keys:
-                await redis.delete(*keys)
-            if cursor == 0:
-                break
+        tag_keys = [TAG_KEY.format(tag=tag) for tag in tags]
+        pipe = redis.pipeline(transaction=False)
+        for tag_key in tag_keys:
+            pipe.smembers(tag_key)
+        keys = sorted({k for members in await pipe.execute() for k in members})
+        pipe = redis.pipeline(transaction=False)
+        if keys:
+            pipe.delete(*keys)
+        pipe.delete(*tag_keys)
+        await pipe.execute()
         record_success()
+        _l1_drop(keys)
+        await _publish_invalidation(keys)
+        return len(keys)
     except Exception as e:
         record_failure()
-        _log_error("delete_pattern", e)
+        _log_error("invalidate_tags", e)
+        return 0
 
 
 # ---------- stale-while-revalidate ----------
@@ -115,10 +273,10 @@ async def cache_get_swr(key: str) -> tuple[Optional[Any], bool]:
     return envelope["v"], time.time() > envelope.get("e", 0)
 
 
-async def cache_set_swr(key: str, value: Any, ttl: int, grace: int = 3600) -> None:
+async def cache_set_swr(key: str, value: Any, ttl: int, grace: int = 3600, tags: Optional[list] = None) -> None:
     """Store with a freshness horizon of `ttl` seconds; the entry survives an
     extra `grace` seconds during which it is served as stale."""
-    await cache_set(key, {"v": value, "e": time.time() + ttl}, ttl=ttl + grace)
+    await cache_set(key, {"v": value, "e": time.time() + ttl}, ttl=ttl + grace, tags=tags)
 
 
 # ---------- single-flight ----------
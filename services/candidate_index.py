@@ -0,0 +1,170 @@
+"""Maximum-inner-product candidate indexes for recsys serving.
+
+Built once per model rebuild over the venue factor matrices (MF `Y`, graph
+`GV`) and queried per request with the user's vector. Three backends behind
+one interface:
+
+- BruteForceIndex — exact `V @ q` + argpartition. The fallback, and what
+  runs whenever the catalogue is small enough that an index isn't worth it.
+- IVFIndex — numpy inverted file: k-means the rows into ~sqrt(n) cells,
+  probe the `nprobe` cells whose centroids score best against q, and score
+  only their members exactly. Pure arrays (centroids / order / offsets), so
+  it snapshots and memory-maps like any other model array.
+- FaissIndex — HNSW over inner product when `faiss` happens to be
+  installed; never required.
+
+`build_index` picks the backend. `recall_vs_exact` is the offline check
+`_evaluate` runs so an approximate index can never silently degrade recall.
+"""
+
+import logging
+from typing import Optional
+
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+ANN_MIN_ITEMS = 2000        # below this brute force is already sub-millisecond
+IVF_NPROBE = 8
+IVF_KMEANS_ITERS = 10
+FAISS_HNSW_M = 32
+FAISS_EF_SEARCH = 64
+
+try:
+    import faiss  # type: ignore
+except ImportError:
+    faiss = None
+
+
+def _top_k(scores: np.ndarray, k: int) -> np.ndarray:
+    k = min(k, scores.shape[0])
+    if k <= 0:
+        return np.zeros(0, dtype=np.int64)
+    return np.argpartition(-scores, k - 1)[:k]
+
+
+class CandidateIndex:
+    """Interface: `search(q, k)` -> item row indices (unordered) with the
+    highest inner product against q."""
+
+    kind = "base"
+
+    def __init__(self, vectors: np.ndarray):
+        self.vectors = vectors
+
+    def __len__(self) -> int:
+        return self.vectors.shape[0]
+
+    def search(self, q: np.ndarray, k: int) -> np.ndarray:
+        raise NotImplementedError
+
+
+class BruteForceIndex(CandidateIndex):
+    kind = "brute_force"
+
+    def search(self, q: np.ndarray, k: int) -> np.ndarray:
+        return _top_k(self.vectors @ q, k)
+
+
+class IVFIndex(CandidateIndex):
+    kind = "ivf"
+
+    def __init__(self, vectors: np.ndarray, centroids: np.ndarray,
+                 order: np.ndarray, offsets: np.ndarray, nprobe: int = IVF_NPROBE):
+        super().__init__(vectors)
+        self.centroids = centroids      # (n_cells, d)
+        self.order = order              # item rows grouped by cell
+        self.offsets = offsets          # cell c owns order[offsets[c]:offsets[c+1]]
+        self.nprobe = nprobe
+
+    @classmethod
+    def build(cls, vectors: np.ndarray, n_cells: Optional[int] = None,
+              seed: int = 3) -> "IVFIndex":
+        n = vectors.shape[0]
+        n_cells = n_cells or max(1, int(np.sqrt(n)))
+        rng = np.random.default_rng(seed)
+        centroids = vectors[rng.choice(n, size=n_cells, replace=False)].copy()
+        assign = np.zeros(n, dtype=np.int64)
+        for _ in range(IVF_KMEANS_ITERS):
+            # squared L2 up to a per-row constant: |c|^2 - 2 v.c
+            d = (centroids * centroids).sum(axis=1)[None, :] - 2.0 * (vectors @ centroids.T)
+            assign = d.argmin(axis=1)
+            counts = np.bincount(assign, minlength=n_cells)
+            sums = np.zeros_like(centroids)
+            np.add.at(sums, assign, vectors)
+            nonempty = counts > 0
+            centroids[nonempty] = sums[nonempty] / counts[nonempty, None]
+        order = np.argsort(assign, kind="stable")
+        offsets = np.zeros(n_cells + 1, dtype=np.int64)
+        np.cumsum(np.bincount(assign, minlength=n_cells), out=offsets[1:])
+        return cls(vectors, centroids, order, offsets)
+
+    def search(self, q: np.ndarray, k: int) -> np.ndarray:
+        cells = _top_k(self.centroids @ q, self.nprobe)
+        members = np.concatenate([self.order[self.offsets[c]:self.offsets[c + 1]]
+                                  for c in cells])
+        if members.size < k:
+            # Probed cells too small to fill k: widen to the exact answer
+            return _top_k(self.vectors @ q, k)
+        return members[_top_k(self.vectors[members] @ q, k)]
+
+
+class FaissIndex(CandidateIndex):
+    kind = "faiss_hnsw"
+
+    def __init__(self, vectors: np.ndarray):
+        super().__init__(vectors)
+        self._index = faiss.IndexHNSWFlat(vectors.shape[1], FAISS_HNSW_M,
+                                          faiss.METRIC_INNER_PRODUCT)
+        self._index.hnsw.efSearch = FAISS_EF_SEARCH
+        self._index.add(np.ascontiguousarray(vectors, dtype=np.float32))
+
+    def search(self, q: np.ndarray, k: int) -> np.ndarray:
+        k = min(k, len(self))
+        _, ids = self._index.search(np.asarray(q, dtype=np.float32)[None, :], k)
+        ids = ids[0]
+        return ids[ids >= 0].astype(np.int64)
+
+
+def build_index(vectors: np.ndarray) -> CandidateIndex:
+    """Pick the cheapest backend that keeps the request path sub-millisecond."""
+    n = vectors.shape[0]
+    if n < ANN_MIN_ITEMS or vectors.ndim != 2 or vectors.shape[1] == 0:
+        return BruteForceIndex(vectors)
+    try:
+        if faiss is not None:
+            return FaissIndex(vectors)
+        return IVFIndex.build(vectors)
+    except Exception as e:
+        logger.warning(f"Candidate index build failed, using brute force: {e}")
+        return BruteForceIndex(vectors)
+
+
+def recall_vs_exact(index: CandidateIndex, queries: np.ndarray, k: int) -> Optional[float]:
+    """Mean |ANN top-k ∩ exact top-k| / k over the query rows."""
+    if isinstance(index, BruteForceIndex) or queries.shape[0] == 0 or len(index) == 0:
+        return None
+    k = min(k, len(index))
+    total = 0.0
+    for q in queries:
+        exact = set(_top_k(index.vectors @ q, k).tolist())
+        total += len(exact & set(index.search(q, k).tolist())) / k
+    return total / queries.shape[0]
+
+
+def index_state(index: CandidateIndex) -> tuple[str, dict[str, np.ndarray]]:
+    """(kind, arrays) needed to rebuild `index` over the same vectors —
+    what model snapshots persist next to the factor matrices."""
+    if isinstance(index, IVFIndex):
+        return index.kind, {"centroids": index.centroids, "order": index.order,
+                            "offsets": index.offsets}
+    return index.kind, {}
+
+
+def index_from_state(kind: str, vectors: np.ndarray,
+                     arrays: dict[str, np.ndarray]) -> CandidateIndex:
+    if kind == IVFIndex.kind and arrays:
+        return IVFIndex(vectors, arrays["centroids"], arrays["order"], arrays["offsets"])
+    if kind == FaissIndex.kind:
+        return build_index(vectors)     # HNSW graphs are cheap to rebuild per worker
+    return BruteForceIndex(vectors)
@@ -0,0 +1,79 @@
+"""Co-presence interval index over check-in history.
+
+Built once per matching fit from the CheckInHistory rows, it answers the
+two questions the fit keeps asking:
+
+- at_same_venue(u, v, t): were u and v checked into the same venue around
+  time t? Each user's stays are sorted by start, so this is a bisect plus a
+  scan bounded by that user's longest stay — O(log n) instead of walking
+  every stay either user ever had.
+- copresent_pairs(): every pair that overlapped at a venue for at least
+  `min_overlap` seconds, enumerated with one sweep-line pass per venue over
+  stays sorted by start (linear in history size; the active set is capped
+  so a packed superclub can't go quadratic).
+"""
+
+from bisect import bisect_right
+from collections import defaultdict
+from typing import Iterable, Iterator
+
+
+class CoPresenceIndex:
+    def __init__(self, stays: Iterable[tuple]):
+        """`stays`: (user_id, place_id, start_ts, end_ts) with end > start."""
+        by_user: dict[int, list] = defaultdict(list)
+        by_place: dict[str, list] = defaultdict(list)
+        for user_id, place_id, s, e in stays:
+            by_user[user_id].append((s, e, place_id))
+            by_place[place_id].append((s, e, user_id))
+
+        # user -> (starts, ends, places, longest stay), sorted by start
+        self._user: dict[int, tuple] = {}
+        for user_id, rows in by_user.items():
+            rows.sort(key=lambda r: r[0])
+            self._user[user_id] = (
+                [r[0] for r in rows], [r[1] for r in rows], [r[2] for r in rows],
+                max(r[1] - r[0] for r in rows),
+            )
+        # place -> [(start, end, user)] sorted by start
+        self._place: dict[str, list] = {}
+        for place_id, rows in by_place.items():
+            rows.sort(key=lambda r: r[0])
+            self._place[place_id] = rows
+
+    def __len__(self) -> int:
+        return sum(len(rows) for rows in self._place.values())
+
+    def places_at(self, user_id: int, t: float, slack: float) -> set:
+        """Venues where user_id's stay, widened by `slack`, contains t."""
+        entry = self._user.get(user_id)
+        if entry is None:
+            return set()
+        starts, ends, places, longest = entry
+        out = set()
+        # stays with start - slack <= t; earlier than t - slack - longest can't reach t
+        i = bisect_right(starts, t + slack) - 1
+        floor = t - slack - longest
+        while i >= 0 and starts[i] >= floor:
+            if ends[i] + slack >= t:
+                out.add(places[i])
+            i -= 1
+        return out
+
+    def at_same_venue(self, u: int, v: int, t: float, slack: float) -> bool:
+        places_u = self.places_at(u, t, slack)
+        return bool(places_u) and not places_u.isdisjoint(self.places_at(v, t, slack))
+
+    def copresent_pairs(self, min_overlap: float, max_active: int) -> Iterator[tuple]:
+        """Yield (place_id, u, v, together_since) per qualifying overlap,
+        u != v, in per-venue start order."""
+        for place_id, rows in self._place.items():
+            active: list = []
+            for (s, e, u) in rows:
+                active = [(vs, ve, v) for (vs, ve, v) in active if ve > s][-max_active:]
+                for (vs, ve, v) in active:
+                    if v == u:
+                        continue
+                    if min(e, ve) - max(s, vs) >= min_overlap:
+                        yield place_id, u, v, max(s, vs)
+                active.append((s, e, u))
@@ -0,0 +1,60 @@
+"""Minimal geohash encoding + neighbour cells for spatial WebSocket topics.
+
+Precision 4 cells are ~39 x 20 km: one launch city fits in a cell and its
+eight neighbours, while different cities never share one.
+"""
+
+_BASE32 = "0123456789bcdefghjkmnpqrstuvwxyz"
+
+GEO_CELL_PRECISION = 4
+
+
+def encode(lat: float, lon: float, precision: int = GEO_CELL_PRECISION) -> str:
+    lat_lo, lat_hi = -90.0, 90.0
+    lon_lo, lon_hi = -180.0, 180.0
+    out = []
+    bits, ch, even = 0, 0, True  # even bits refine longitude
+    while len(out) < precision:
+        if even:
+            mid = (lon_lo + lon_hi) / 2
+            if lon >= mid:
+                ch = (ch << 1) | 1
+                lon_lo = mid
+            else:
+                ch <<= 1
+                lon_hi = mid
+        else:
+            mid = (lat_lo + lat_hi) / 2
+            if lat >= mid:
+                ch = (ch << 1) | 1
+                lat_lo = mid
+            else:
+                ch <<= 1
+                lat_hi = mid
+        even = not even
+        bits += 1
+        if bits == 5:
+            out.append(_BASE32[ch])
+            bits, ch = 0, 0
+    return "".join(out)
+
+
+def _cell_size(precision: int) -> tuple[float, float]:
+    lon_bits = (5 * precision + 1) // 2
+    lat_bits = 5 * precision // 2
+    return 180.0 / (1 << lat_bits), 360.0 / (1 << lon_bits)
+
+
+def covering_cells(lat: float, lon: float, precision: int = GEO_CELL_PRECISION) -> list[str]:
+    """The cell containing (lat, lon) plus its eight neighbours (deduplicated
+    near the poles / antimeridian)."""
+    dlat, dlon = _cell_size(precision)
+    cells = []
+    for i in (-1, 0, 1):
+        for j in (-1, 0, 1):
+            nlat = max(-89.999999, min(89.999999, lat + i * dlat))
+            nlon = (lon + j * dlon + 180.0) % 360.0 - 180.0
+            cell = encode(nlat, nlon, precision)
+            if cell not in cells:
+                cells.append(cell)
+    return cells
@@ -0,0 +1,129 @@
+"""Resized / transcoded image variants for the /img endpoints.
+
+Clients ask for what they will actually draw (`?w=96&fmt=webp` for a map
+avatar) instead of the original upload or a full 800px Google photo. This
+module holds the pieces images.py tiers together:
+
+- snap_width / normalize_format: requested sizes snap up to VARIANT_WIDTHS so
+  a handful of variants per image exist, not one per pixel width
+- transcode: Pillow resize + re-encode, run in a thread
+- MemoryLRU: byte-bounded per-process L1 for hot avatars; entries expire
+  after L1_TTL_SECONDS since remote sources (user:<id>) can change behind a key
+- single_flight: concurrent misses for one key share one build
+"""
+
+import asyncio
+import io
+import logging
+import time
+from collections import OrderedDict
+from typing import Awaitable, Callable, Optional
+
+logger = logging.getLogger(__name__)
+
+VARIANT_WIDTHS = (48, 96, 160, 320, 640, 1080)
+VARIANT_FORMATS = {"webp": "image/webp", "jpeg": "image/jpeg", "jpg": "image/jpeg"}
+VARIANT_QUALITY = 80
+L1_MAX_BYTES = 64 * 1024 * 1024
+L1_MAX_ITEM_BYTES = 512 * 1024
+L1_TTL_SECONDS = 600
+
+
+def snap_width(w: Optional[int]) -> Optional[int]:
+    if not w or w <= 0:
+        return None
+    for width in VARIANT_WIDTHS:
+        if w <= width:
+            return width
+    return VARIANT_WIDTHS[-1]
+
+
+def normalize_format(fmt: Optional[str]) -> Optional[str]:
+    fmt = (fmt or "").lower()
+    if fmt == "jpg":
+        fmt = "jpeg"
+    return fmt if fmt in VARIANT_FORMATS else None
+
+
+def _transcode_sync(data: bytes, width: Optional[int], fmt: Optional[str]) -> Optional[tuple[bytes, str]]:
+    try:
+        from PIL import Image, ImageOps
+    except ImportError:
+        return None
+    try:
+        with Image.open(io.BytesIO(data)) as im:
+            im = ImageOps.exif_transpose(im)
+            if width and im.width > width:
+                im = im.resize((width, max(1, round(im.height * width / im.width))), Image.LANCZOS)
+            out_fmt = fmt or ("png" if im.format == "PNG" else "jpeg")
+            if out_fmt == "jpeg" and im.mode not in ("RGB", "L"):
+                im = im.convert("RGB")
+            out = io.BytesIO()
+            im.save(out, out_fmt.upper(), quality=VARIANT_QUALITY, optimize=True)
+            return out.getvalue(), VARIANT_FORMATS.get(out_fmt, f"image/{out_fmt}")
+    except Exception as e:
+        logger.warning(f"Image transcode failed: {e}")
+        return None
+
+
+async def transcode(data: bytes, width: Optional[int], fmt: Optional[str]) -> tuple[bytes, Optional[str]]:
+    """Variant bytes + content type, or the original when Pillow can't help."""
+    result = await asyncio.to_thread(_transcode_sync, data, width, fmt)
+    return result if result is not None else (data, None)
+
+
+class MemoryLRU:
+    def __init__(self, max_bytes: int = L1_MAX_BYTES, ttl: float = L1_TTL_SECONDS):
+        self.max_bytes = max_bytes
+        self.ttl = ttl
+        self.size = 0
+        self._items: "OrderedDict[str, tuple[bytes, str, float]]" = OrderedDict()
+
+    def get(self, key: str) -> Optional[tuple[bytes, str]]:
+        item = self._items.get(key)
+        if item is None:
+            return None
+        if item[2] < time.monotonic():
+            del self._items[key]
+            self.size -= len(item[0])
+            return None
+        self._items.move_to_end(key)
+        return item[0], item[1]
+
+    def put(self, key: str, data: bytes, content_type: str) -> None:
+        if len(data) > L1_MAX_ITEM_BYTES:
+            return
+        old = self._items.pop(key, None)
+        if old is not None:
+            self.size -= len(old[0])
+        self._items[key] = (data, content_type, time.monotonic() + self.ttl)
+        self.size += len(data)
+        while self.size > self.max_bytes and self._items:
+            _, (evicted, _, _) = self._items.popitem(last=False)
+            self.size -= len(evicted)
+
+
+_inflight: dict[str, asyncio.Future] = {}
+
+
+async def single_flight(key: str, build: Callable[[], Awaitable]):
+    """Run `build` once per key at a time; concurrent callers await its result."""
+    fut = _inflight.get(key)
+    if fut is not None:
+        return await asyncio.shield(fut)
+    fut = asyncio.get_running_loop().create_future()
+    _inflight[key] = fut
+    try:
+        result = await build()
+        fut.set_result(result)
+        return result
+    except asyncio.CancelledError:
+        fut.cancel()
+        raise
+    except Exception as e:
+        fut.set_exception(e)
+        # Nobody else may be awaiting; don't warn about an unretrieved exception
+        fut.exception()
+        raise
+    finally:
+        _inflight.pop(key, None)
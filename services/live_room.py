@@ -4,57 +4,158 @@ Viewer presence is a Redis ZSET per room (member = connection id, score =
 expiry timestamp) so counts stay correct across instances and survive dead
 connections. Reactions are ephemeral hearts — rate-limited per connection,
 broadcast to the room, never stored.
+
+Presence writes are aggregated per worker (`presence`): join / leave only
+touch local state, and a tick every TICK_SECONDS writes every pending change
+in one pipeline, recounts the rooms that changed and calls each room's
+on_count when its count moved — so counts go out at most once per room per
+tick, not on every join and leave. Every REFRESH_SECONDS the tick re-ZADDs
+all local connections (the heartbeat) and recounts all local rooms, which
+also picks up entries that expired on a dead instance. Other instances'
+viewers hear a count through on_count's cross-instance broadcast.
 """
 
 import asyncio
+import logging
 import time
+from typing import Awaitable, Callable, Optional
 
 from services.redis import get_redis
 
+logger = logging.getLogger(__name__)
+
 VIEWER_TTL_SECONDS = 60
+TICK_SECONDS = 1.0
+REFRESH_SECONDS = VIEWER_TTL_SECONDS // 2
 REACTION_MAX_PER_WINDOW = 30
 REACTION_WINDOW_SECONDS = 5.0
 REACTION_MAX_PER_FRAME = 20
 
 
-async def register_viewer(key: str, conn_id: str) -> int:
-    """Add a viewer connection to the room's ZSET. Returns the live count."""
-    redis = await get_redis()
-    now = time.time()
-    pipe = redis.pipeline()
-    pipe.zremrangebyscore(key, "-inf", now)
-    pipe.zadd(key, {conn_id: now + VIEWER_TTL_SECONDS})
-    pipe.expire(key, VIEWER_TTL_SECONDS * 2)
-    pipe.zcard(key)
-    results = await pipe.execute()
-    return int(results[3])
-
-
-async def refresh_viewer(key: str, conn_id: str):
-    redis = await get_redis()
-    now = time.time()
-    await redis.zadd(key, {conn_id: now + VIEWER_TTL_SECONDS})
-
-
-async def unregister_viewer(key: str, conn_id: str) -> int:
-    redis = await get_redis()
-    pipe = redis.pipeline()
-    pipe.zrem(key, conn_id)
-    pipe.zremrangebyscore(key, "-inf", time.time())
-    pipe.zcard(key)
-    results = await pipe.execute()
-    return int(results[2])
-
-
-async def viewer_refresh_loop(key: str, conn_id: str):
-    """Keep a connection's viewer entry alive. Clients may only ping at the
-    WS protocol level (never reaching receive_text), so refresh server-side."""
-    while True:
-        await asyncio.sleep(VIEWER_TTL_SECONDS // 2)
+class PresenceAggregator:
+    def __init__(self):
+        self._conns: dict[str, set[str]] = {}      # room key -> local connection ids
+        self._on_count: dict[str, Callable[[int], Awaitable]] = {}
+        self._joined: dict[str, set[str]] = {}     # not yet written
+        self._left: dict[str, set[str]] = {}       # written, to be removed
+        self._counts: dict[str, int] = {}          # last count sent per room
+        self._last_refresh = 0.0
+        self._task: Optional[asyncio.Task] = None
+
+    def join(self, key: str, conn_id: str, on_count: Callable[[int], Awaitable]) -> Optional[int]:
+        """Register a local viewer. Returns a count estimate for the initial
+        frame (None until this worker has counted the room once)."""
+        self._conns.setdefault(key, set()).add(conn_id)
+        self._on_count[key] = on_count
+        self._joined.setdefault(key, set()).add(conn_id)
+        self._left.get(key, set()).discard(conn_id)
+        known = self._counts.get(key)
+        return None if known is None else known + len(self._joined[key])
+
+    def leave(self, key: str, conn_id: str) -> None:
+        self._conns.get(key, set()).discard(conn_id)
+        pending = self._joined.get(key)
+        if pending is not None:
+            pending.discard(conn_id)
+        # ZREM of a never-written member is harmless and still gets the room recounted
+        self._left.setdefault(key, set()).add(conn_id)
+
+    async def tick(self) -> None:
+        now = time.time()
+        refresh = now - self._last_refresh >= REFRESH_SECONDS
+        joined, self._joined = self._joined, {}
+        left, self._left = self._left, {}
+        keys = set(joined) | set(left)
+        if refresh:
+            keys |= set(self._conns)
+        if not keys:
+            return
+
+        expiry = now + VIEWER_TTL_SECONDS
         try:
-            await refresh_viewer(key, conn_id)
+            redis = await get_redis()
+            pipe = redis.pipeline(transaction=False)
+            card_at: list[tuple[str, int]] = []
+            n = 0
+            for key in keys:
+                members = self._conns.get(key, set()) if refresh else joined.get(key, set())
+                if members:
+                    pipe.zadd(key, {c: expiry for c in members})
+                    n += 1
+                if left.get(key):
+                    pipe.zrem(key, *left[key])
+                    n += 1
+                pipe.zremrangebyscore(key, "-inf", now)
+                pipe.expire(key, VIEWER_TTL_SECONDS * 2)
+                pipe.zcard(key)
+                n += 3
+                card_at.append((key, n - 1))
+            results = await pipe.execute()
         except Exception:
-            pass
+            # Keep the changes for the next tick
+            for key, conns in joined.items():
+                self._joined.setdefault(key, set()).update(c for c in conns if c in self._conns.get(key, ()))
+            for key, conns in left.items():
+                self._left.setdefault(key, set()).update(conns)
+            raise
+        if refresh:
+            self._last_refresh = now
+
+        for key, i in card_at:
+            count = int(results[i])
+            on_count = self._on_count.get(key)
+            if count != self._counts.get(key) and on_count is not None:
+                try:
+                    await on_count(count)
+                except Exception as e:
+                    logger.warning(f"Viewer count broadcast failed for {key}: {e}")
+            self._counts[key] = count
+            if not self._conns.get(key) and key not in self._joined and key not in self._left:
+                # Last local viewer gone: forget the room
+                self._conns.pop(key, None)
+                self._on_count.pop(key, None)
+                self._counts.pop(key, None)
+
+    async def _loop(self):
+        while True:
+            try:
+                await asyncio.sleep(TICK_SECONDS)
+                await self.tick()
+            except asyncio.CancelledError:
+                break
+            except Exception as e:
+                logger.warning(f"Presence tick failed: {e}")
+
+    def start(self) -> None:
+        if self._task is None:
+            self._task = asyncio.create_task(self._loop())
+
+    async def stop(self) -> None:
+        """Stop ticking and remove this worker's viewers right away."""
+        if self._task is None:
+            return
+        self._task.cancel()
+        self._task = None
+        try:
+            redis = await get_redis()
+            pipe = redis.pipeline(transaction=False)
+            for key, conns in self._conns.items():
+                if conns:
+                    pipe.zrem(key, *conns)
+            await pipe.execute()
+        except Exception as e:
+            logger.warning(f"Final presence cleanup failed: {e}")
+
+
+presence = PresenceAggregator()
+
+
+async def start_presence_loop():
+    presence.start()
+
+
+async def stop_presence_loop():
+    await presence.stop()
 
 
 class ReactionThrottle:
@@ -0,0 +1,329 @@
+"""Shared LLM execution service (Groq chat completions).
+
+Bounce commentary, profile agents and report categorization used to open
+their own httpx client per call and fire whenever they liked, so a busy night
+meant bursts of calls with nothing watching the provider's rate limits.
+Every call now goes through `complete` / `complete_json`:
+
+- one scheduler per worker: a priority heap (INTERACTIVE commentary before
+  BACKGROUND profile refreshes) drained by a single dispatcher task, at most
+  LLM_MAX_CONCURRENCY calls in flight
+- a global budget: requests and estimated tokens per minute are reserved in
+  shared Redis windows, so LLM_REQUESTS_PER_MINUTE / LLM_TOKENS_PER_MINUTE
+  hold across instances (per-worker window when Redis is down)
+- jobs can carry a deadline; commentary that would arrive too late is
+  dropped instead of queued behind the backlog
+- identical requests in flight share one call, and callers that pass
+  cache_ttl get the response cached under the request digest
+- one pooled HTTP/2 client
+- per-caller counters: calls, cache hits, coalesced, dropped, errors,
+  tokens, latency and estimated cost (llm_stats)
+"""
+
+import asyncio
+import hashlib
+import heapq
+import itertools
+import json
+import logging
+import time
+from collections import defaultdict
+from typing import Optional
+
+import httpx
+
+from core.config import settings
+
+logger = logging.getLogger(__name__)
+
+GROQ_URL = "https://api.groq.com/openai/v1/chat/completions"
+DEFAULT_MODEL = "llama-3.1-8b-instant"
+REQUEST_TIMEOUT = 20.0
+CACHE_PREFIX = "llm:resp:"
+WINDOW_KEY = "llm:window:{kind}:{minute}"
+
+PRIORITY_INTERACTIVE = 0
+PRIORITY_BACKGROUND = 1
+
+# USD per million tokens (llama-3.1-8b-instant list price), for the cost estimate
+COST_PER_M_INPUT = 0.05
+COST_PER_M_OUTPUT = 0.08
+
+_http_client: Optional[httpx.AsyncClient] = None
+_heap: list = []
+_seq = itertools.count()
+_wakeup: Optional[asyncio.Event] = None
+_dispatcher: Optional[asyncio.Task] = None
+_slots: Optional[asyncio.Semaphore] = None
+_inflight: dict[str, asyncio.Future] = {}
+_local_window: dict[tuple, int] = defaultdict(int)
+_stats: dict[str, dict] = defaultdict(lambda: {
+    "calls": 0, "cache_hits": 0, "coalesced": 0, "dropped": 0, "errors": 0,
+    "prompt_tokens": 0, "completion_tokens": 0, "latency_ms_total": 0.0, "latency_ms_max": 0.0,
+})
+
+
+def _get_http_client() -> httpx.AsyncClient:
+    global _http_client
+    if _http_client is None or _http_client.is_closed:
+        _http_client = httpx.AsyncClient(
+            http2=True,
+            timeout=REQUEST_TIMEOUT,
+            limits=httpx.Limits(max_connections=20, max_keepalive_connections=10),
+        )
+    return _http_client
+
+
+def _estimate_tokens(body: dict) -> int:
+    chars = sum(len(m.get("content") or "") for m in body["messages"])
+    return chars // 4 + body.get("max_tokens", 0)
+
+
+def _digest(body: dict) -> str:
+    return hashlib.sha256(json.dumps(body, sort_keys=True).encode()).hexdigest()
+
+
+# ---------------------------------------------------------------- budget
+
+
+def _reserve_local(tokens: int, minute: int, wait: float) -> float:
+    """Per-worker window, used while Redis is unreachable."""
+    for key in list(_local_window):
+        if key[1] < minute:
+            del _local_window[key]
+    if _local_window[("req", minute)] >= settings.LLM_REQUESTS_PER_MINUTE or (
+        _local_window[("tok", minute)] and
+        _local_window[("tok", minute)] + tokens > settings.LLM_TOKENS_PER_MINUTE
+    ):
+        return wait
+    _local_window[("req", minute)] += 1
+    _local_window[("tok", minute)] += tokens
+    return 0.0
+
+
+async def _reserve(tokens: int) -> float:
+    """Take one request + `tokens` from this minute's shared budget. Returns
+    0 when granted, else seconds until the next window opens."""
+    from services.redis import circuit_is_open, get_redis, record_failure, record_success
+
+    now = time.time()
+    minute = int(now // 60)
+    wait = 60 - (now % 60) + 0.05
+    if circuit_is_open():
+        return _reserve_local(tokens, minute, wait)
+    try:
+        redis = await get_redis()
+        req_key = WINDOW_KEY.format(kind="req", minute=minute)
+        tok_key = WINDOW_KEY.format(kind="tok", minute=minute)
+        pipe = redis.pipeline(transaction=True)
+        pipe.incr(req_key)
+        pipe.incrby(tok_key, tokens)
+        pipe.expire(req_key, 120)
+        pipe.expire(tok_key, 120)
+        n_req, n_tok, _, _ = await pipe.execute()
+        if n_req <= settings.LLM_REQUESTS_PER_MINUTE and (
+            n_tok <= settings.LLM_TOKENS_PER_MINUTE or n_tok == tokens
+        ):
+            record_success()
+            return 0.0
+        pipe = redis.pipeline(transaction=True)
+        pipe.decr(req_key)
+        pipe.decrby(tok_key, tokens)
+        await pipe.execute()
+        record_success()
+        return wait
+    except Exception:
+        record_failure()
+        return _reserve_local(tokens, minute, wait)
+
+
+# ---------------------------------------------------------------- scheduler
+
+
+class _Job:
+    __slots__ = ("caller", "body", "digest", "deadline", "future", "tokens")
+
+    def __init__(self, caller: str, body: dict, digest: str, deadline: Optional[float]):
+        self.caller = caller
+        self.body = body
+        self.digest = digest
+        self.deadline = deadline
+        self.future = asyncio.get_running_loop().create_future()
+        self.tokens = _estimate_tokens(body)
+
+
+def _ensure_dispatcher():
+    global _wakeup, _dispatcher, _slots
+    if _dispatcher is None or _dispatcher.done():
+        _wakeup = asyncio.Event()
+        _slots = asyncio.Semaphore(settings.LLM_MAX_CONCURRENCY)
+        _dispatcher = asyncio.create_task(_dispatch_loop())
+
+
+def _finish(job: _Job, result: Optional[str]):
+    _inflight.pop(job.digest, None)
+    if not job.future.done():
+        job.future.set_result(result)
+
+
+async def _dispatch_loop():
+    while True:
+        try:
+            if not _heap:
+                _wakeup.clear()
+                await _wakeup.wait()
+                continue
+            _, _, job = _heap[0]
+            if job.deadline is not None and time.time() > job.deadline:
+                heapq.heappop(_heap)
+                _stats[job.caller]["dropped"] += 1
+                _finish(job, None)
+                continue
+            wait = await _reserve(job.tokens)
+            if wait:
+                # Sleep until the window opens, or re-pick if something more urgent arrives
+                _wakeup.clear()
+                try:
+                    await asyncio.wait_for(_wakeup.wait(), timeout=wait)
+                except asyncio.TimeoutError:
+                    pass
+                continue
+            heapq.heappop(_heap)
+            await _slots.acquire()
+            asyncio.create_task(_execute(job))
+        except asyncio.CancelledError:
+            break
+        except Exception as e:
+            logger.error(f"LLM dispatcher error: {e}")
+            await asyncio.sleep(1)
+
+
+async def _execute(job: _Job):
+    stats = _stats[job.caller]
+    started = time.monotonic()
+    result = None
+    try:
+        resp = await _get_http_client().post(
+            GROQ_URL,
+            headers={
+                "Authorization": f"Bearer {settings.GROQ_API_KEY}",
+                "Content-Type": "application/json",
+            },
+            json=job.body,
+        )
+        if resp.status_code != 200:
+            stats["errors"] += 1
+            logger.warning(f"Groq {job.caller} call {resp.status_code}: {resp.text[:200]}")
+        else:
+            data = resp.json()
+            result = data["choices"][0]["message"]["content"].strip()
+            usage = data.get("usage") or {}
+            stats["prompt_tokens"] += usage.get("prompt_tokens", 0)
+            stats["completion_tokens"] += usage.get("completion_tokens", 0)
+    except Exception as e:
+        stats["errors"] += 1
+        logger.warning(f"Groq {job.caller} call failed: {e}")
+    finally:
+        _slots.release()
+        elapsed = (time.monotonic() - started) * 1000
+        stats["calls"] += 1
+        stats["latency_ms_total"] += elapsed
+        stats["latency_ms_max"] = max(stats["latency_ms_max"], elapsed)
+        _finish(job, result)
+
+
+# ---------------------------------------------------------------- API
+
+
+async def complete(
+    caller: str,
+    system: str,
+    user: str,
+    *,
+    max_tokens: int = 150,
+    temperature: Optional[float] = None,
+    json_mode: bool = False,
+    priority: int = PRIORITY_BACKGROUND,
+    deadline_seconds: Optional[float] = None,
+    cache_ttl: Optional[int] = None,
+    model: str = DEFAULT_MODEL,
+) -> Optional[str]:
+    """Message content of one chat completion, or None (no key, error,
+    missed deadline). `caller` names the metrics bucket."""
+    if not settings.GROQ_API_KEY:
+        return None
+    body = {
+        "model": model,
+        "max_tokens": max_tokens,
+        "messages": [
+            {"role": "system", "content": system},
+            {"role": "user", "content": user},
+        ],
+    }
+    if temperature is not None:
+        body["temperature"] = temperature
+    if json_mode:
+        body["response_format"] = {"type": "json_object"}
+    digest = _digest(body)
+    stats = _stats[caller]
+
+    if cache_ttl:
+        from services.cache import cache_get
+        cached = await cache_get(CACHE_PREFIX + digest)
+        if cached is not None:
+            stats["cache_hits"] += 1
+            return cached
+
+    fut = _inflight.get(digest)
+    if fut is not None:
+        stats["coalesced"] += 1
+        return await asyncio.shield(fut)
+
+    _ensure_dispatcher()
+    job = _Job(caller, body, digest, time.time() + deadline_seconds if deadline_seconds else None)
+    _inflight[digest] = job.future
+    heapq.heappush(_heap, (priority, next(_seq), job))
+    _wakeup.set()
+    result = await asyncio.shield(job.future)
+
+    if cache_ttl and result is not None:
+        from services.cache import cache_set
+        await cache_set(CACHE_PREFIX + digest, result, ttl=cache_ttl)
+    return result
+
+
+async def complete_json(caller: str, system: str, user: str, **kwargs) -> Optional[dict]:
+    """complete() in JSON mode, parsed; None when the model returned no valid JSON."""
+    content = await complete(caller, system, user, json_mode=True, **kwargs)
+    if content is None:
+        return None
+    try:
+        return json.loads(content)
+    except (json.JSONDecodeError, TypeError):
+        logger.warning(f"Groq {caller} returned invalid JSON")
+        return None
+
+
+def llm_stats() -> dict:
+    out = {"queued": len(_heap), "in_flight": len(_inflight), "callers": {}}
+    for caller, s in _stats.items():
+        cost = (s["prompt_tokens"] * COST_PER_M_INPUT + s["completion_tokens"] * COST_PER_M_OUTPUT) / 1e6
+        out["callers"][caller] = {
+            **s,
+            "latency_ms_avg": round(s["latency_ms_total"] / s["calls"], 1) if s["calls"] else None,
+            "est_cost_usd": round(cost, 6),
+        }
+    return out
+
+
+async def close_llm():
+    global _dispatcher, _http_client
+    if _dispatcher is not None:
+        _dispatcher.cancel()
+        _dispatcher = None
+    while _heap:
+        _, _, job = heapq.heappop(_heap)
+        _finish(job, None)
+    if _http_client is not None:
+        await _http_client.aclose()
+        _http_client = None
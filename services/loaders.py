@@ -0,0 +1,133 @@
+"""Request-scoped batch loaders (dataloader pattern).
+
+Handlers used to resolve related rows one query at a time: a user, then the
+follow edge, then the reverse edge; a Place and its photo count per map venue.
+A BatchLoader collects every load(key) made in the same event-loop tick and
+resolves them with one `IN (...)` query, memoizing per request:
+
+    me_to_them, them_to_me = await loaders.follows.load_many(
+        [(me, them), (them, me)])               # one query, not two
+
+Get a request's Loaders with `Depends(get_loaders)` (api/dependencies.py);
+FastAPI caches the dependency, so every loader shares the request's session.
+All loaders of a request take turns on that session (one lock) since an
+AsyncSession can't run two statements at once — so don't gather loads with
+other db.execute calls on the same session.
+
+Loaded ORM rows live in the session as usual and may be mutated; memoized
+values are not refreshed, so use loaders for reads and plain selects for
+row locks (with_for_update).
+"""
+
+import asyncio
+import logging
+from typing import Awaitable, Callable, Hashable, Iterable, Optional
+
+from sqlalchemy import func, select, tuple_
+from sqlalchemy.ext.asyncio import AsyncSession
+
+from db.models import Follow, GooglePic, Place, User
+
+logger = logging.getLogger(__name__)
+
+MAX_PLACE_PHOTOS = 3
+
+
+class BatchLoader:
+    def __init__(self, db: AsyncSession, fetch: Callable[[AsyncSession, list], Awaitable[dict]], lock: asyncio.Lock):
+        self._db = db
+        self._fetch = fetch
+        self._lock = lock
+        self._futures: dict[Hashable, asyncio.Future] = {}
+        self._queue: list = []
+        self._scheduled = False
+        self._tasks: set[asyncio.Task] = set()
+
+    def load(self, key: Hashable) -> "asyncio.Future":
+        """Awaitable value for key (None when there is no row)."""
+        fut = self._futures.get(key)
+        if fut is None:
+            loop = asyncio.get_running_loop()
+            fut = loop.create_future()
+            self._futures[key] = fut
+            self._queue.append(key)
+            if not self._scheduled:
+                self._scheduled = True
+                loop.call_soon(self._dispatch)
+        return fut
+
+    async def load_many(self, keys: Iterable[Hashable]) -> list:
+        return list(await asyncio.gather(*(self.load(k) for k in keys)))
+
+    def _dispatch(self) -> None:
+        keys, self._queue, self._scheduled = self._queue, [], False
+        task = asyncio.create_task(self._run(keys))
+        self._tasks.add(task)  # the loop only holds a weak reference
+        task.add_done_callback(self._task_done)
+
+    def _task_done(self, task: asyncio.Task) -> None:
+        self._tasks.discard(task)
+        if not task.cancelled() and task.exception() is not None:
+            logger.error(f"Batch load failed: {task.exception()}")
+
+    async def _run(self, keys: list) -> None:
+        try:
+            async with self._lock:
+                found = await self._fetch(self._db, keys)
+        except Exception as e:
+            for key in keys:
+                # Forget failures so a later load can retry
+                fut = self._futures.pop(key, None)
+                if fut is not None and not fut.done():
+                    fut.set_exception(e)
+            return
+        for key in keys:
+            fut = self._futures.get(key)
+            if fut is not None and not fut.done():
+                fut.set_result(found.get(key))
+
+
+# ---------------------------------------------------------------- fetchers
+
+
+async def _fetch_users(db: AsyncSession, ids: list) -> dict:
+    result = await db.execute(select(User).where(User.id.in_(ids)))
+    return {u.id: u for u in result.scalars().all()}
+
+
+async def _fetch_places_by_google_id(db: AsyncSession, place_ids: list) -> dict:
+    result = await db.execute(select(Place).where(Place.place_id.in_(place_ids)))
+    return {p.place_id: p for p in result.scalars().all()}
+
+
+async def _fetch_photo_counts(db: AsyncSession, places_fk_ids: list) -> dict:
+    result = await db.execute(
+        select(GooglePic.place_id, func.count(GooglePic.id))
+        .where(GooglePic.place_id.in_(places_fk_ids))
+        .group_by(GooglePic.place_id)
+    )
+    return {pid: min(n, MAX_PLACE_PHOTOS) for pid, n in result.all()}
+
+
+async def _fetch_follows(db: AsyncSession, pairs: list) -> dict:
+    """Keys are (follower_id, following_id); missing edges resolve to None."""
+    result = await db.execute(
+        select(Follow).where(tuple_(Follow.follower_id, Follow.following_id).in_(pairs))
+    )
+    return {(f.follower_id, f.following_id): f for f in result.scalars().all()}
+
+
+class Loaders:
+    """One set of loaders per request, sharing its session."""
+
+    def __init__(self, db: AsyncSession):
+        lock = asyncio.Lock()
+        self.users = BatchLoader(db, _fetch_users, lock)
+        self.places_by_google_id = BatchLoader(db, _fetch_places_by_google_id, lock)
+        self.photo_counts = BatchLoader(db, _fetch_photo_counts, lock)
+        self.follows = BatchLoader(db, _fetch_follows, lock)
+
+    async def follow_pair(self, a: int, b: int) -> tuple[Optional[Follow], Optional[Follow]]:
+        """(a -> b, b -> a) edges in one query."""
+        forward, reverse = await self.follows.load_many([(a, b), (b, a)])
+        return forward, reverse
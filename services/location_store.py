@@ -0,0 +1,187 @@
+"""Write-behind store for users' last known location.
+
+Heartbeats arrive every ~30s per active client; writing each one to the
+`users` row made the hottest table absorb a steady UPDATE + COMMIT storm.
+Instead a position lands in Redis only:
+
+    loc:last     hash user id -> "lat,lon,epoch" (authoritative latest fix)
+    loc:seen     sorted set user id -> epoch (stale-entry pruning)
+    loc:dirty    set of user ids changed since the last flush
+
+Every worker runs a flusher that SPOPs a batch of dirty ids (so workers split
+the work instead of duplicating it), reads their coalesced latest fix and
+writes them with one multi-row UPDATE ... FROM (VALUES ...). The same batch
+then goes through auto-checkout evaluation in one query. Readers overlay
+get_positions() on the DB columns, which lag by at most a flush interval.
+
+When Redis is unavailable record_location returns False and callers fall
+back to writing the row directly.
+"""
+
+import asyncio
+import logging
+import time
+from datetime import datetime, timezone
+from typing import Optional
+
+from sqlalchemy import DateTime, Float, Integer, column, update, values
+
+from db.database import create_async_session
+from db.models import User
+from services.redis import get_redis
+
+logger = logging.getLogger(__name__)
+
+LAST_KEY = "loc:last"
+SEEN_KEY = "loc:seen"
+DIRTY_KEY = "loc:dirty"
+
+FLUSH_INTERVAL_SECONDS = 10.0
+FLUSH_BATCH = 1000
+PRUNE_AFTER_SECONDS = 24 * 3600  # matches the close-friend map staleness cutoff
+PRUNE_EVERY_FLUSHES = 60
+
+_flush_task: Optional[asyncio.Task] = None
+
+
+def _parse(value) -> Optional[tuple]:
+    try:
+        lat, lon, ts = value.split(",")
+        return float(lat), float(lon), float(ts)
+    except (AttributeError, ValueError):
+        return None
+
+
+async def record_location(user_id: int, lat: float, lon: float, alive_ttl: Optional[int] = None) -> bool:
+    """Buffer a position fix. False when Redis is down (caller writes the row)."""
+    now = time.time()
+    try:
+        r = await get_redis()
+        pipe = r.pipeline(transaction=False)
+        pipe.hset(LAST_KEY, user_id, f"{lat},{lon},{now}")
+        pipe.zadd(SEEN_KEY, {user_id: now})
+        pipe.sadd(DIRTY_KEY, user_id)
+        if alive_ttl:
+            pipe.set(f"user:alive:{user_id}", "1", ex=alive_ttl)
+        await pipe.execute()
+        return True
+    except Exception as e:
+        logger.warning(f"Location buffer unavailable for user {user_id}: {e}")
+        return False
+
+
+async def get_positions(user_ids) -> dict[int, tuple]:
+    """user id -> (lat, lon, updated_at) for ids with a buffered fix."""
+    user_ids = list(user_ids)
+    if not user_ids:
+        return {}
+    try:
+        r = await get_redis()
+        raw = await r.hmget(LAST_KEY, user_ids)
+    except Exception as e:
+        logger.warning(f"Location buffer read failed: {e}")
+        return {}
+    out = {}
+    for uid, value in zip(user_ids, raw):
+        p = _parse(value)
+        if p:
+            out[uid] = (p[0], p[1], datetime.fromtimestamp(p[2], timezone.utc))
+    return out
+
+
+async def _write_rows(positions: dict[int, tuple]) -> None:
+    rows = [(uid, lat, lon, datetime.fromtimestamp(ts, timezone.utc))
+            for uid, (lat, lon, ts) in positions.items()]
+    v = values(
+        column("id", Integer), column("lat", Float), column("lon", Float),
+        column("ts", DateTime(timezone=True)),
+        name="v",
+    ).data(rows)
+    stmt = (
+        update(User)
+        .where(User.id == v.c.id)
+        .values(last_location_lat=v.c.lat, last_location_lon=v.c.lon,
+                last_location_update=v.c.ts)
+        .execution_options(synchronize_session=False)
+    )
+    from api.routes.checkins import auto_checkout_many
+
+    async with create_async_session() as db:
+        await db.execute(stmt)
+        await db.commit()
+        await auto_checkout_many(db, {uid: (lat, lon) for uid, (lat, lon, _) in positions.items()})
+
+
+async def flush_once() -> int:
+    """Write one batch of dirty positions. Returns how many ids were popped."""
+    r = await get_redis()
+    ids = await r.spop(DIRTY_KEY, FLUSH_BATCH)
+    if not ids:
+        return 0
+    raw = await r.hmget(LAST_KEY, ids)
+    positions = {}
+    for uid, value in zip(ids, raw):
+        p = _parse(value)
+        if p:
+            positions[int(uid)] = p
+    if positions:
+        try:
+            await _write_rows(positions)
+        except Exception:
+            # Put them back so the next tick retries; a newer fix wins anyway
+            await r.sadd(DIRTY_KEY, *ids)
+            raise
+    return len(ids)
+
+
+async def _prune() -> None:
+    r = await get_redis()
+    stale = await r.zrangebyscore(SEEN_KEY, "-inf", time.time() - PRUNE_AFTER_SECONDS, start=0, num=FLUSH_BATCH)
+    if stale:
+        pipe = r.pipeline(transaction=False)
+        pipe.hdel(LAST_KEY, *stale)
+        pipe.zrem(SEEN_KEY, *stale)
+        await pipe.execute()
+
+
+async def _flush_loop():
+    ticks = 0
+    while True:
+        try:
+            await asyncio.sleep(FLUSH_INTERVAL_SECONDS)
+            flushed = 0
+            while True:
+                n = await flush_once()
+                flushed += n
+                if n < FLUSH_BATCH:
+                    break
+            if flushed:
+                logger.debug(f"Location flush: {flushed} users")
+            ticks += 1
+            if ticks % PRUNE_EVERY_FLUSHES == 0:
+                await _prune()
+        except asyncio.CancelledError:
+            break
+        except Exception as e:
+            logger.error(f"Location flush failed: {e}")
+
+
+async def start_location_flusher():
+    global _flush_task
+    if _flush_task is not None:
+        return
+    _flush_task = asyncio.create_task(_flush_loop())
+    logger.info("Started location write-behind flusher")
+
+
+async def stop_location_flusher():
+    """Cancel the loop and write whatever is still buffered."""
+    global _flush_task
+    if _flush_task is not None:
+        _flush_task.cancel()
+        _flush_task = None
+        try:
+            while await flush_once() >= FLUSH_BATCH:
+                pass
+        except Exception as e:
+            logger.warning(f"Final location flush failed: {e}")
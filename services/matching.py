@@ -64,9 +64,13 @@ from datetime import datetime, timezone, timedelta
 from statistics import NormalDist
 from typing import Optional
 
+import numpy as np
+import scipy.sparse as sp
+from scipy.special import ndtr
 from sqlalchemy import select
 from sqlalchemy.ext.asyncio import AsyncSession
 
+from core.config import settings
 from db.models import (
     Bounce,
     BounceAttendee,
@@ -77,6 +81,7 @@ from db.models import (
     Place,
     UserAgentProfile,
 )
+from services.copresence import CoPresenceIndex
 
 logger = logging.getLogger(__name__)
 
@@ -112,6 +117,7 @@ DEFAULT_STAY_S = 4 * 3600      # open-ended check-ins assumed 4h
 EXPOSURE_CAP = 5
 FOLLOW_BACK_FAST_S = 48 * 3600
 MODEL_TTL_SECONDS = 600
+SNAPSHOT_MAX_AGE_SECONDS = MODEL_TTL_SECONDS * 3
 MAX_ACTIVE_SWEEP = 50          # cap concurrent intervals per venue sweep
 
 _STD_NORMAL = NormalDist()
@@ -190,6 +196,17 @@ class MatchingModel:
         self.b: float = 0.0                         # calibrated intercept
         # digest inputs for the profile agent
         self.copresence_partners: dict[int, dict[int, int]] = defaultdict(dict)
+        # ---- packed for pair_posterior_many (see _pack_batch) ----
+        # evidence folded per pair at ev_ref_ts: (SUM d_e/s_e^2, SUM d_e*y_e/s_e^2);
+        # at time now both scale by exp(-(now - ev_ref_ts) / DECAY)
+        self.ev_ref_ts: float = 0.0
+        self.ev_agg: dict[tuple, tuple] = {}
+        self.trait_row: dict[int, int] = {}         # user_id -> row below
+        self.trait_tags: Optional[sp.csr_matrix] = None   # users x scene tags (0/1)
+        self.trait_tag_count = np.zeros(0)
+        self.trait_scalars = np.zeros((0, 3))       # nocturnality, exploration, initiator
+        self.rec_Xn = None                          # L2-normalized rec_X rows
+        self.rec_Gn = None
 
     @property
     def is_fresh(self) -> bool:
@@ -257,9 +274,8 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
             dt = dt.replace(tzinfo=timezone.utc)
         return dt.timestamp()
 
-    # ---- interval index per user + per venue ----
-    intervals_by_user: dict[int, list] = defaultdict(list)   # (place, s, e)
-    intervals_by_place: dict[str, list] = defaultdict(list)  # (user, s, e)
+    # ---- co-presence interval index (per user + per venue, sorted) ----
+    stays = []
     for user_id, place_id, cin, cout in raw["checkins"]:
         if not place_id:
             continue
@@ -267,8 +283,8 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
         e = ts(cout) if cout is not None else min(s + DEFAULT_STAY_S, now_ts)
         if e <= s:
             e = s + 15 * 60
-        intervals_by_user[user_id].append((place_id, s, e))
-        intervals_by_place[place_id].append((user_id, s, e))
+        stays.append((user_id, place_id, s, e))
+    presence = CoPresenceIndex(stays)
 
     # ---- follows: classify at-venue vs elsewhere; reciprocity; close friends ----
     follow_ts: dict[tuple, float] = {}
@@ -280,20 +296,9 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
         if cf_status == "accepted":
             close_pairs.add((min(f, g), max(f, g)))
 
-    def _at_same_venue(u: int, v: int, t: float) -> bool:
-        places_u = {
-            p for (p, s, e) in intervals_by_user.get(u, [])
-            if s - FOLLOW_SLACK_S <= t <= e + FOLLOW_SLACK_S
-        }
-        if not places_u:
-            return False
-        for (p, s, e) in intervals_by_user.get(v, []):
-            if p in places_u and s - FOLLOW_SLACK_S <= t <= e + FOLLOW_SLACK_S:
-                return True
-        return False
-
     for (f, g), t in follow_ts.items():
-        etype = "follow_at_venue" if _at_same_venue(f, g, t) else "follow_elsewhere"
+        met = presence.at_same_venue(f, g, t, FOLLOW_SLACK_S)
+        etype = "follow_at_venue" if met else "follow_elsewhere"
         m.evidence[(f, g)].append((etype, t))
         # fast reciprocation is mutual evidence
         t_back = follow_ts.get((g, f))
@@ -315,19 +320,8 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
 
     # ---- co-presence sweep per venue ----
     copresence: dict[tuple, list] = defaultdict(list)  # unordered pair -> [ts]
-    for place_id, ivs in intervals_by_place.items():
-        ivs.sort(key=lambda x: x[1])
-        active: list = []
-        for (u, s, e) in ivs:
-            active = [(v, vs, ve) for (v, vs, ve) in active if ve > s][-MAX_ACTIVE_SWEEP:]
-            for (v, vs, ve) in active:
-                if v == u:
-                    continue
-                overlap = min(e, ve) - max(s, vs)
-                if overlap >= OVERLAP_MIN_S:
-                    key = (min(u, v), max(u, v))
-                    copresence[key].append(max(s, vs))
-            active.append((u, s, e))
+    for _place, u, v, t in presence.copresent_pairs(OVERLAP_MIN_S, MAX_ACTIVE_SWEEP):
+        copresence[(min(u, v), max(u, v))].append(t)
 
     # exposure & post-connection co-check-ins + magnetism counting
     exposures_of: dict[int, int] = defaultdict(int)     # j -> co-presence exposures
@@ -431,6 +425,8 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
     # uninformed pair: features ~ 0, so mu0 = b; want P(A > tau) = rho
     m.b = TAU + sigma_bar * _phi_inv(rho)
 
+    _pack_batch(m, now_ts)
+
     m.built_at = time.time()
     logger.info(
         f"Matching model: {len(m.evidence)} evidenced pairs, "
@@ -441,6 +437,16 @@ def _fit(raw: dict, recsys=None) -> MatchingModel:
 
 async def get_matching_model(db: AsyncSession) -> MatchingModel:
     global _model
+    if settings.MODEL_BUILDER_MODE == "process":
+        from services.model_snapshot import current_models
+        snap = await current_models()
+        if snap is not None and time.time() - snap[1].built_at < SNAPSHOT_MAX_AGE_SECONDS:
+            return snap[1]
+        # Same boot path as recommendations.get_model
+        from services.model_builder import build_or_wait
+        snap = await build_or_wait(lambda s: time.time() - s[1].built_at < SNAPSHOT_MAX_AGE_SECONDS)
+        if snap is not None:
+            return snap[1]
     if _model.is_fresh:
         return _model
     async with _model_lock:
@@ -478,6 +484,136 @@ def _embedding_sims(m: MatchingModel, i: int, j: int) -> tuple[float, float]:
     return taste, graph
 
 
+def _trait_scalar(d: dict, key: str) -> float:
+    try:
+        return min(max(float(d.get(key, 0.5)), 0.0), 1.0)
+    except (TypeError, ValueError):
+        return 0.5
+
+
+def _unit_rows(M) -> Optional[np.ndarray]:
+    if M is None:
+        return None
+    M = np.asarray(M, dtype=np.float64)
+    norms = np.sqrt((M * M).sum(axis=1))
+    return np.divide(M, norms[:, None], out=np.zeros_like(M), where=norms[:, None] > 1e-9)
+
+
+def _pack_batch(m: MatchingModel, ref_ts: float):
+    """Everything pair_posterior recomputes per call, precomputed once per
+    fit: per-pair evidence sums, parsed trait vectors, unit embeddings."""
+    m.ev_ref_ts = ref_ts
+    for pair, events in m.evidence.items():
+        lam = num = 0.0
+        for etype, t in events:
+            y, sigma = EVIDENCE[etype]
+            d = _decay(ref_ts - t)
+            lam += d / (sigma * sigma)
+            num += d * y / (sigma * sigma)
+        m.ev_agg[pair] = (lam, num)
+
+    tag_index: dict[str, int] = {}
+    rows, cols = [], []
+    scalars = []
+    for user_id, traits in m.traits.items():
+        if not traits or not isinstance(traits, dict):
+            continue                                # trait_compat treats {} as unknown
+        r = len(scalars)
+        m.trait_row[user_id] = r
+        for tag in set(traits.get("scene_tags") or []):
+            rows.append(r)
+            cols.append(tag_index.setdefault(tag, len(tag_index)))
+        scalars.append([_trait_scalar(traits, k)
+                        for k in ("nocturnality", "exploration", "initiator")])
+    n = len(scalars)
+    m.trait_tags = sp.csr_matrix((np.ones(len(rows)), (rows, cols)),
+                                 shape=(n, max(len(tag_index), 1)))
+    m.trait_tag_count = np.asarray(m.trait_tags.sum(axis=1)).ravel()
+    m.trait_scalars = np.array(scalars, dtype=np.float64).reshape(n, 3)
+    m.rec_Xn = _unit_rows(m.rec_X)
+    m.rec_Gn = _unit_rows(m.rec_G)
+
+
+def _batch_sims(m: MatchingModel, viewer: int, others: list[int]) -> tuple[np.ndarray, np.ndarray]:
+    """Vectorized _embedding_sims(viewer, j) for every j in `others`."""
+    n = len(others)
+    taste, graph = np.zeros(n), np.zeros(n)
+    ui = m.rec_user_index.get(viewer)
+    if ui is None:
+        return taste, graph
+    rows = np.array([m.rec_user_index.get(j, -1) for j in others], dtype=np.int64)
+    for out, U in ((taste, m.rec_Xn), (graph, m.rec_Gn)):
+        if U is None or ui >= U.shape[0]:
+            continue
+        ok = (rows >= 0) & (rows < U.shape[0])
+        out[ok] = U[rows[ok]] @ U[ui]
+    return taste, graph
+
+
+def _batch_kappa(m: MatchingModel, viewer: int, others: list[int]) -> np.ndarray:
+    """Vectorized trait_compat(viewer, j): same kernel, pre-parsed traits."""
+    n = len(others)
+    kappa = np.zeros(n)
+    ri = m.trait_row.get(viewer)
+    if ri is None or m.trait_tags is None:
+        return kappa
+    rows = np.array([m.trait_row.get(j, -1) for j in others], dtype=np.int64)
+    ok = rows >= 0
+    if not ok.any():
+        return kappa
+    rj = rows[ok]
+    inter = np.asarray(m.trait_tags[rj] @ m.trait_tags[ri].T.toarray()).ravel()
+    union = m.trait_tag_count[rj] + m.trait_tag_count[ri] - inter
+    jac = np.divide(inter, union, out=np.zeros_like(inter), where=union > 0)
+    a, b = m.trait_scalars[ri], m.trait_scalars[rj]
+    noct_align = 1.0 - np.abs(a[0] - b[:, 0])
+    expl_align = 1.0 - np.abs(a[1] - b[:, 1])
+    init_comp = np.abs(a[2] - b[:, 2])
+    score = (
+        0.45 * (2 * jac - 0.5)
+        + 0.30 * (2 * noct_align - 1)
+        + 0.15 * (2 * expl_align - 1)
+        + 0.10 * (2 * init_comp - 1)
+    )
+    kappa[ok] = np.clip(score, -1.0, 1.0)
+    return kappa
+
+
+def pair_posterior_many(m: MatchingModel, viewer: int, candidates: list[int],
+                        now_ts: Optional[float] = None, reverse: bool = False) -> dict:
+    """pair_posterior for every candidate at once, as numpy arrays.
+    reverse=False scores viewer -> j, reverse=True scores j -> viewer.
+    Returns {"mu", "sd", "p", "taste", "graph", "kappa"} (one entry per
+    candidate, in order); per-event contributions are left to the scalar
+    path, which only the few surfaced results need for their reasons."""
+    now_ts = now_ts or time.time()
+    n = len(candidates)
+    taste, graph = _batch_sims(m, viewer, candidates)
+    kappa = _batch_kappa(m, viewer, candidates)
+
+    if reverse:
+        mag_z = np.full(n, m.magnetism_z.get(viewer, 0.0))
+        mag_var = np.full(n, m.magnetism_var.get(viewer, 0.0))
+        pairs = [(j, viewer) for j in candidates]
+    else:
+        mag_z = np.array([m.magnetism_z.get(j, 0.0) for j in candidates])
+        mag_var = np.array([m.magnetism_var.get(j, 0.0) for j in candidates])
+        pairs = [(viewer, j) for j in candidates]
+    idea = np.array([IDEA_BOOST if pair in m.idea_pairs else 0.0 for pair in pairs])
+    ev = np.array([m.ev_agg.get(pair, (0.0, 0.0)) for pair in pairs]).reshape(n, 2)
+    scale = _decay(now_ts - m.ev_ref_ts)
+
+    mu0 = m.b + W_TASTE * taste + W_GRAPH * graph + W_KAPPA * kappa + W_MAG * mag_z + idea
+    var0 = PRIOR_VAR + MAG_VAR_SCALE * mag_var
+    lam = 1.0 / var0 + scale * ev[:, 0]
+    num = mu0 / var0 + scale * ev[:, 1]
+    mu_post = num / lam
+    sd_post = np.sqrt(1.0 / lam)
+    p = 1.0 - ndtr((TAU - mu_post) / sd_post)
+    return {"mu": mu_post, "sd": sd_post, "p": p,
+            "taste": taste, "graph": graph, "kappa": kappa}
+
+
 def pair_posterior(m: MatchingModel, i: int, j: int, now_ts: Optional[float] = None) -> dict:
     """Full posterior for A_(i->j): mean, sd, tail probability, contributions."""
     now_ts = now_ts or time.time()
@@ -564,21 +700,31 @@ def _reasons(m: MatchingModel, i: int, j: int, a: dict, b: dict) -> list[str]:
 
 # ---------------- serving ----------------
 
-def rank_people(m: MatchingModel, viewer: int, candidates: list[int]) -> list[dict]:
+def rank_people(m: MatchingModel, viewer: int, candidates: list[int],
+                limit: Optional[int] = None) -> list[dict]:
     """Rank candidate users for the viewer. Excludes people the viewer
-    already follows (nothing to prompt) and self."""
+    already follows (nothing to prompt) and self. Everyone is scored in one
+    batched posterior; only the top `limit` get the per-pair detail pass
+    that builds their reasons."""
     now_ts = time.time()
-    out = []
     already = m.following.get(viewer, set())
-    for j in candidates:
-        if j == viewer or j in already:
-            continue
+    pool = list(dict.fromkeys(j for j in candidates if j != viewer and j not in already))
+    if not pool:
+        return []
+    fwd = pair_posterior_many(m, viewer, pool, now_ts)
+    back = pair_posterior_many(m, viewer, pool, now_ts, reverse=True)
+    mutual = fwd["p"] * back["p"]
+    order = np.argsort(-mutual, kind="stable")
+    if limit is not None:
+        order = order[:limit]
+    out = []
+    for k in order.tolist():
+        j = pool[k]
         pair = match_pair(m, viewer, j, now_ts)
         detail = pair.pop("_detail")
         pair["user_id"] = j
         pair["uncertain"] = detail["i_to_j"]["sd"] > 0.85  # mostly-prior pairs
         out.append(pair)
-    out.sort(key=lambda r: r["match_probability"], reverse=True)
     return out
 
 
@@ -606,16 +752,13 @@ def rank_venues_now(
         if place_id == exclude_place:
             continue
         meta = place_meta.get(place_id, {})
-        scored = []
-        for j in users:
-            if j == viewer:
-                continue
-            pair = match_pair(m, viewer, j, now_ts)
-            scored.append((pair["match_probability"], j, pair))
-        if not scored:
+        others = [j for j in users if j != viewer]
+        if not others:
             continue
-        scored.sort(reverse=True)
-        expected = sum(s for s, _, _ in scored)
+        mutual = (pair_posterior_many(m, viewer, others, now_ts)["p"]
+                  * pair_posterior_many(m, viewer, others, now_ts, reverse=True)["p"])
+        scored = sorted(zip([round(float(x), 4) for x in mutual], others), reverse=True)
+        expected = sum(s for s, _ in scored)
         score = expected
         idea_reason = m.venue_ideas.get((viewer, place_id))
         if idea_reason:
@@ -638,8 +781,8 @@ def rank_venues_now(
                 if len(scored) > 1 else "Someone you might click with is here now"
             ),
             "top_people": [
-                {"user_id": j, "match_probability": round(s, 4)}
-                for s, j, _ in scored[:3]
+                {"user_id": j, "match_probability": s}
+                for s, j in scored[:3]
             ],
         })
     results.sort(key=lambda r: r["score"], reverse=True)
@@ -0,0 +1,341 @@
+"""Per-request performance instrumentation, exposed in Prometheus text format.
+
+Each HTTP request gets a RequestStats in a context variable (MetricsMiddleware);
+the probes below add to it as the request runs:
+
+- SQL: before/after_cursor_execute events on the engine (db/database.py)
+  count statements and time them, keyed by normalized statement text
+- Redis: the text and binary clients (services/redis.py) count commands and
+  round trips (a pipeline is one round trip)
+- WebSocket fan-out sizes: ConnectionManager._fanout observes its recipient
+  count per channel kind
+
+When the request finishes its route (the path template, never the raw path,
+so ids don't explode label cardinality) gets latency, SQL-count and Redis-count
+histograms. Requests slower than SLOW_REQUEST_MS log a warning with the query
+breakdown — an N+1 shows up as "40x 0.3ms SELECT ... FROM users WHERE ...".
+
+/metrics (main.py) renders these together with the existing per-instance
+counters (cache hits per namespace, WS connections and fan-out). Everything is
+per worker process; every sample carries a `worker` label so counters from
+different workers behind one scrape target stay separate series.
+"""
+
+import bisect
+import logging
+import os
+import time
+from contextvars import ContextVar
+from typing import Optional
+
+from core.config import settings
+
+logger = logging.getLogger(__name__)
+
+LATENCY_BUCKETS = (0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0)
+COUNT_BUCKETS = (0, 1, 2, 5, 10, 20, 50, 100, 250)
+FANOUT_BUCKETS = (1, 2, 5, 10, 25, 50, 100, 250, 500, 1000)
+STATEMENT_KEY_CHARS = 160
+MAX_STATEMENT_KEYS = 100           # per request; the rest count under "(other)"
+SLOW_LOG_TOP_STATEMENTS = 5
+
+_WORKER = str(os.getpid())
+
+
+class Histogram:
+    __slots__ = ("buckets", "counts", "sum", "count")
+
+    def __init__(self, buckets: tuple):
+        self.buckets = buckets
+        self.counts = [0] * len(buckets)
+        self.sum = 0.0
+        self.count = 0
+
+    def observe(self, value: float):
+        self.sum += value
+        self.count += 1
+        i = bisect.bisect_left(self.buckets, value)
+        if i < len(self.counts):
+            self.counts[i] += 1
+
+
+class RequestStats:
+    __slots__ = ("db_count", "db_seconds", "statements", "redis_commands", "redis_roundtrips")
+
+    def __init__(self):
+        self.db_count = 0
+        self.db_seconds = 0.0
+        self.statements: dict[str, list] = {}   # key -> [count, seconds]
+        self.redis_commands = 0
+        self.redis_roundtrips = 0
+
+
+_current: ContextVar[Optional[RequestStats]] = ContextVar("request_stats", default=None)
+
+# (method, route) keyed
+_http_latency: dict[tuple, Histogram] = {}
+_http_db_queries: dict[tuple, Histogram] = {}
+_http_db_seconds: dict[tuple, float] = {}
+_http_redis_commands: dict[tuple, Histogram] = {}
+# (method, route, status) keyed
+_http_requests: dict[tuple, int] = {}
+_slow_requests = 0
+
+_db_latency = Histogram(LATENCY_BUCKETS)
+_redis_commands: dict[str, int] = {}
+_redis_roundtrips = 0
+_ws_fanout: dict[str, Histogram] = {}
+
+_route_paths: dict = {}
+
+
+# ---------------------------------------------------------------- probes
+
+
+def _statement_key(statement: str) -> str:
+    return " ".join(statement[:STATEMENT_KEY_CHARS * 2].split())[:STATEMENT_KEY_CHARS]
+
+
+def record_query(statement: str, seconds: float) -> None:
+    _db_latency.observe(seconds)
+    stats = _current.get()
+    if stats is None:
+        return
+    stats.db_count += 1
+    stats.db_seconds += seconds
+    key = _statement_key(statement)
+    entry = stats.statements.get(key)
+    if entry is None:
+        if len(stats.statements) >= MAX_STATEMENT_KEYS:
+            key = "(other)"
+            entry = stats.statements.get(key)
+        if entry is None:
+            stats.statements[key] = [1, seconds]
+            return
+    entry[0] += 1
+    entry[1] += seconds
+
+
+def instrument_engine(sync_engine) -> None:
+    """Count and time every statement run on `sync_engine` (AsyncEngine.sync_engine)."""
+    from sqlalchemy import event
+
+    @event.listens_for(sync_engine, "before_cursor_execute")
+    def _before(conn, cursor, statement, parameters, context, executemany):
+        conn.info["metrics_query_start"] = time.perf_counter()
+
+    @event.listens_for(sync_engine, "after_cursor_execute")
+    def _after(conn, cursor, statement, parameters, context, executemany):
+        started = conn.info.pop("metrics_query_start", None)
+        if started is not None:
+            record_query(statement, time.perf_counter() - started)
+
+
+def record_redis(command: str, count: int = 1) -> None:
+    """`count` commands sent in one round trip (a pipeline passes its size)."""
+    global _redis_roundtrips
+    _redis_roundtrips += 1
+    _redis_commands[command] = _redis_commands.get(command, 0) + count
+    stats = _current.get()
+    if stats is not None:
+        stats.redis_commands += count
+        stats.redis_roundtrips += 1
+
+
+def observe_fanout(kind: str, recipients: int) -> None:
+    hist = _ws_fanout.get(kind)
+    if hist is None:
+        hist = _ws_fanout[kind] = Histogram(FANOUT_BUCKETS)
+    hist.observe(recipients)
+
+
+# ---------------------------------------------------------------- middleware
+
+
+def _route_label(scope) -> str:
+    endpoint = scope.get("endpoint")
+    if endpoint is None:
+        return "unmatched"
+    path = _route_paths.get(endpoint)
+    if path is None:
+        app = scope.get("app")
+        for route in getattr(app, "routes", ()):
+            target = getattr(route, "endpoint", None) or getattr(route, "app", None)
+            if target is not None:
+                _route_paths.setdefault(target, route.path or "/")
+        path = _route_paths.setdefault(endpoint, "unmatched")
+    return path
+
+
+class MetricsMiddleware:
+    """Pure ASGI (no BaseHTTPMiddleware), so the context variable it sets is
+    the one the endpoint and its dependencies see. Latency stops at the last
+    response body message; background tasks that run after it still add
+    their queries to the request's counts."""
+
+    def __init__(self, app):
+        self.app = app
+
+    async def __call__(self, scope, receive, send):
+        if scope["type"] != "http":
+            await self.app(scope, receive, send)
+            return
+
+        stats = RequestStats()
+        token = _current.set(stats)
+        started = time.perf_counter()
+        finished = None
+        status = 500
+
+        async def send_wrapper(message):
+            nonlocal status, finished
+            if message["type"] == "http.response.start":
+                status = message["status"]
+            elif message["type"] == "http.response.body" and not message.get("more_body"):
+                finished = time.perf_counter()
+            await send(message)
+
+        try:
+            await self.app(scope, receive, send_wrapper)
+        finally:
+            _current.reset(token)
+            elapsed = (finished or time.perf_counter()) - started
+            _observe_request(scope, status, elapsed, stats)
+
+
+def _observe_request(scope, status: int, elapsed: float, stats: RequestStats) -> None:
+    global _slow_requests
+    method = scope.get("method", "GET")
+    key = (method, _route_label(scope))
+
+    hist = _http_latency.get(key)
+    if hist is None:
+        hist = _http_latency[key] = Histogram(LATENCY_BUCKETS)
+        _http_db_queries[key] = Histogram(COUNT_BUCKETS)
+        _http_redis_commands[key] = Histogram(COUNT_BUCKETS)
+        _http_db_seconds[key] = 0.0
+    hist.observe(elapsed)
+    _http_db_queries[key].observe(stats.db_count)
+    _http_redis_commands[key].observe(stats.redis_commands)
+    _http_db_seconds[key] += stats.db_seconds
+    status_key = (method, key[1], str(status))
+    _http_requests[status_key] = _http_requests.get(status_key, 0) + 1
+
+    elapsed_ms = elapsed * 1000
+    if elapsed_ms >= settings.SLOW_REQUEST_MS:
+        _slow_requests += 1
+        top = sorted(stats.statements.items(), key=lambda kv: kv[1][1], reverse=True)
+        breakdown = "; ".join(
+            f"{n}x {s * 1000:.1f}ms {stmt}" for stmt, (n, s) in top[:SLOW_LOG_TOP_STATEMENTS]
+        )
+        logger.warning(
+            f"Slow request {method} {scope.get('path')} -> {status} in {elapsed_ms:.0f}ms: "
+            f"db {stats.db_count} queries / {stats.db_seconds * 1000:.0f}ms, "
+            f"redis {stats.redis_commands} commands / {stats.redis_roundtrips} round trips"
+            + (f" | {breakdown}" if breakdown else "")
+        )
+
+
+# ---------------------------------------------------------------- exposition
+
+
+def _escape(value: str) -> str:
+    return value.replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n")
+
+
+def _labels(**labels) -> str:
+    labels["worker"] = _WORKER
+    return "{" + ",".join(f'{k}="{_escape(str(v))}"' for k, v in labels.items()) + "}"
+
+
+def _format(value: float) -> str:
+    return repr(float(value)) if isinstance(value, float) else str(value)
+
+
+class _Writer:
+    def __init__(self):
+        self.lines: list[str] = []
+
+    def metric(self, name: str, kind: str, help_text: str):
+        self.lines.append(f"# HELP {name} {help_text}")
+        self.lines.append(f"# TYPE {name} {kind}")
+
+    def sample(self, name: str, value, **labels):
+        self.lines.append(f"{name}{_labels(**labels)} {_format(value)}")
+
+    def histogram(self, name: str, hist: Histogram, **labels):
+        cumulative = 0
+        for bound, n in zip(hist.buckets, hist.counts):
+            cumulative += n
+            self.sample(f"{name}_bucket", cumulative, **labels, le=_format(float(bound)))
+        self.sample(f"{name}_bucket", hist.count, **labels, le="+Inf")
+        self.sample(f"{name}_sum", hist.sum, **labels)
+        self.sample(f"{name}_count", hist.count, **labels)
+
+
+def render(ws_stats: Optional[dict] = None) -> str:
+    """Prometheus text exposition (format 0.0.4) of this worker's metrics."""
+    from services.cache import cache_stats
+
+    w = _Writer()
+
+    w.metric("http_request_duration_seconds", "histogram", "Request latency by route template.")
+    for (method, route), hist in sorted(_http_latency.items()):
+        w.histogram("http_request_duration_seconds", hist, method=method, route=route)
+
+    w.metric("http_requests_total", "counter", "Requests by route template and status.")
+    for (method, route, status), n in sorted(_http_requests.items()):
+        w.sample("http_requests_total", n, method=method, route=route, status=status)
+
+    w.metric("http_request_db_queries", "histogram", "SQL statements per request.")
+    for (method, route), hist in sorted(_http_db_queries.items()):
+        w.histogram("http_request_db_queries", hist, method=method, route=route)
+
+    w.metric("http_request_db_seconds_total", "counter", "SQL time spent by requests.")
+    for (method, route), seconds in sorted(_http_db_seconds.items()):
+        w.sample("http_request_db_seconds_total", seconds, method=method, route=route)
+
+    w.metric("http_request_redis_commands", "histogram", "Redis commands per request.")
+    for (method, route), hist in sorted(_http_redis_commands.items()):
+        w.histogram("http_request_redis_commands", hist, method=method, route=route)
+
+    w.metric("http_slow_requests_total", "counter", "Requests slower than SLOW_REQUEST_MS.")
+    w.sample("http_slow_requests_total", _slow_requests)
+
+    w.metric("db_query_duration_seconds", "histogram", "Latency of every SQL statement (requests and background).")
+    w.histogram("db_query_duration_seconds", _db_latency)
+
+    w.metric("redis_commands_total", "counter", "Redis commands sent, by command.")
+    for command, n in sorted(_redis_commands.items()):
+        w.sample("redis_commands_total", n, command=command)
+
+    w.metric("redis_roundtrips_total", "counter", "Redis network round trips (a pipeline is one).")
+    w.sample("redis_roundtrips_total", _redis_roundtrips)
+
+    cache = cache_stats()
+    w.metric("cache_lookups_total", "counter", "services.cache lookups by namespace and outcome.")
+    for ns, c in cache["namespaces"].items():
+        for outcome in ("l1", "redis", "miss"):
+            w.sample("cache_lookups_total", c[outcome], namespace=ns, outcome=outcome)
+    w.metric("cache_l1_items", "gauge", "Entries in this worker's L1 cache.")
+    w.sample("cache_l1_items", cache["l1_items"])
+
+    w.metric("ws_fanout_recipients", "histogram", "Sockets targeted per WebSocket fan-out.")
+    for kind, hist in sorted(_ws_fanout.items()):
+        w.histogram("ws_fanout_recipients", hist, channel=kind)
+
+    if ws_stats:
+        w.metric("ws_connections", "gauge", "Open WebSocket connections on this worker.")
+        for kind in ("user", "bounce", "venue_feed"):
+            w.sample("ws_connections", ws_stats.get(f"{kind}_connections", 0), kind=kind)
+        for field, help_text in (
+            ("delivered", "WebSocket messages written."),
+            ("dropped", "WebSocket messages dropped on full outboxes."),
+            ("slow_disconnects", "Sockets closed as slow consumers."),
+        ):
+            name = f"ws_{field}_total"
+            w.metric(name, "counter", help_text)
+            for kind, c in sorted(ws_stats.get("channels", {}).items()):
+                w.sample(name, c[field], channel=kind)
+
+    return "\n".join(w.lines) + "\n"
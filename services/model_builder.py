@@ -0,0 +1,142 @@
+"""Dedicated model builder process.
+
+    python -m services.model_builder
+
+Fits the recommendation model and then the matching model (which takes the
+recsys embeddings for its prior) every MODEL_TTL_SECONDS and publishes
+them as one snapshot (services/model_snapshot.py). startup.py spawns it
+next to uvicorn when MODEL_BUILDER_MODE=process, so the GIL-heavy numpy
+work never runs inside a worker serving requests.
+
+When several replicas share a MODEL_SNAPSHOT_DIR volume, a Redis leader
+lease makes only one of them fit per cycle. Without Redis every builder
+fits on its own — one fit per host instead of per worker.
+
+Workers that find no fresh snapshot (first boot, builder restarting) call
+build_or_wait: the first to get the host build lock fits and publishes,
+the rest wait for that snapshot instead of all fitting inline at once.
+"""
+
+import asyncio
+import logging
+import os
+import socket
+import time
+from typing import Optional
+
+from db.database import create_async_session
+from services import matching, recommendations
+from services.model_snapshot import (
+    acquire_build_lock,
+    current_models,
+    publish,
+    read_current_version,
+    release_build_lock,
+)
+from services.redis import get_redis
+
+logger = logging.getLogger(__name__)
+
+BUILD_INTERVAL_SECONDS = recommendations.MODEL_TTL_SECONDS
+LEADER_KEY = "model_builder:leader"
+LEADER_TTL_SECONDS = BUILD_INTERVAL_SECONDS * 2
+SNAPSHOT_WAIT_SECONDS = 180     # longest a worker waits on another process's fit
+SNAPSHOT_WAIT_POLL_SECONDS = 1.0
+
+_wait_lock = asyncio.Lock()     # one waiter per worker; other requests queue behind it
+
+
+async def _acquire_leader(owner: str) -> bool:
+    try:
+        r = await get_redis()
+        if await r.set(LEADER_KEY, owner, nx=True, ex=LEADER_TTL_SECONDS):
+            return True
+        if await r.get(LEADER_KEY) == owner:
+            await r.expire(LEADER_KEY, LEADER_TTL_SECONDS)
+            return True
+        return False
+    except Exception as e:
+        logger.warning(f"Model builder: leader lease unavailable ({e}), building locally")
+        return True
+
+
+async def build_once() -> int:
+    """Fit and publish under the host build lock. If someone else published
+    while we waited for the lock, keep theirs."""
+    before = read_current_version()
+    fd = await asyncio.to_thread(acquire_build_lock, True)
+    try:
+        version = read_current_version()
+        if version != before:
+            return version
+        return await _fit_and_publish()
+    finally:
+        release_build_lock(fd)
+
+
+async def _fit_and_publish() -> int:
+    t0 = time.monotonic()
+    async with create_async_session() as db:
+        rec_raw = await recommendations._load_raw(db)
+        match_raw = await matching._load_raw(db)
+    rec_model = await asyncio.to_thread(recommendations._fit, rec_raw)
+    match_model = await asyncio.to_thread(matching._fit, match_raw, rec_model)
+    version = await asyncio.to_thread(publish, rec_model, match_model)
+    logger.info(f"Model builder: published v{version} in {time.monotonic() - t0:.1f}s")
+    return version
+
+
+async def build_or_wait(is_fresh) -> Optional[tuple]:
+    """Called by a worker when current_models() has nothing fresh. Fits and
+    publishes if no other process on the host is fitting; otherwise waits up
+    to SNAPSHOT_WAIT_SECONDS for that fit. Returns the newest snapshot (maybe
+    stale, if the wait ran out), or None when there is none at all."""
+    async with _wait_lock:
+        snap = await current_models(refresh=True)
+        if snap is not None and is_fresh(snap):
+            return snap
+        seen = read_current_version()
+        deadline = time.monotonic() + SNAPSHOT_WAIT_SECONDS
+        while read_current_version() == seen:
+            fd = acquire_build_lock(block=False)
+            if fd is not None:
+                # Nobody is fitting (builder down or not up yet): this worker does
+                try:
+                    if read_current_version() == seen:
+                        logger.warning("No fresh model snapshot and no builder fitting, fitting in this worker")
+                        await _fit_and_publish()
+                except Exception as e:
+                    logger.error(f"Model fit in worker failed: {e}")
+                finally:
+                    release_build_lock(fd)
+                break
+            if time.monotonic() > deadline:
+                logger.warning(f"Model snapshot still building after {SNAPSHOT_WAIT_SECONDS}s, serving what we have")
+                return snap
+            await asyncio.sleep(SNAPSHOT_WAIT_POLL_SECONDS)
+        return await current_models(refresh=True)
+
+
+async def run_forever():
+    owner = f"{socket.gethostname()}:{os.getpid()}"
+    while True:
+        started = time.monotonic()
+        try:
+            # Non-leaders still build when nobody is publishing into their
+            # directory (no shared volume, or the leader died)
+            version = read_current_version()
+            stale = version is None or time.time() - version / 1000 > LEADER_TTL_SECONDS
+            if await _acquire_leader(owner) or stale:
+                await build_once()
+        except Exception as e:
+            logger.error(f"Model builder: build failed: {e}")
+        await asyncio.sleep(max(5.0, BUILD_INTERVAL_SECONDS - (time.monotonic() - started)))
+
+
+if __name__ == "__main__":
+    logging.basicConfig(
+        level=logging.INFO,
+        format="%(asctime)s - %(name)s - %(levelname)s - %(message)s",
+        datefmt="%Y-%m-%d %H:%M:%S",
+    )
+    asyncio.run(run_forever())
@@ -0,0 +1,210 @@
+"""Versioned, memory-mappable snapshots of the recsys + matching models.
+
+The builder process (services/model_builder.py) fits both models and
+publishes them here; every API worker maps the newest snapshot read-only
+instead of fitting its own copy.
+
+Layout under settings.MODEL_SNAPSHOT_DIR:
+
+    CURRENT                  version id of the live snapshot (atomic replace)
+    v<version>/recsys/       <attr>.npy per ndarray, <attr>.{data,indices,indptr}.npy
+                             per CSR matrix, state.pkl for index maps / dicts
+    v<version>/matching/     same, for the MatchingModel
+
+Publishing writes into a temp dir, renames it into place and only then
+flips CURRENT, so a reader never sees a half-written version. Arrays load
+with mmap_mode="r": all workers on a host share one copy through the page
+cache. Old versions are pruned after SNAPSHOT_KEEP newer ones exist; a
+worker still mapping a pruned version keeps its pages until it swaps.
+
+BUILD.lock (flock) serializes fits on a host: the builder holds it while
+fitting, and a worker that finds no fresh snapshot only fits itself when
+nobody holds it (services/model_builder.build_or_wait).
+"""
+
+import asyncio
+import fcntl
+import logging
+import os
+import pickle
+import shutil
+import time
+from pathlib import Path
+from typing import Optional
+
+import numpy as np
+import scipy.sparse as sp
+
+from core.config import settings
+from services.candidate_index import CandidateIndex, index_from_state, index_state
+
+logger = logging.getLogger(__name__)
+
+SNAPSHOT_KEEP = 3
+SNAPSHOT_POLL_SECONDS = 5.0
+CURRENT_FILE = "CURRENT"
+BUILD_LOCK_FILE = "BUILD.lock"
+
+# Matching shares the recsys embeddings — relinked on load, never stored twice
+_MATCHING_SHARED = {"rec_X": "X", "rec_G": "G"}
+
+
+def _root() -> Path:
+    return Path(settings.MODEL_SNAPSHOT_DIR)
+
+
+# ---------------------------------------------------------------- writing
+
+
+def _dump_model(model, out: Path, skip: tuple = ()) -> None:
+    """ndarrays and CSR matrices -> .npy, candidate indexes -> their arrays,
+    everything else -> state.pkl. Private (_-prefixed) caches are dropped:
+    each worker starts them empty."""
+    out.mkdir(parents=True)
+    state: dict = {"__sparse__": {}, "__index__": {}}
+    for name, value in vars(model).items():
+        if name.startswith("_") or name in skip:
+            continue
+        if isinstance(value, np.ndarray):
+            np.save(out / f"{name}.npy", value)
+        elif sp.issparse(value):
+            csr = value.tocsr()
+            for part in ("data", "indices", "indptr"):
+                np.save(out / f"{name}.{part}.npy", getattr(csr, part))
+            state["__sparse__"][name] = csr.shape
+        elif isinstance(value, CandidateIndex):
+            kind, arrays = index_state(value)
+            for part, arr in arrays.items():
+                np.save(out / f"{name}.{part}.npy", arr)
+            state["__index__"][name] = (kind, list(arrays))
+        else:
+            state[name] = value
+    with open(out / "state.pkl", "wb") as f:
+        pickle.dump(state, f, protocol=pickle.HIGHEST_PROTOCOL)
+
+
+def publish(recsys, matching) -> int:
+    """Write both models as a new version and make it current."""
+    root = _root()
+    root.mkdir(parents=True, exist_ok=True)
+    version = int(time.time() * 1000)
+    tmp = root / f".tmp-{version}-{os.getpid()}"
+    _dump_model(recsys, tmp / "recsys")
+    _dump_model(matching, tmp / "matching", skip=tuple(_MATCHING_SHARED))
+    tmp.rename(root / f"v{version}")
+
+    pointer = root / f".{CURRENT_FILE}.{os.getpid()}"
+    pointer.write_text(str(version))
+    os.replace(pointer, root / CURRENT_FILE)
+
+    versions = sorted(int(p.name[1:]) for p in root.glob("v*") if p.name[1:].isdigit())
+    for old in versions[:-SNAPSHOT_KEEP]:
+        shutil.rmtree(root / f"v{old}", ignore_errors=True)
+    return version
+
+
+def acquire_build_lock(block: bool) -> Optional[int]:
+    """Exclusive host-wide build lock: an fd for release_build_lock, or None
+    when block=False and another process holds it. Released by the kernel
+    if the holder dies."""
+    root = _root()
+    root.mkdir(parents=True, exist_ok=True)
+    fd = os.open(root / BUILD_LOCK_FILE, os.O_RDWR | os.O_CREAT, 0o644)
+    try:
+        fcntl.flock(fd, fcntl.LOCK_EX if block else fcntl.LOCK_EX | fcntl.LOCK_NB)
+        return fd
+    except BlockingIOError:
+        os.close(fd)
+        return None
+    except BaseException:
+        os.close(fd)
+        raise
+
+
+def release_build_lock(fd: int) -> None:
+    try:
+        fcntl.flock(fd, fcntl.LOCK_UN)
+    finally:
+        os.close(fd)
+
+
+# ---------------------------------------------------------------- reading
+
+
+def _load_model(cls, src: Path):
+    model = cls()
+    with open(src / "state.pkl", "rb") as f:
+        state = pickle.load(f)
+    sparse = state.pop("__sparse__")
+    indexes = state.pop("__index__")
+    for name, value in state.items():
+        setattr(model, name, value)
+    for path in src.glob("*.npy"):
+        name = path.name[:-4]
+        if "." not in name:
+            setattr(model, name, np.load(path, mmap_mode="r"))
+    for name, shape in sparse.items():
+        parts = [np.load(src / f"{name}.{p}.npy", mmap_mode="r")
+                 for p in ("data", "indices", "indptr")]
+        setattr(model, name, sp.csr_matrix(tuple(parts), shape=shape, copy=False))
+    for name, (kind, parts) in indexes.items():
+        vectors = getattr(model, "Y" if name == "mf_index" else "GV")
+        arrays = {p: np.load(src / f"{name}.{p}.npy", mmap_mode="r") for p in parts}
+        setattr(model, name, index_from_state(kind, vectors, arrays))
+    return model
+
+
+def read_current_version() -> Optional[int]:
+    try:
+        return int((_root() / CURRENT_FILE).read_text().strip())
+    except (OSError, ValueError):
+        return None
+
+
+def load_version(version: int):
+    """(recsys, matching) for `version`, arrays memory-mapped read-only."""
+    from services.matching import MatchingModel
+    from services.recommendations import RecommendationModel
+
+    base = _root() / f"v{version}"
+    recsys = _load_model(RecommendationModel, base / "recsys")
+    matching = _load_model(MatchingModel, base / "matching")
+    for attr, src in _MATCHING_SHARED.items():
+        setattr(matching, attr, getattr(recsys, src))
+    return recsys, matching
+
+
+class _Mapped:
+    version: Optional[int] = None
+    recsys = None
+    matching = None
+    checked_at: float = 0.0
+
+
+_mapped = _Mapped()
+_swap_lock = asyncio.Lock()
+
+
+async def current_models(refresh: bool = False):
+    """Latest published (recsys, matching), or None when no snapshot exists.
+    The CURRENT pointer is re-read at most every SNAPSHOT_POLL_SECONDS
+    (always with refresh=True); a new version is loaded off the event loop
+    and swapped in with one assignment, so in-flight requests keep the
+    model they started with."""
+    now = time.monotonic()
+    if not refresh and now - _mapped.checked_at < SNAPSHOT_POLL_SECONDS:
+        return (_mapped.recsys, _mapped.matching) if _mapped.version else None
+    async with _swap_lock:
+        if not refresh and time.monotonic() - _mapped.checked_at < SNAPSHOT_POLL_SECONDS:
+            return (_mapped.recsys, _mapped.matching) if _mapped.version else None
+        _mapped.checked_at = time.monotonic()
+        version = read_current_version()
+        if version is not None and version != _mapped.version:
+            try:
+                recsys, matching = await asyncio.to_thread(load_version, version)
+                _mapped.recsys, _mapped.matching = recsys, matching
+                _mapped.version = version
+                logger.info(f"Mapped model snapshot v{version}")
+            except Exception as e:
+                logger.warning(f"Model snapshot v{version} load failed: {e}")
+    return (_mapped.recsys, _mapped.matching) if _mapped.version else None
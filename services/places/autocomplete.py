@@ -11,6 +11,11 @@ Redis Data Structures:
 - places:autocomplete:index (sorted set) - prefix search via ZRANGEBYLEX
 - places:geo (geo set) - radius search via GEORADIUS
 - places:meta:{place_id} (hash) - shared metadata for both search types
+- places:autocomplete:changes (sorted set) - recently (re)indexed place ids
+
+Autocomplete is answered from each worker's in-memory copy of the index
+(services/places/local_index.py) once it is built; the Redis lookup below is
+the fallback while it isn't.
 """
 
 import json
@@ -20,6 +25,7 @@ import time
 import unicodedata
 from typing import List, Optional, Tuple
 
+from services.places.local_index import local_index, log_change
 from services.redis import get_redis
 
 logger = logging.getLogger(__name__)
@@ -30,6 +36,9 @@ GEO_INDEX = "places:geo"
 META_PREFIX = "places:meta:"
 META_TTL = 30 * 24 * 3600  # 30 days
 
+# Per-worker counters: where autocomplete answers came from
+_stats = {"searches": 0, "local": 0, "redis": 0, "empty": 0, "google_fallbacks": 0}
+
 
 def normalize_name(name: str) -> str:
     """
@@ -116,8 +125,16 @@ async def index_place(
         pipe.hset(meta_key, mapping=metadata)
         pipe.hsetnx(meta_key, "bounce_count", str(bounce_count))
         pipe.expire(meta_key, META_TTL)
+        log_change(pipe, place_id)
 
         await pipe.execute()
+
+        # This worker sees the place right away; others on their next poll
+        existing = local_index.meta.get(place_id)
+        local_index.upsert(place_id, normalized, (
+            name, address or "", float(lat), float(lng),
+            existing[4] if existing else bounce_count, types or [], photo_url,
+        ))
         logger.debug(f"Indexed place {place_id}: {name}")
         return True
 
@@ -145,7 +162,9 @@ async def remove_place_from_index(place_id: str, normalized_name: str) -> bool:
             pipe.zrem(AUTOCOMPLETE_INDEX, *entries_to_remove)
         pipe.zrem(GEO_INDEX, place_id)
         pipe.delete(f"{META_PREFIX}{place_id}")
+        log_change(pipe, place_id)
         await pipe.execute()
+        local_index.remove(place_id)
 
         return True
     except Exception as e:
@@ -194,14 +213,27 @@ async def global_autocomplete_search(
     Returns:
         Tuple of (list of place dicts with PlacePrediction-compatible fields, cache_hit bool)
     """
+    _stats["searches"] += 1
+    # Normalize query for prefix matching
+    normalized_query = normalize_name(query)
+    if not normalized_query:
+        return [], False
+
+    local = local_index.search(normalized_query)
+    if local is not None:
+        results = [
+            _build_result(pid, name, address, lat, lng, bounce_count, types, photo_url, user_lat, user_lng)
+            for pid, (name, address, lat, lng, bounce_count, types, photo_url) in local
+        ]
+        results.sort(key=lambda x: x["_score"], reverse=True)
+        for r in results:
+            del r["_score"]
+        _stats["local" if results else "empty"] += 1
+        return results[:limit], bool(results)
+
     try:
         redis = await get_redis()
 
-        # Normalize query for prefix matching
-        normalized_query = normalize_name(query)
-        if not normalized_query:
-            return [], False
-
         # Prefix search: get entries starting with query
         # "[query" = inclusive lower bound, "[query\xff" = exclusive upper bound
         min_lex = f"[{normalized_query}"
@@ -217,6 +249,7 @@ async def global_autocomplete_search(
         )
 
         if not raw_entries:
+            _stats["empty"] += 1
             return [], False
 
         # Extract place_ids from entries (format: "normalized_name:place_id")
@@ -246,18 +279,6 @@ async def global_autocomplete_search(
                 continue
 
             place_id = place_ids[i]
-            lat = float(meta.get("lat", 0))
-            lng = float(meta.get("lng", 0))
-            bounce_count = int(meta.get("bounce_count", 0))
-
-            # Calculate distance if user location provided
-            distance_meters = None
-            if user_lat is not None and user_lng is not None:
-                distance_meters = haversine_distance_meters(user_lat, user_lng, lat, lng)
-
-            # Calculate combined score
-            score = calculate_score(bounce_count, distance_meters)
-
             # Parse types
             types_str = meta.get("types", "[]")
             try:
@@ -265,19 +286,12 @@ async def global_autocomplete_search(
             except:
                 types = []
 
-            results.append({
-                "place_id": place_id,
-                "name": meta.get("name", ""),
-                "address": meta.get("address", ""),
-                "full_description": f"{meta.get('name', '')} - {meta.get('address', '')}" if meta.get("address") else meta.get("name", ""),
-                "latitude": lat,
-                "longitude": lng,
-                "distance_meters": distance_meters,
-                "bounce_count": bounce_count,
-                "photo_url": meta.get("photo_url"),
-                "types": types,
-                "_score": score  # Internal, for sorting
-            })
+            results.append(_build_result(
+                place_id, meta.get("name", ""), meta.get("address", ""),
+                float(meta.get("lat", 0)), float(meta.get("lng", 0)),
+                int(meta.get("bounce_count", 0)), types, meta.get("photo_url"),
+                user_lat, user_lng,
+            ))
 
         # Lazily reap orphaned index entries (meta expired 30d ago)
         if orphaned:
@@ -297,6 +311,7 @@ async def global_autocomplete_search(
         for r in results:
             del r["_score"]
 
+        _stats["redis"] += 1
         return results[:limit], True
 
     except Exception as e:
@@ -304,6 +319,45 @@ async def global_autocomplete_search(
         return [], False
 
 
+def _build_result(place_id: str, name: str, address: str, lat: float, lng: float,
+                  bounce_count: int, types: list, photo_url: Optional[str],
+                  user_lat: Optional[float], user_lng: Optional[float]) -> dict:
+    """PlacePrediction-compatible dict plus the internal `_score`."""
+    # Calculate distance if user location provided
+    distance_meters = None
+    if user_lat is not None and user_lng is not None:
+        distance_meters = haversine_distance_meters(user_lat, user_lng, lat, lng)
+
+    return {
+        "place_id": place_id,
+        "name": name,
+        "address": address,
+        "full_description": f"{name} - {address}" if address else name,
+        "latitude": lat,
+        "longitude": lng,
+        "distance_meters": distance_meters,
+        "bounce_count": bounce_count,
+        "photo_url": photo_url,
+        "types": types,
+        "_score": calculate_score(bounce_count, distance_meters)  # Internal, for sorting
+    }
+
+
+def record_google_fallback() -> None:
+    """Called by the autocomplete route when it has to go to Google."""
+    _stats["google_fallbacks"] += 1
+
+
+def autocomplete_stats() -> dict:
+    searches = _stats["searches"]
+    return {
+        **_stats,
+        "google_fallback_rate": round(_stats["google_fallbacks"] / searches, 4) if searches else 0.0,
+        "local_index_ready": local_index.ready,
+        "local_index_places": len(local_index.meta),
+        "local_index_entries": len(local_index.entries),
+    }
+
 
 def haversine_distance_meters(lat1: float, lon1: float, lat2: float, lon2: float) -> int:
     """Calculate distance between two points in meters using Haversine formula."""
@@ -0,0 +1,214 @@
+"""
+Per-worker in-memory copy of the global autocomplete index.
+
+Every keystroke used to cost a ZRANGEBYLEX plus a pipeline of HGETALLs before
+Python re-ranked the hits. Redis stays the source of truth, but each worker
+now keeps a compiled copy it can answer from without a network hop:
+
+- entries: sorted list of the same "suffix:place_id" strings as
+  places:autocomplete:index; a prefix is a bisect range over it
+- meta: place_id -> packed tuple (name, address, lat, lng, bounce_count,
+  types, photo_url), parsed once instead of per request
+
+Sync:
+- full rebuild from Redis at startup and every FULL_SYNC_SECONDS (drops
+  orphans whose meta hash expired, picks up bounce_count drift)
+- incremental: index_place / remove_place_from_index append the place id to
+  CHANGES_KEY (sorted set scored by time); every POLL_SECONDS each worker
+  re-reads the meta of ids changed since its cursor. The writing worker
+  applies its own change immediately.
+
+Until the first rebuild finishes `search` returns None and callers use the
+Redis path.
+"""
+
+import asyncio
+import bisect
+import json
+import logging
+import time
+from typing import Dict, List, Optional, Tuple
+
+from services.redis import get_redis
+
+logger = logging.getLogger(__name__)
+
+CHANGES_KEY = "places:autocomplete:changes"
+CHANGES_RETENTION_SECONDS = 3600
+CHANGES_OVERLAP_SECONDS = 10       # re-read a little history to absorb clock skew
+FULL_SYNC_SECONDS = 1800
+POLL_SECONDS = 5
+LOAD_CHUNK = 5000
+MAX_CANDIDATES = 500               # entries scored per query (Redis path: limit * 5)
+
+_MAX_CHAR = "\U0010ffff"
+
+# (name, address, lat, lng, bounce_count, types, photo_url)
+PlaceMeta = Tuple[str, str, float, float, int, list, Optional[str]]
+
+
+def _pack_meta(meta: dict) -> Optional[PlaceMeta]:
+    if not meta:
+        return None
+    try:
+        types = json.loads(meta.get("types", "[]"))
+    except Exception:
+        types = []
+    return (
+        meta.get("name", ""),
+        meta.get("address", ""),
+        float(meta.get("lat", 0)),
+        float(meta.get("lng", 0)),
+        int(meta.get("bounce_count", 0)),
+        types,
+        meta.get("photo_url"),
+    )
+
+
+def _entries_for(normalized: str, place_id: str) -> List[str]:
+    words = normalized.split()
+    return [f"{' '.join(words[i:])}:{place_id}" for i in range(len(words))]
+
+
+class LocalAutocompleteIndex:
+    def __init__(self):
+        self.entries: List[str] = []
+        self.meta: Dict[str, PlaceMeta] = {}
+        self.ready = False
+        self.built_at = 0.0
+        self.cursor = 0.0
+
+    # ------------------------------------------------------------ queries
+
+    def search(self, normalized_query: str, limit: int = MAX_CANDIDATES) -> Optional[List[Tuple[str, PlaceMeta]]]:
+        """Up to `limit` distinct (place_id, meta) matches in lexical order,
+        or None when the index has not been built yet."""
+        if not self.ready:
+            return None
+        entries = self.entries
+        lo = bisect.bisect_left(entries, normalized_query)
+        hi = bisect.bisect_left(entries, normalized_query + _MAX_CHAR, lo)
+        found: Dict[str, PlaceMeta] = {}
+        for i in range(lo, hi):  # no slice: a short prefix can span much of the index
+            place_id = entries[i].rsplit(":", 1)[-1]
+            if place_id in found:
+                continue
+            meta = self.meta.get(place_id)
+            if meta is not None:
+                found[place_id] = meta
+                if len(found) >= limit:
+                    break
+        return list(found.items())
+
+    # ------------------------------------------------------------ updates
+
+    def upsert(self, place_id: str, normalized_name: str, meta: PlaceMeta) -> None:
+        entries = self.entries
+        for entry in _entries_for(normalized_name, place_id):
+            i = bisect.bisect_left(entries, entry)
+            if i == len(entries) or entries[i] != entry:
+                entries.insert(i, entry)
+        self.meta[place_id] = meta
+
+    def remove(self, place_id: str) -> None:
+        # Entries without meta are skipped by search and dropped by the next rebuild
+        self.meta.pop(place_id, None)
+
+    # ------------------------------------------------------------ sync
+
+    async def rebuild(self) -> int:
+        """Load the whole index from Redis and swap it in. Returns place count."""
+        from services.places.autocomplete import AUTOCOMPLETE_INDEX, META_PREFIX
+
+        started = time.time()
+        redis = await get_redis()
+        entries: List[str] = []
+        start = 0
+        while True:
+            chunk = await redis.zrange(AUTOCOMPLETE_INDEX, start, start + LOAD_CHUNK - 1)
+            entries.extend(chunk)
+            if len(chunk) < LOAD_CHUNK:
+                break
+            start += LOAD_CHUNK
+
+        place_ids = list({e.rsplit(":", 1)[-1] for e in entries})
+        meta: Dict[str, PlaceMeta] = {}
+        for i in range(0, len(place_ids), LOAD_CHUNK):
+            batch = place_ids[i:i + LOAD_CHUNK]
+            pipe = redis.pipeline(transaction=False)
+            for pid in batch:
+                pipe.hgetall(f"{META_PREFIX}{pid}")
+            for pid, raw in zip(batch, await pipe.execute()):
+                packed = _pack_meta(raw)
+                if packed is not None:
+                    meta[pid] = packed
+
+        # ZRANGE is already lexicographic for score-0 members; keep only live ones
+        self.entries = [e for e in entries if e.rsplit(":", 1)[-1] in meta]
+        self.meta = meta
+        self.built_at = time.time()
+        # Changes made while loading are re-read by the next poll
+        self.cursor = min(self.cursor, started) if self.ready else started
+        self.ready = True
+        return len(meta)
+
+    async def apply_changes(self) -> int:
+        """Re-read every place changed since the cursor. Returns how many."""
+        from services.places.autocomplete import META_PREFIX, normalize_name
+
+        redis = await get_redis()
+        now = time.time()
+        changed = await redis.zrangebyscore(CHANGES_KEY, self.cursor - CHANGES_OVERLAP_SECONDS, "+inf")
+        if changed:
+            pipe = redis.pipeline(transaction=False)
+            for pid in changed:
+                pipe.hgetall(f"{META_PREFIX}{pid}")
+            for pid, raw in zip(changed, await pipe.execute()):
+                packed = _pack_meta(raw)
+                if packed is None:
+                    self.remove(pid)
+                else:
+                    self.upsert(pid, normalize_name(packed[0]), packed)
+        self.cursor = now
+        return len(changed)
+
+
+local_index = LocalAutocompleteIndex()
+_sync_task: Optional[asyncio.Task] = None
+
+
+def log_change(pipe, place_id: str) -> None:
+    """Queue the change-log write for place_id on a writer's pipeline."""
+    now = time.time()
+    pipe.zadd(CHANGES_KEY, {place_id: now})
+    pipe.zremrangebyscore(CHANGES_KEY, "-inf", now - CHANGES_RETENTION_SECONDS)
+
+
+async def _sync_loop():
+    while True:
+        try:
+            if not local_index.ready or time.time() - local_index.built_at > FULL_SYNC_SECONDS:
+                count = await local_index.rebuild()
+                logger.info(f"Local autocomplete index built: {count} places, "
+                            f"{len(local_index.entries)} entries")
+            else:
+                await local_index.apply_changes()
+            await asyncio.sleep(POLL_SECONDS)
+        except asyncio.CancelledError:
+            break
+        except Exception as e:
+            logger.warning(f"Local autocomplete sync failed: {e}")
+            await asyncio.sleep(POLL_SECONDS * 6)
+
+
+async def start_autocomplete_sync():
+    global _sync_task
+    if _sync_task is None:
+        _sync_task = asyncio.create_task(_sync_loop())
+
+
+async def stop_autocomplete_sync():
+    global _sync_task
+    if _sync_task is not None:
+        _sync_task.cancel()
+        _sync_task = None
@@ -25,17 +25,18 @@ Why an LLM here at all, when the Bayesian layer already does the math:
    nudge in the Bayesian model (IDEA_BOOST) and as UI copy.
 
 Costs stay tiny: one call per user per ~3 days, one call per hot venue per
-day, all fire-and-forget behind a semaphore.
+day, all fire-and-forget at background priority through the shared LLM
+service (services/llm.py: global rate budget, response cache keyed by the
+prompt digest, so an unchanged digest never pays twice). No DB session is
+held while a call waits its turn.
 """
 
-import asyncio
 import json
 import logging
 from collections import Counter, defaultdict
 from datetime import datetime, timezone, timedelta
 from typing import Optional
 
-import httpx
 from sqlalchemy import select
 from sqlalchemy.ext.asyncio import AsyncSession
 
@@ -51,16 +52,15 @@ from db.models import (
     UserAgentProfile,
     VenueAgentProfile,
 )
+from services import llm
 
 logger = logging.getLogger(__name__)
 
 REFRESH_AFTER = timedelta(days=3)
 REFRESH_EVENT_DELTA = 10
 DIGEST_WINDOW_DAYS = 120
-GROQ_URL = "https://api.groq.com/openai/v1/chat/completions"
-GROQ_MODEL = "llama-3.1-8b-instant"
+VENUE_REFRESH_AFTER = timedelta(days=1)
 
-_refresh_semaphore = asyncio.Semaphore(3)
 _in_flight: set = set()
 
 PROFILE_SYSTEM = (
@@ -86,36 +86,15 @@ PROFILE_SCHEMA_HINT = """Respond with ONLY this JSON shape:
 Max 3 follow_ideas and 3 venue_ideas; only pick from the provided candidates; empty lists are fine."""
 
 
-async def _groq_json(system: str, user: str, max_tokens: int = 500) -> Optional[dict]:
-    if not settings.GROQ_API_KEY:
-        return None
-    try:
-        async with httpx.AsyncClient(timeout=20) as client:
-            resp = await client.post(
-                GROQ_URL,
-                headers={
-                    "Authorization": f"Bearer {settings.GROQ_API_KEY}",
-                    "Content-Type": "application/json",
-                },
-                json={
-                    "model": GROQ_MODEL,
-                    "max_tokens": max_tokens,
-                    "temperature": 0.3,
-                    "response_format": {"type": "json_object"},
-                    "messages": [
-                        {"role": "system", "content": system},
-                        {"role": "user", "content": user},
-                    ],
-                },
-            )
-            if resp.status_code != 200:
-                logger.warning(f"Groq profile call {resp.status_code}: {resp.text[:200]}")
-                return None
-            content = resp.json()["choices"][0]["message"]["content"]
-            return json.loads(content)
-    except Exception as e:
-        logger.warning(f"Groq profile call failed: {e}")
-        return None
+async def _groq_json(caller: str, system: str, user: str, max_tokens: int = 500,
+                     cache_ttl: Optional[int] = None) -> Optional[dict]:
+    return await llm.complete_json(
+        caller, system, user,
+        max_tokens=max_tokens,
+        temperature=0.3,
+        priority=llm.PRIORITY_BACKGROUND,
+        cache_ttl=cache_ttl,
+    )
 
 
 # ---------------- digest ----------------
@@ -210,51 +189,55 @@ async def refresh_user_profile(
         return
     _in_flight.add(user_id)
     try:
-        async with _refresh_semaphore:
-            async with create_async_session() as db:
-                existing = (await db.execute(
-                    select(UserAgentProfile).where(UserAgentProfile.user_id == user_id)
-                )).scalar_one_or_none()
-
-                digest, n_events = await _build_digest(db, user_id)
-                if existing and not force:
-                    age_ok = existing.updated_at and (
-                        datetime.now(timezone.utc) - existing.updated_at < REFRESH_AFTER
-                    )
-                    growth_ok = n_events - (existing.events_count or 0) < REFRESH_EVENT_DELTA
-                    if age_ok and growth_ok:
-                        return
-                if n_events < 3:
-                    return  # nothing to profile yet
-
-                prompt = digest + _candidate_block(candidate_people or [], candidate_venues or []) \
-                    + "\n\n" + PROFILE_SCHEMA_HINT
-                result = await _groq_json(PROFILE_SYSTEM, prompt)
-                if not result:
-                    return
-
-                traits = result.get("traits") or {}
-                ideas = {
-                    "follow_ideas": result.get("follow_ideas") or [],
-                    "venue_ideas": result.get("venue_ideas") or [],
-                }
-                persona = str(result.get("persona") or "")[:600]
-
-                if existing:
-                    existing.persona = persona
-                    existing.traits = json.dumps(traits)
-                    existing.ideas = json.dumps(ideas)
-                    existing.events_count = n_events
-                else:
-                    db.add(UserAgentProfile(
-                        user_id=user_id,
-                        persona=persona,
-                        traits=json.dumps(traits),
-                        ideas=json.dumps(ideas),
-                        events_count=n_events,
-                    ))
-                await db.commit()
-                logger.info(f"Agent profile refreshed for user {user_id} ({n_events} events)")
+        async with create_async_session() as db:
+            existing = (await db.execute(
+                select(UserAgentProfile).where(UserAgentProfile.user_id == user_id)
+            )).scalar_one_or_none()
+
+            digest, n_events = await _build_digest(db, user_id)
+        if existing and not force:
+            age_ok = existing.updated_at and (
+                datetime.now(timezone.utc) - existing.updated_at < REFRESH_AFTER
+            )
+            growth_ok = n_events - (existing.events_count or 0) < REFRESH_EVENT_DELTA
+            if age_ok and growth_ok:
+                return
+        if n_events < 3:
+            return  # nothing to profile yet
+
+        prompt = digest + _candidate_block(candidate_people or [], candidate_venues or []) \
+            + "\n\n" + PROFILE_SCHEMA_HINT
+        result = await _groq_json("profile_agent", PROFILE_SYSTEM, prompt,
+                                  cache_ttl=int(REFRESH_AFTER.total_seconds()))
+        if not result:
+            return
+
+        traits = result.get("traits") or {}
+        ideas = {
+            "follow_ideas": result.get("follow_ideas") or [],
+            "venue_ideas": result.get("venue_ideas") or [],
+        }
+        persona = str(result.get("persona") or "")[:600]
+
+        async with create_async_session() as db:
+            row = (await db.execute(
+                select(UserAgentProfile).where(UserAgentProfile.user_id == user_id)
+            )).scalar_one_or_none()
+            if row:
+                row.persona = persona
+                row.traits = json.dumps(traits)
+                row.ideas = json.dumps(ideas)
+                row.events_count = n_events
+            else:
+                db.add(UserAgentProfile(
+                    user_id=user_id,
+                    persona=persona,
+                    traits=json.dumps(traits),
+                    ideas=json.dumps(ideas),
+                    events_count=n_events,
+                ))
+            await db.commit()
+        logger.info(f"Agent profile refreshed for user {user_id} ({n_events} events)")
     except Exception as e:
         logger.warning(f"Agent profile refresh failed for user {user_id}: {e}")
     finally:
@@ -273,38 +256,42 @@ async def refresh_venue_profile(place_id: str, visitor_traits: list[dict]):
         return
     _in_flight.add(f"v:{place_id}")
     try:
-        async with _refresh_semaphore:
-            async with create_async_session() as db:
-                existing = (await db.execute(
-                    select(VenueAgentProfile).where(VenueAgentProfile.place_id == place_id)
-                )).scalar_one_or_none()
-                if existing and existing.updated_at and (
-                    datetime.now(timezone.utc) - existing.updated_at < timedelta(days=1)
-                ):
-                    return
-
-                tags: Counter = Counter()
-                for t in visitor_traits:
-                    for tag in (t.get("scene_tags") or [])[:5]:
-                        tags[tag] += 1
-                prompt = (
-                    f"Venue crowd trait tags (tag: count): "
-                    f"{json.dumps(dict(tags.most_common(10)))}\n"
-                    'Respond: {"vibe": "<=15 words about who goes here"}'
-                )
-                result = await _groq_json(VENUE_SYSTEM, prompt, max_tokens=80)
-                if not result or not result.get("vibe"):
-                    return
-                if existing:
-                    existing.vibe = str(result["vibe"])[:300]
-                    existing.crowd_traits = json.dumps(dict(tags.most_common(10)))
-                else:
-                    db.add(VenueAgentProfile(
-                        place_id=place_id,
-                        vibe=str(result["vibe"])[:300],
-                        crowd_traits=json.dumps(dict(tags.most_common(10))),
-                    ))
-                await db.commit()
+        async with create_async_session() as db:
+            existing = (await db.execute(
+                select(VenueAgentProfile).where(VenueAgentProfile.place_id == place_id)
+            )).scalar_one_or_none()
+        if existing and existing.updated_at and (
+            datetime.now(timezone.utc) - existing.updated_at < VENUE_REFRESH_AFTER
+        ):
+            return
+
+        tags: Counter = Counter()
+        for t in visitor_traits:
+            for tag in (t.get("scene_tags") or [])[:5]:
+                tags[tag] += 1
+        prompt = (
+            f"Venue crowd trait tags (tag: count): "
+            f"{json.dumps(dict(tags.most_common(10)))}\n"
+            'Respond: {"vibe": "<=15 words about who goes here"}'
+        )
+        result = await _groq_json("venue_agent", VENUE_SYSTEM, prompt, max_tokens=80,
+                                  cache_ttl=int(VENUE_REFRESH_AFTER.total_seconds()))
+        if not result or not result.get("vibe"):
+            return
+        async with create_async_session() as db:
+            row = (await db.execute(
+                select(VenueAgentProfile).where(VenueAgentProfile.place_id == place_id)
+            )).scalar_one_or_none()
+            if row:
+                row.vibe = str(result["vibe"])[:300]
+                row.crowd_traits = json.dumps(dict(tags.most_common(10)))
+            else:
+                db.add(VenueAgentProfile(
+                    place_id=place_id,
+                    vibe=str(result["vibe"])[:300],
+                    crowd_traits=json.dumps(dict(tags.most_common(10))),
+                ))
+            await db.commit()
     except Exception as e:
         logger.warning(f"Venue agent refresh failed for {place_id}: {e}")
     finally:
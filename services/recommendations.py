@@ -1,6 +1,7 @@
 """Place recommendation engine.
 
-Pipeline (rebuilt in-memory every ~10 min, numpy only):
+Pipeline (rebuilt in-memory every ~10 min, numpy + scipy.sparse — every
+matrix is CSR so memory and fit time scale with interactions, not n²):
 
 1. INTERACTION MATRIX — user × venue implicit feedback. Strong signal:
    check-ins (recency-decayed) and attended bounces. Weak signals, weighted
@@ -24,24 +25,36 @@ Pipeline (rebuilt in-memory every ~10 min, numpy only):
    Falls back to calibrated default weights when data is too thin. The
    feature interface is exactly what a LightGBM/two-tower upgrade would take.
 
-5. SERVING — candidates = top-K by MF dot product (brute-force argpartition;
-   the FAISS/ANN slot once the venue count justifies it) ∪ network venues ∪
-   popular, then ranked. Every suggestion carries human-readable reasons.
+5. INCREMENTAL — between rebuilds, new check-ins / bounce attendance (and,
+   per buffered flush, place / feed views) are folded in immediately
+   (one-step ALS row solve, delta edges for the forward-push PPR, per-user
+   PPR cache invalidation); see record_interaction.
+
+6. SERVING — candidates = top-K by MF dot product ∪ top-K by graph affinity
+   (both through a candidate index built per rebuild — brute force for small
+   catalogues, IVF/FAISS past services.candidate_index.ANN_MIN_ITEMS)
+   ∪ network venues ∪ popular, then ranked. Every suggestion carries
+   human-readable reasons.
 """
 
 import asyncio
 import json
 import logging
 import math
+import os
+import socket
 import time
-from collections import defaultdict
+from collections import defaultdict, deque
 from datetime import datetime, timezone, timedelta
 from typing import Optional
 
 import numpy as np
-from sqlalchemy import select
+import scipy.sparse as sp
+from scipy.sparse.linalg import ArpackError, svds
+from sqlalchemy import insert, select
 from sqlalchemy.ext.asyncio import AsyncSession
 
+from core.config import settings
 from db.database import create_async_session
 from db.models import (
     Bounce,
@@ -52,6 +65,12 @@ from db.models import (
     UserPlaceEvent,
     VenueFeedMessage,
 )
+from services.candidate_index import (
+    BruteForceIndex,
+    CandidateIndex,
+    build_index,
+    recall_vs_exact,
+)
 
 logger = logging.getLogger(__name__)
 
@@ -66,6 +85,7 @@ RECENCY_HALF_LIFE_DAYS = 30.0
 HISTORY_WINDOW_DAYS = 120
 MAX_HISTORY_ROWS = 20000
 MODEL_TTL_SECONDS = 600
+SNAPSHOT_MAX_AGE_SECONDS = MODEL_TTL_SECONDS * 3   # older = builder is down
 
 # ALS hyperparameters
 MF_FACTORS = 32
@@ -85,12 +105,12 @@ CO_ATTEND_WEIGHT = 0.5
 # THEIR friends -> ... with restart. Every hop contributes with geometrically
 # decaying influence — the explicit "and so on" network effect.
 PPR_DAMPING = 0.85
-PPR_ITERS = 15
-PPR_MAX_NODES = 4000        # dense power iteration guard
+PPR_PUSH_EPS = 1e-3         # forward-push residual threshold, per unit out-degree
 ALL_TIME_FLOOR = 0.08       # "ever" check-ins never fully vanish
 
 # Serving
 CANDIDATE_POOL = 200
+GRAPH_CANDIDATES = 50
 PPR_CANDIDATES = 50
 DISTANCE_SCALE_M = 3500.0
 # Hard geo cutoff: distance is otherwise only a soft ranking feature, so a
@@ -106,6 +126,12 @@ DEFAULT_RANKER_W = np.array([0.9, 0.8, 0.5, 0.4, 0.9, 0.6, 1.0, 1.1], dtype=np.f
 DEFAULT_RANKER_B = -1.0
 MIN_TRAIN_POSITIVES = 50
 
+# Incremental updates between full rebuilds: interactions are folded into the
+# serving model immediately and replayed onto each new model that was fit
+# from data older than them.
+INCREMENTAL_REPLAY_SECONDS = MODEL_TTL_SECONDS * 3
+REDIS_CHANNEL_INTERACTIONS = "recsys:interactions"
+
 
 def _haversine_m(lat1, lng1, lat2, lng2) -> float:
     r = 6371000
@@ -116,27 +142,40 @@ def _haversine_m(lat1, lng1, lat2, lng2) -> float:
     return 2 * r * math.atan2(math.sqrt(a), math.sqrt(1 - a))
 
 
+def _haversine_m_vec(lat: float, lng: float, lats: np.ndarray, lngs: np.ndarray) -> np.ndarray:
+    """_haversine_m from one origin to many points; NaN coordinates give NaN."""
+    p1, p2 = np.radians(lat), np.radians(lats)
+    dp = p2 - p1
+    dl = np.radians(lngs - lng)
+    a = np.sin(dp / 2) ** 2 + np.cos(p1) * np.cos(p2) * np.sin(dl / 2) ** 2
+    return 2 * 6371000 * np.arctan2(np.sqrt(a), np.sqrt(1 - a))
+
+
 # ---------------------------------------------------------------- numerics
 
 
-def _als_implicit(R: np.ndarray, factors: int, alpha: float, reg: float,
+def _als_implicit(R: sp.csr_matrix, factors: int, alpha: float, reg: float,
                   iters: int, seed: int = 7):
-    """Weighted implicit-feedback ALS (Hu–Koren–Volinsky)."""
+    """Weighted implicit-feedback ALS (Hu–Koren–Volinsky) over a CSR matrix.
+    Each row solve only touches that row's nonzeros (the YtY trick)."""
     rng = np.random.default_rng(seed)
     n_users, n_items = R.shape
     f = min(factors, max(2, min(n_users, n_items) - 1))
     X = rng.normal(0, 0.01, (n_users, f))
     Y = rng.normal(0, 0.01, (n_items, f))
+    Rt = R.T.tocsr()
 
-    def step(R_, Y_):
+    def step(R_: sp.csr_matrix, Y_):
         YtY = Y_.T @ Y_
         out = np.zeros((R_.shape[0], f))
         eye = np.eye(f)
+        indptr, indices, data = R_.indptr, R_.indices, R_.data
         for u in range(R_.shape[0]):
-            idx = np.nonzero(R_[u])[0]
-            if idx.size == 0:
+            lo, hi = indptr[u], indptr[u + 1]
+            if lo == hi:
                 continue
-            cu = alpha * R_[u, idx]                     # confidence - 1
+            idx = indices[lo:hi]
+            cu = alpha * data[lo:hi]                    # confidence - 1
             Yu = Y_[idx]
             A = YtY + Yu.T @ (cu[:, None] * Yu) + reg * eye
             b = Yu.T @ (1.0 + cu)                       # preference p=1
@@ -145,25 +184,34 @@ def _als_implicit(R: np.ndarray, factors: int, alpha: float, reg: float,
 
     for _ in range(iters):
         X = step(R, Y)
-        Y = step(R.T, X)
+        Y = step(Rt, X)
     return X, Y
 
 
-def _netmf_embeddings(adj: np.ndarray, dim: int):
+def _netmf_embeddings(adj: sp.csr_matrix, dim: int):
     """NetMF-lite: factorize the window-2 random-walk PMI matrix with SVD.
-    Equivalent objective to skip-gram node2vec (Qiu et al. 2018), no walks needed."""
+    Equivalent objective to skip-gram node2vec (Qiu et al. 2018), no walks needed.
+    log1p(0) = 0, so the PMI stays as sparse as the two-hop neighbourhood and
+    a truncated SVD (svds) only ever sees nonzeros."""
     n = adj.shape[0]
     if n == 0:
         return np.zeros((0, dim))
-    deg = adj.sum(axis=1)
+    deg = np.asarray(adj.sum(axis=1)).ravel()
     deg_safe = np.maximum(deg, 1e-9)
-    P = adj / deg_safe[:, None]
-    M = (P + P @ P) / 2.0
-    vol = max(adj.sum(), 1e-9)
-    pmi = np.log1p(M * (vol / np.maximum(deg_safe[None, :], 1e-9)))
+    P = sp.diags(1.0 / deg_safe) @ adj
+    M = ((P + P @ P) / 2.0).tocoo()
+    vol = max(float(deg.sum()), 1e-9)
+    pmi = sp.csr_matrix(
+        (np.log1p(M.data * (vol / deg_safe[M.col])), (M.row, M.col)), shape=(n, n)
+    )
     try:
-        U, S, _ = np.linalg.svd(pmi, full_matrices=False)
-    except np.linalg.LinAlgError:
+        if n <= 4 * dim:                                # tiny graph: dense is cheaper
+            U, S, _ = np.linalg.svd(pmi.toarray(), full_matrices=False)
+        else:
+            U, S, _ = svds(pmi, k=dim, random_state=7)
+            order = np.argsort(-S)                      # svds returns ascending
+            U, S = U[:, order], S[order]
+    except (np.linalg.LinAlgError, ArpackError):
         return np.zeros((n, dim))
     k = min(dim, S.shape[0])
     emb = U[:, :k] * np.sqrt(np.maximum(S[:k], 0))
@@ -205,6 +253,13 @@ class RecommendationModel:
         self.venue_meta: list[dict] = []
         self.user_cat: dict[int, dict[str, float]] = {}   # u_idx -> type weights
         self.popularity = np.zeros(0)
+        # Packed per-venue serving arrays (see _pack_venue_arrays)
+        self.venue_lat = np.zeros(0)            # NaN when unknown
+        self.venue_lng = np.zeros(0)
+        self.venue_excluded = np.zeros(0, dtype=bool)
+        self.pop_feature = np.zeros(0)
+        self.type_index: dict[str, int] = {}
+        self.venue_types: Optional[sp.csr_matrix] = None   # venue x type, rows / sqrt(|types|)
         self.centroids: dict[int, tuple] = {}             # user_id -> (lat, lng)
         self.ranker_w = DEFAULT_RANKER_W.copy()
         self.ranker_b = DEFAULT_RANKER_B
@@ -213,9 +268,22 @@ class RecommendationModel:
         self.ranker_learned = False
         self.metrics: Optional[dict] = None
         self.n_interactions = 0
-        # Joint user+venue random-walk matrix (row-stochastic) for PPR
-        self.W_joint: Optional[np.ndarray] = None
+        # Joint user+venue random-walk matrix (row-stochastic CSR) for PPR
+        self.W_joint: Optional[sp.csr_matrix] = None
+        self.joint_row_sums = np.zeros(0)       # pre-normalization, for delta rows
+        self.n_graph_users = 0                  # user nodes in W_joint
+        self.YtY: Optional[np.ndarray] = None   # cached for one-step ALS solves
+        self.data_as_of: float = 0              # raw snapshot time of the fit
+        # Edges added since the fit: node -> {node: unnormalized weight}
+        self.W_delta: dict[int, dict[int, float]] = {}
         self._ppr_cache: dict[int, np.ndarray] = {}
+        self._push_threshold: Optional[np.ndarray] = None   # PPR_PUSH_EPS * out-degree
+        # MF rows solved incrementally since the fit (user idx -> row). X itself
+        # stays untouched: it's a read-only mmap shared by every worker
+        self._x_overlay: dict[int, np.ndarray] = {}
+        # Candidate indexes over Y / GV, rebuilt with the model
+        self.mf_index: CandidateIndex = BruteForceIndex(self.Y)
+        self.graph_index: CandidateIndex = BruteForceIndex(self.GV)
 
     @property
     def is_fresh(self) -> bool:
@@ -304,7 +372,7 @@ def _build_rows(raw: dict):
         if pid:
             rows.append((uid, pid, W_FEED_POST * decay(ts), ts))
     for uid, pid, etype, ts in raw["events"]:
-        w = W_FEED_VIEW if etype == "feed_view" else W_PLACE_VIEW
+        w = _event_weight(etype)
         rows.append((uid, pid, w * decay(ts), ts))
     # All-time history at floor weight (ts=None keeps it out of the time-split)
     for uid, pid, count in raw.get("old_checkins", []):
@@ -317,6 +385,7 @@ def _fit_core(raw: dict, rows: list, coords: dict) -> RecommendationModel:
     """CPU-bound numpy fit over the given interaction rows."""
     m = RecommendationModel()
     m.n_interactions = len(rows)
+    m.data_as_of = raw["now"].timestamp()
 
     for uid, pts in coords.items():
         tot = sum(w for _, _, w in pts)
@@ -350,24 +419,35 @@ def _fit_core(raw: dict, rows: list, coords: dict) -> RecommendationModel:
         m.built_at = time.time()
         return m
 
-    R = np.zeros((max(n_u, 1), n_v))
+    # ---- interaction matrix (CSR; duplicate (u, v) entries are summed) ----
+    r_u, r_v, r_w = [], [], []
     for uid, pid, w, _ in rows:
         vi = m.venue_index.get(pid)
         ui = m.user_index.get(uid)
         if vi is not None and ui is not None:
-            R[ui, vi] += w
-
-    for ui in range(n_u):
-        nz = np.nonzero(R[ui])[0]
-        if nz.size:
-            m.R_sparse[ui] = {int(v): float(R[ui, v]) for v in nz}
+            r_u.append(ui)
+            r_v.append(vi)
+            r_w.append(w)
+    R = sp.csr_matrix((np.array(r_w, dtype=np.float64), (r_u, r_v)),
+                      shape=(max(n_u, 1), n_v))
+    R.sum_duplicates()
+    R.eliminate_zeros()
+
+    for ui in range(R.shape[0]):
+        lo, hi = R.indptr[ui], R.indptr[ui + 1]
+        if lo < hi:
+            m.R_sparse[ui] = dict(zip(R.indices[lo:hi].tolist(), R.data[lo:hi].tolist()))
+    Rc = R.tocsc()
     for vi in range(n_v):
-        nz = np.nonzero(R[:, vi])[0]
-        if nz.size:
-            m.venue_visitors[vi] = {user_ids[int(u)]: float(R[u, vi]) for u in nz}
+        lo, hi = Rc.indptr[vi], Rc.indptr[vi + 1]
+        if lo < hi:
+            m.venue_visitors[vi] = {
+                user_ids[int(u)]: float(w)
+                for u, w in zip(Rc.indices[lo:hi], Rc.data[lo:hi])
+            }
 
     # ---- 1. ALS matrix factorization ----
-    if n_u > 0 and R.sum() > 0:
+    if n_u > 0 and R.nnz > 0:
         m.X, m.Y = _als_implicit(R, MF_FACTORS, MF_ALPHA, MF_REG, MF_ITERS)
     else:
         m.X = np.zeros((max(n_u, 1), 2))
@@ -381,7 +461,7 @@ def _fit_core(raw: dict, rows: list, coords: dict) -> RecommendationModel:
         if cf == "accepted":
             close.add((f, g))
     ties: dict[int, dict[int, float]] = defaultdict(dict)
-    A = np.zeros((max(n_u, 1), max(n_u, 1)))
+    tie_edges: dict[tuple, float] = {}     # symmetric (fi, gi) -> max tie strength
     for f, followed in following.items():
         for g in followed:
             mutual = f in following.get(g, set())
@@ -391,51 +471,54 @@ def _fit_core(raw: dict, rows: list, coords: dict) -> RecommendationModel:
             ties[f][g] = max(ties[f].get(g, 0.0), s)
             fi, gi = m.user_index.get(f), m.user_index.get(g)
             if fi is not None and gi is not None:
-                A[fi, gi] = max(A[fi, gi], s)
-                A[gi, fi] = max(A[gi, fi], s)
+                for key in ((fi, gi), (gi, fi)):
+                    if s > tie_edges.get(key, 0.0):
+                        tie_edges[key] = s
     m.ties = dict(ties)
 
     # co-attendance edges: visited the same venue (bounded contribution)
+    a_i, a_j, a_w = [], [], []
+    for key, s in tie_edges.items():
+        a_i.append(key[0])
+        a_j.append(key[1])
+        a_w.append(s)
     for vi, visitors in m.venue_visitors.items():
         us = [m.user_index[u] for u in visitors if u in m.user_index]
         if 1 < len(us) <= 30:
             for i in range(len(us)):
                 for j in range(i + 1, len(us)):
-                    A[us[i], us[j]] += CO_ATTEND_WEIGHT
-                    A[us[j], us[i]] += CO_ATTEND_WEIGHT
+                    a_i += (us[i], us[j])
+                    a_j += (us[j], us[i])
+                    a_w += (CO_ATTEND_WEIGHT, CO_ATTEND_WEIGHT)
+    n_a = max(n_u, 1)
+    A = sp.csr_matrix((np.array(a_w, dtype=np.float64), (a_i, a_j)), shape=(n_a, n_a))
+    A.sum_duplicates()
 
-    m.G = _netmf_embeddings(A, GRAPH_DIM) if n_u > 1 else np.zeros((max(n_u, 1), GRAPH_DIM))
+    m.G = _netmf_embeddings(A, GRAPH_DIM) if n_u > 1 else np.zeros((n_a, GRAPH_DIM))
 
     # venue graph embedding = weighted mean of visitor embeddings
-    m.GV = np.zeros((n_v, m.G.shape[1]))
-    for vi, visitors in m.venue_visitors.items():
-        acc = np.zeros(m.G.shape[1])
-        tot = 0.0
-        for uid, w in visitors.items():
-            ui = m.user_index.get(uid)
-            if ui is not None and ui < m.G.shape[0]:
-                acc += w * m.G[ui]
-                tot += w
-        if tot > 0:
-            m.GV[vi] = acc / tot
+    visit_tot = np.asarray(R.sum(axis=0)).ravel()
+    m.GV = np.asarray(R.T @ m.G[:R.shape[0]])
+    np.divide(m.GV, visit_tot[:, None], out=m.GV, where=visit_tot[:, None] > 0)
 
     # ---- 2b. joint random-walk graph for Personalized PageRank ----
     # Nodes = users then venues. Walk flows me -> friends -> their venues ->
     # those venues' other visitors -> THEIR friends/venues -> ... any depth.
-    n_total = n_u + n_v
-    if n_u > 0 and n_total <= PPR_MAX_NODES:
-        W = np.zeros((n_total, n_total), dtype=np.float32)
-        W[:n_u, :n_u] = A[:n_u, :n_u]          # user -> user (tie strength)
-        W[:n_u, n_u:] = R                       # user -> venue (visit weight)
-        W[n_u:, :n_u] = R.T                     # venue -> its visitors
-        row_sums = W.sum(axis=1, keepdims=True)
-        np.divide(W, row_sums, out=W, where=row_sums > 0)
-        m.W_joint = W
+    # Sparse, so it stays on at any graph size — nnz ~ edges + interactions.
+    if n_u > 0:
+        W = sp.bmat([[A[:n_u, :n_u], R[:n_u]], [R[:n_u].T, None]], format="csr",
+                    dtype=np.float32)
+        row_sums = np.asarray(W.sum(axis=1)).ravel()
+        inv = np.divide(1.0, row_sums, out=np.zeros_like(row_sums), where=row_sums > 0)
+        m.W_joint = (sp.diags(inv.astype(np.float32)) @ W).tocsr()
+        m.joint_row_sums = row_sums.astype(np.float64)
+        m.n_graph_users = n_u
     else:
         m.W_joint = None
 
     # ---- 3. category vectors ----
     m.popularity = np.array([v["pop"] for v in m.venue_meta])
+    _pack_venue_arrays(m)
     for ui, venues in m.R_sparse.items():
         vec: dict[str, float] = defaultdict(float)
         for vi, w in venues.items():
@@ -447,33 +530,79 @@ def _fit_core(raw: dict, rows: list, coords: dict) -> RecommendationModel:
     # ---- 4. learned ranker on a time split ----
     _train_ranker(m, rows, user_ids)
 
+    m.YtY = m.Y.T @ m.Y
+
+    # ---- 5. serving-side candidate indexes ----
+    m.mf_index = build_index(m.Y)
+    m.graph_index = build_index(m.GV)
+
     m.built_at = time.time()
     logger.info(
         f"Recsys model: {n_u} users, {n_v} venues, "
-        f"{len(rows)} interactions, ranker_learned={m.ranker_learned}"
+        f"{len(rows)} interactions, ranker_learned={m.ranker_learned}, "
+        f"index={m.mf_index.kind}"
     )
     return m
 
 
+def _out_edges(m: RecommendationModel, x: int) -> tuple[np.ndarray, np.ndarray]:
+    """Transition probabilities out of joint node x: the fitted CSR row,
+    reweighted by any edges added incrementally since the fit."""
+    W = m.W_joint
+    lo, hi = W.indptr[x], W.indptr[x + 1]
+    idx, prob = W.indices[lo:hi], W.data[lo:hi]
+    extra = m.W_delta.get(x)
+    if not extra:
+        return idx, prob
+    old = float(m.joint_row_sums[x])
+    new = old + sum(extra.values())
+    ex_idx = np.fromiter(extra.keys(), dtype=np.int64, count=len(extra))
+    ex_w = np.fromiter(extra.values(), dtype=np.float64, count=len(extra))
+    return np.concatenate([idx, ex_idx]), np.concatenate([prob * (old / new), ex_w / new])
+
+
 def _ppr_venue_scores(m: RecommendationModel, user_id: int) -> Optional[np.ndarray]:
-    """Personalized PageRank from this user over the joint graph.
+    """Personalized PageRank from this user over the joint graph, by local
+    forward push (Andersen–Chung–Lang): residual mass is pushed only from
+    nodes holding more than PPR_PUSH_EPS per out-edge, so the push touches
+    at most 1/(eps·(1-d)) nodes' worth of edges and sees W_delta edges as
+    soon as they're added. Residuals live in dicts and the thresholds are
+    computed once per model; the only O(venues) cost is the dense result.
     Returns a max-normalized score per venue (the 'network flow' feature)."""
     ui = m.user_index.get(user_id)
-    if ui is None or m.W_joint is None:
+    if ui is None or m.W_joint is None or ui >= m.n_graph_users:
         return None
     cached = m._ppr_cache.get(user_id)
     if cached is not None:
         return cached
-    n_total = m.W_joint.shape[0]
-    n_u = len(m.user_index)
-    p = np.zeros(n_total, dtype=np.float32)
-    e = np.zeros(n_total, dtype=np.float32)
-    e[ui] = 1.0
-    p[ui] = 1.0
-    for _ in range(PPR_ITERS):
-        p = (1 - PPR_DAMPING) * e + PPR_DAMPING * (p @ m.W_joint)
-    venue_scores = p[n_u:].astype(np.float64)
-    peak = venue_scores.max()
+    n_u = m.n_graph_users
+    threshold = m._push_threshold
+    if threshold is None:
+        threshold = m._push_threshold = PPR_PUSH_EPS * np.maximum(np.diff(m.W_joint.indptr), 1)
+    p: dict[int, float] = {}
+    r: dict[int, float] = {ui: 1.0}
+    queued = {ui}
+    queue = deque([ui])
+    while queue:
+        x = queue.popleft()
+        queued.discard(x)
+        rx = r[x]
+        if rx <= threshold[x]:
+            continue
+        p[x] = p.get(x, 0.0) + (1 - PPR_DAMPING) * rx
+        r[x] = 0.0
+        idx, prob = _out_edges(m, x)
+        for y, mass in zip(idx.tolist(), (PPR_DAMPING * rx * prob).tolist()):
+            ry = r.get(y, 0.0) + mass
+            r[y] = ry
+            if ry > threshold[y] and y not in queued:
+                queued.add(y)
+                queue.append(y)
+    venue_scores = np.zeros(m.W_joint.shape[0] - n_u)
+    for x, px in p.items():
+        if x >= n_u:
+            venue_scores[x - n_u] = px
+    peak = venue_scores.max() if venue_scores.size else 0.0
     if peak > 0:
         venue_scores = venue_scores / peak
     if len(m._ppr_cache) < 2000:
@@ -481,40 +610,98 @@ def _ppr_venue_scores(m: RecommendationModel, user_id: int) -> Optional[np.ndarr
     return venue_scores
 
 
-def _features(m: RecommendationModel, uid: int, ui: Optional[int], vi: int,
-              origin: Optional[tuple], ppr: Optional[np.ndarray] = None) -> np.ndarray:
-    meta = m.venue_meta[vi]
-    mf = float(m.X[ui] @ m.Y[vi]) if ui is not None and ui < m.X.shape[0] else 0.0
-    graph = float(m.G[ui] @ m.GV[vi]) if ui is not None and ui < m.G.shape[0] else 0.0
-
-    cat = 0.0
-    if ui is not None:
-        uvec = m.user_cat.get(ui, {})
-        if uvec and meta["types"]:
-            hit = sum(w for t, w in uvec.items() if t in meta["types"])
-            norm = math.sqrt(sum(w * w for w in uvec.values())) * math.sqrt(len(meta["types"]))
-            cat = hit / norm if norm > 0 else 0.0
-
-    pop = math.log1p(meta["pop"]) / math.log1p(max(m.popularity.max(), 1.0))
-
-    social = 0.0
-    for fid, s in m.ties.get(uid, {}).items():
-        w = m.venue_visitors.get(vi, {}).get(fid)
-        if w:
-            social += s * w
-    social = math.tanh(social / 3.0)
+def _pack_venue_arrays(m: RecommendationModel):
+    """Venue metadata as flat arrays so the ranker's features are computed
+    for all candidates at once instead of per-venue dict lookups."""
+    n_v = len(m.venue_meta)
+    m.venue_lat = np.array([v["lat"] if v["lat"] is not None else np.nan
+                            for v in m.venue_meta], dtype=np.float64)
+    m.venue_lng = np.array([v["lng"] if v["lng"] is not None else np.nan
+                            for v in m.venue_meta], dtype=np.float64)
+    m.venue_lat[np.isnan(m.venue_lng)] = np.nan
+    m.venue_excluded = np.array([bool(v["types"] & EXCLUDED_TYPES) for v in m.venue_meta],
+                                dtype=bool)
+    m.pop_feature = np.log1p(m.popularity) / math.log1p(max(m.popularity.max(initial=0.0), 1.0))
+
+    rows, cols, vals = [], [], []
+    for vi, v in enumerate(m.venue_meta):
+        if not v["types"]:
+            continue
+        scale = 1.0 / math.sqrt(len(v["types"]))
+        for t in v["types"]:
+            rows.append(vi)
+            cols.append(m.type_index.setdefault(t, len(m.type_index)))
+            vals.append(scale)
+    m.venue_types = sp.csr_matrix((vals, (rows, cols)), shape=(n_v, max(len(m.type_index), 1)))
+
+
+def _feature_matrix(m: RecommendationModel, uid: int, ui: Optional[int], vis: np.ndarray,
+                    origin: Optional[tuple], ppr: Optional[np.ndarray] = None,
+                    dist_m: Optional[np.ndarray] = None) -> np.ndarray:
+    """Ranker features for every venue in `vis` as one (len(vis), N_FEATURES)
+    matrix: [mf, graph, category, popularity, social, novelty, distance,
+    network_flow]. `dist_m` lets callers reuse distances they already have."""
+    n = vis.shape[0]
+    F = np.zeros((n, N_FEATURES))
+    if n == 0:
+        return F
+    xu = _user_factors(m, ui)
+    if xu is not None:
+        F[:, 0] = m.Y[vis] @ xu
+    if ui is not None and ui < m.G.shape[0]:
+        F[:, 1] = m.GV[vis] @ m.G[ui]
+
+    # category: cosine-style match of the user's type weights vs venue types
+    if ui is not None and m.venue_types is not None:
+        uvec = m.user_cat.get(ui)
+        if uvec:
+            u = np.zeros(m.venue_types.shape[1])
+            for t, w in uvec.items():
+                ti = m.type_index.get(t)
+                if ti is not None:
+                    u[ti] = w
+            norm = math.sqrt(sum(w * w for w in uvec.values()))
+            if norm > 0:
+                F[:, 2] = (m.venue_types[vis] @ u) / norm
+
+    F[:, 3] = m.pop_feature[vis]
+
+    # social: tie-weighted visits of the user's people to each candidate
+    ties = m.ties.get(uid)
+    if ties:
+        pos = {int(v): k for k, v in enumerate(vis.tolist())}
+        social = np.zeros(n)
+        for fid, s in ties.items():
+            fui = m.user_index.get(fid)
+            for v, w in m.R_sparse.get(fui, {}).items():
+                k = pos.get(v)
+                if k is not None:
+                    social[k] += s * w
+        F[:, 4] = np.tanh(social / 3.0)
+
+    own = m.R_sparse.get(ui, {}) if ui is not None else {}
+    if own:
+        F[:, 5] = 1.0 / (1.0 + np.array([own.get(v, 0.0) for v in vis.tolist()]))
+    else:
+        F[:, 5] = 1.0
 
-    own = m.R_sparse.get(ui, {}).get(vi, 0.0) if ui is not None else 0.0
-    novelty = 1.0 / (1.0 + own)
+    F[:, 6] = 0.5
+    if origin:
+        if dist_m is None:
+            dist_m = _haversine_m_vec(origin[0], origin[1], m.venue_lat[vis], m.venue_lng[vis])
+        known = ~np.isnan(dist_m)
+        F[known, 6] = np.exp(-dist_m[known] / DISTANCE_SCALE_M)
 
-    dist = 0.5
-    if origin and meta["lat"] is not None and meta["lng"] is not None:
-        d = _haversine_m(origin[0], origin[1], meta["lat"], meta["lng"])
-        dist = math.exp(-d / DISTANCE_SCALE_M)
+    if ppr is not None:
+        in_range = vis < len(ppr)
+        F[in_range, 7] = ppr[vis[in_range]]
+    return F
 
-    network_flow = float(ppr[vi]) if ppr is not None and vi < len(ppr) else 0.0
 
-    return np.array([mf, graph, cat, pop, social, novelty, dist, network_flow])
+def _score(m: RecommendationModel, F: np.ndarray) -> np.ndarray:
+    """Ranker relevance for a feature matrix: one matrix-vector product."""
+    Fz = (F - m.feat_mean) / m.feat_std if m.ranker_learned else F
+    return 1.0 / (1.0 + np.exp(-np.clip(Fz @ m.ranker_w + m.ranker_b, -30, 30)))
 
 
 def _train_ranker(m: RecommendationModel, rows: list, user_ids: list):
@@ -539,24 +726,28 @@ def _train_ranker(m: RecommendationModel, rows: list, user_ids: list):
         ppr = _ppr_venue_scores(m, uid)
         seen = {m.venue_index[pid] for _, pid in items}
         earlier_venues = {m.venue_index[pid] for _, pid in earlier}
+        vis, labels = [], []
         for _, pid in held:
             vi = m.venue_index[pid]
             # Discovery objective: only FIRST visits count as positives,
             # otherwise the ranker learns to predict revisits.
             if vi in earlier_venues:
                 continue
-            F.append(_features(m, uid, ui, vi, origin, ppr))
-            y.append(1.0)
+            vis.append(vi)
+            labels.append(1.0)
             for _ in range(3):
                 nvi = int(rng.integers(0, n_v))
                 if nvi not in seen:
-                    F.append(_features(m, uid, ui, nvi, origin, ppr))
-                    y.append(0.0)
+                    vis.append(nvi)
+                    labels.append(0.0)
+        if vis:
+            F.append(_feature_matrix(m, uid, ui, np.array(vis, dtype=np.int64), origin, ppr))
+            y.extend(labels)
 
     if sum(y) < MIN_TRAIN_POSITIVES:
         return  # keep default weights
 
-    F = np.array(F)
+    F = np.vstack(F)
     y = np.array(y)
     m.feat_mean = F.mean(axis=0)
     m.feat_std = np.maximum(F.std(axis=0), 1e-6)
@@ -587,12 +778,20 @@ def _evaluate(m_train: RecommendationModel, test_by_user: dict[int, set]) -> Opt
                 base_hits += 1
     if n_cases < 10:
         return None
-    return {
+    metrics = {
         "test_cases": n_cases,
         "recall_at_10": round(hits / n_cases, 4),
         "mrr_at_50": round(rr / n_cases, 4),
         "popularity_baseline_recall_at_10": round(base_hits / n_cases, 4),
     }
+    # Approximate candidate generation must not cost recall vs brute force
+    rows = [m_train.user_index[uid] for uid in test_by_user if uid in m_train.user_index]
+    rows = [ui for ui in rows if ui < m_train.X.shape[0]]
+    ann_recall = recall_vs_exact(m_train.mf_index, m_train.X[rows], CANDIDATE_POOL)
+    if ann_recall is not None:
+        metrics["ann_index"] = m_train.mf_index.kind
+        metrics["ann_recall_at_pool"] = round(ann_recall, 4)
+    return metrics
 
 
 def _fit(raw: dict) -> RecommendationModel:
@@ -636,14 +835,200 @@ def _fit(raw: dict) -> RecommendationModel:
 
 async def get_model(db: AsyncSession) -> RecommendationModel:
     global _model
+    if settings.MODEL_BUILDER_MODE == "process":
+        from services.model_snapshot import current_models
+        snap = await current_models()
+        if snap is not None and time.time() - snap[0].built_at < SNAPSHOT_MAX_AGE_SECONDS:
+            return _serving(snap[0])
+        # No fresh snapshot (builder still starting, or dead): one process
+        # on the host fits and publishes while the others wait for it
+        from services.model_builder import build_or_wait
+        snap = await build_or_wait(lambda s: time.time() - s[0].built_at < SNAPSHOT_MAX_AGE_SECONDS)
+        if snap is not None:
+            return _serving(snap[0])
+        # Still nothing to map: fit inline rather than serve nothing
     if _model.is_fresh:
-        return _model
+        return _serving(_model)
     async with _model_lock:
         if _model.is_fresh:
-            return _model
+            return _serving(_model)
         raw = await _load_raw(db)
         _model = await asyncio.to_thread(_fit, raw)
-        return _model
+        return _serving(_model)
+
+
+# ---------------------------------------------------------------- incremental
+#
+# A check-in or bounce attendance is folded into the serving model right away:
+# a one-step ALS solve for that user's row (Y held fixed), the edge added to
+# W_delta so forward-push PPR walks it, and the PPR cache dropped for the user
+# and their ties. Interactions are also published on REDIS_CHANNEL_INTERACTIONS
+# so every worker applies them, and kept for INCREMENTAL_REPLAY_SECONDS so a
+# model fit from older data catches up when it's swapped in. The periodic full
+# refit still corrects any drift.
+
+_WORKER_ID = f"{socket.gethostname()}:{os.getpid()}"
+_recent_interactions: deque = deque(maxlen=20000)   # (ts, user_id, place_id, w)
+_live_model: Optional[RecommendationModel] = None
+_listener_task: Optional[asyncio.Task] = None
+
+
+def _serving(m: RecommendationModel) -> RecommendationModel:
+    """Mark `m` as the model incremental updates go to, replaying anything
+    newer than its training data the first time it's seen."""
+    global _live_model
+    if m is not _live_model:
+        for ts, uid, pid, w in list(_recent_interactions):
+            if ts > m.data_as_of:
+                apply_interaction(m, uid, pid, w)
+        _live_model = m
+    return m
+
+
+def _user_factors(m: RecommendationModel, ui: Optional[int]) -> Optional[np.ndarray]:
+    """MF row for user index ui: this worker's incremental solve if there is
+    one, else the fitted row."""
+    if ui is None:
+        return None
+    row = m._x_overlay.get(ui)
+    if row is not None:
+        return row
+    return m.X[ui] if ui < m.X.shape[0] else None
+
+
+def apply_interaction(m: RecommendationModel, user_id: int, place_id: str,
+                      weight: float) -> bool:
+    """Fold one (user, venue, weight) interaction into `m` in place."""
+    vi = m.venue_index.get(place_id)
+    if vi is None or m.Y.shape[0] == 0:
+        return False   # venue unknown to this fit — picked up by the next one
+    ui = m.user_index.get(user_id)
+    if ui is None:
+        # New user: an index past X (its MF row lives in the overlay);
+        # graph / PPR nodes wait for the next refit
+        ui = max(m.X.shape[0], len(m.user_index))
+        m.user_index[user_id] = ui
+
+    row = m.R_sparse.setdefault(ui, {})
+    row[vi] = row.get(vi, 0.0) + weight
+    visitors = m.venue_visitors.setdefault(vi, {})
+    visitors[user_id] = visitors.get(user_id, 0.0) + weight
+    cat = m.user_cat.setdefault(ui, {})
+    for t in m.venue_meta[vi]["types"]:
+        if t not in ("point_of_interest", "establishment"):
+            cat[t] = cat.get(t, 0.0) + weight
+
+    # One-step ALS: exact least-squares solve for this row with Y fixed, kept
+    # in the overlay rather than written into (or grown onto) X
+    f = m.Y.shape[1]
+    if m.X.shape[1] == f:
+        if m.YtY is None:
+            m.YtY = m.Y.T @ m.Y
+        idx = np.fromiter(row.keys(), dtype=np.int64, count=len(row))
+        cu = MF_ALPHA * np.fromiter(row.values(), dtype=np.float64, count=len(row))
+        Yu = m.Y[idx]
+        A = m.YtY + Yu.T @ (cu[:, None] * Yu) + MF_REG * np.eye(f)
+        try:
+            m._x_overlay[ui] = np.linalg.solve(A, Yu.T @ (1.0 + cu))
+        except np.linalg.LinAlgError:
+            pass
+
+    if m.W_joint is not None and ui < m.n_graph_users:
+        vnode = m.n_graph_users + vi
+        for a, b in ((ui, vnode), (vnode, ui)):
+            extra = m.W_delta.setdefault(a, {})
+            extra[b] = extra.get(b, 0.0) + weight
+
+    m._ppr_cache.pop(user_id, None)
+    for fid in m.ties.get(user_id, {}):
+        m._ppr_cache.pop(fid, None)
+    m.n_interactions += 1
+    return True
+
+
+def _apply_live(user_id: int, place_id: str, weight: float, ts: float):
+    _recent_interactions.append((ts, user_id, place_id, weight))
+    horizon = ts - INCREMENTAL_REPLAY_SECONDS
+    while _recent_interactions and _recent_interactions[0][0] < horizon:
+        _recent_interactions.popleft()
+    if _live_model is not None:
+        apply_interaction(_live_model, user_id, place_id, weight)
+
+
+def record_interaction(user_id: int, place_id: Optional[str], weight: float):
+    """Fold a fresh interaction in locally and fan it out to other workers.
+    Safe to call from any request handler; never raises."""
+    if place_id:
+        record_interactions([(user_id, place_id, weight, time.time())])
+
+
+def record_interactions(items: list[tuple[int, str, float, float]]):
+    """Batch form of record_interaction: (user_id, place_id, weight, ts)
+    items, applied locally and published as one message."""
+    items = [it for it in items if it[1]]
+    if not items:
+        return
+    try:
+        for uid, pid, w, ts in items:
+            _apply_live(uid, pid, w, ts)
+    except Exception as e:
+        logger.warning(f"Recsys incremental update failed: {e}")
+
+    async def _publish():
+        try:
+            from services.redis import get_redis
+            redis = await get_redis()
+            await redis.publish(REDIS_CHANNEL_INTERACTIONS, json.dumps({
+                "origin": _WORKER_ID, "items": items,
+            }))
+        except Exception as e:
+            logger.debug(f"Recsys interaction publish failed: {e}")
+    try:
+        asyncio.create_task(_publish())
+    except RuntimeError:
+        pass
+
+
+async def _interaction_listen_loop():
+    from services.redis import get_redis
+    while True:
+        try:
+            redis = await get_redis()
+            pubsub = redis.pubsub()
+            await pubsub.subscribe(REDIS_CHANNEL_INTERACTIONS)
+            async for msg in pubsub.listen():
+                if msg["type"] != "message":
+                    continue
+                try:
+                    data = json.loads(msg["data"])
+                    if data.get("origin") == _WORKER_ID:
+                        continue
+                    if "items" in data:
+                        for uid, pid, w, ts in data["items"]:
+                            _apply_live(int(uid), str(pid), float(w), float(ts))
+                    else:
+                        _apply_live(int(data["user_id"]), str(data["place_id"]),
+                                    float(data["w"]), float(data["ts"]))
+                except Exception as e:
+                    logger.debug(f"Bad recsys interaction message: {e}")
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            logger.warning(f"Recsys interaction listener error, reconnecting: {e}")
+            await asyncio.sleep(1)
+
+
+async def start_interaction_listener():
+    global _listener_task
+    if _listener_task is None:
+        _listener_task = asyncio.create_task(_interaction_listen_loop())
+
+
+async def stop_interaction_listener():
+    global _listener_task
+    if _listener_task is not None:
+        _listener_task.cancel()
+        _listener_task = None
 
 
 # ---------------------------------------------------------------- serving
@@ -667,10 +1052,11 @@ def recommend_for_user(
 
     # --- candidate generation ---
     candidates: set[int] = set()
-    if ui is not None and ui < m.X.shape[0] and m.X[ui].any():
-        scores = m.Y @ m.X[ui]
-        k = min(CANDIDATE_POOL, n_v)
-        candidates |= set(np.argpartition(-scores, k - 1)[:k].tolist())
+    xu = _user_factors(m, ui)
+    if xu is not None and xu.any():
+        candidates |= set(m.mf_index.search(xu, CANDIDATE_POOL).tolist())
+    if ui is not None and ui < m.G.shape[0] and m.G[ui].any():
+        candidates |= set(m.graph_index.search(m.G[ui], GRAPH_CANDIDATES).tolist())
     for fid in m.ties.get(user_id, {}):
         fui = m.user_index.get(fid)
         if fui is not None:
@@ -686,34 +1072,28 @@ def recommend_for_user(
     heavy = {vi for vi, w in visited.items() if w >= 0.5}
     candidates -= heavy
 
-    # --- rank ---
-    scored = []
-    for vi in candidates:
-        meta = m.venue_meta[vi]
-        if meta["types"] & EXCLUDED_TYPES:
-            continue
+    # --- rank (vectorized over all candidates) ---
+    vis = np.fromiter(candidates, dtype=np.int64, count=len(candidates))
+    vis = vis[~m.venue_excluded[vis]]
+    dist_m = None
+    if origin is not None:
         # Only venues near the user (or their activity centroid): being in Izmir
         # must never suggest Marylebone. Coordinate-less venues are unverifiable,
         # so they're dropped too whenever we know where the user is.
-        if origin is not None:
-            if meta["lat"] is None or meta["lng"] is None:
-                continue
-            if _haversine_m(origin[0], origin[1], meta["lat"], meta["lng"]) > MAX_SUGGESTION_RADIUS_M:
-                continue
-        f = _features(m, user_id, ui, vi, origin, ppr)
-        fz = (f - m.feat_mean) / m.feat_std if m.ranker_learned else f
-        z = float(fz @ m.ranker_w + m.ranker_b)
-        score = 1.0 / (1.0 + math.exp(-max(min(z, 30), -30)))
-        scored.append((score, vi, f))
-    scored.sort(key=lambda t: t[0], reverse=True)
+        dist_m = _haversine_m_vec(origin[0], origin[1], m.venue_lat[vis], m.venue_lng[vis])
+        keep = dist_m <= MAX_SUGGESTION_RADIUS_M        # NaN compares False
+        vis, dist_m = vis[keep], dist_m[keep]
+    F = _feature_matrix(m, user_id, ui, vis, origin, ppr, dist_m)
+    scores = _score(m, F)
+    order = np.argsort(-scores, kind="stable")[:limit]
 
     results = []
-    for score, vi, f in scored[:limit]:
+    for k in order.tolist():
+        vi = int(vis[k])
         meta = m.venue_meta[vi]
+        f = F[k]
         reasons = _reasons(m, user_id, ui, vi, f)
-        distance_m = None
-        if origin and meta["lat"] is not None and meta["lng"] is not None:
-            distance_m = round(_haversine_m(origin[0], origin[1], meta["lat"], meta["lng"]))
+        distance_m = round(float(dist_m[k])) if dist_m is not None else None
         results.append({
             "place_id": m.venue_ids[vi],
             "places_fk_id": meta["fk_id"],
@@ -722,7 +1102,7 @@ def recommend_for_user(
             "latitude": meta["lat"],
             "longitude": meta["lng"],
             "distance_m": distance_m,
-            "score": round(score, 5),
+            "score": round(float(scores[k]), 5),
             "reasons": reasons,
             "friend_count": _friend_count(m, user_id, vi),
         })
@@ -778,18 +1158,118 @@ def _reasons(m: RecommendationModel, user_id: int, ui: Optional[int], vi: int,
 # ---------------------------------------------------------------- event log
 
 
+EVENT_FLUSH_BATCH = 500
+EVENT_FLUSH_INTERVAL_SECONDS = 2.0
+EVENT_FLUSH_TIMEOUT_SECONDS = 10.0
+EVENT_BUFFER_MAX = 20000           # past this new events are dropped, not queued
+
+# Weak signals arrive on every feed read and place view. Instead of a task,
+# a session and a commit per call, they go into a bounded per-worker buffer
+# that a flusher drains every EVENT_FLUSH_INTERVAL_SECONDS (or as soon as
+# EVENT_FLUSH_BATCH are waiting): identical events in a batch are coalesced,
+# written with one multi-row INSERT, then folded into the serving model and
+# fanned out to other workers as one message (record_interactions).
+# When the DB is slow the buffer fills up and further events are dropped and
+# counted — a lost view is cheaper than unbounded memory or a blocked request.
+_event_buffer: deque = deque()      # (user_id, place_id, event_type, ts)
+_event_wakeup: Optional[asyncio.Event] = None
+_event_flush_task: Optional[asyncio.Task] = None
+_event_stats = {"queued": 0, "written": 0, "coalesced": 0, "dropped": 0, "flush_errors": 0}
+
+
+def _event_weight(event_type: str) -> float:
+    return W_FEED_VIEW if event_type == "feed_view" else W_PLACE_VIEW
+
+
 def log_place_event(user_id: int, place_id: str, event_type: str):
-    """Fire-and-forget weak-signal logging (place_view, feed_view)."""
-    async def _log():
+    """Buffer a weak-signal event (place_view, feed_view). Never blocks or raises."""
+    if not place_id:
+        return
+    if len(_event_buffer) >= EVENT_BUFFER_MAX:
+        _event_stats["dropped"] += 1
+        return
+    _event_buffer.append((user_id, place_id, event_type, time.time()))
+    _event_stats["queued"] += 1
+    if len(_event_buffer) >= EVENT_FLUSH_BATCH and _event_wakeup is not None:
+        _event_wakeup.set()
+
+
+async def flush_events_once() -> int:
+    """Write one batch of buffered events. Returns how many were taken."""
+    n = min(len(_event_buffer), EVENT_FLUSH_BATCH)
+    if not n:
+        return 0
+    batch = [_event_buffer.popleft() for _ in range(n)]
+    # A feed read paginated three times in a second is one view
+    unique: dict[tuple, float] = {}
+    for uid, pid, etype, ts in batch:
+        unique.setdefault((uid, pid, etype), ts)
+    _event_stats["coalesced"] += n - len(unique)
+
+    try:
+        async with create_async_session() as session:
+            await asyncio.wait_for(session.execute(insert(UserPlaceEvent), [
+                {"user_id": uid, "place_id": pid, "event_type": etype,
+                 "created_at": datetime.fromtimestamp(ts, tz=timezone.utc)}
+                for (uid, pid, etype), ts in unique.items()
+            ]), timeout=EVENT_FLUSH_TIMEOUT_SECONDS)
+            await session.commit()
+    except BaseException:
+        # Includes cancellation by stop_event_flusher, whose drain picks it up
+        _event_stats["flush_errors"] += 1
+        # Requeue ahead of newer events while there is room; the rest is lost
+        room = max(0, EVENT_BUFFER_MAX - len(_event_buffer))
+        _event_stats["dropped"] += n - min(n, room)
+        _event_buffer.extendleft(reversed(batch[:room]))
+        raise
+    _event_stats["written"] += len(unique)
+    record_interactions([(uid, pid, _event_weight(etype), ts)
+                         for (uid, pid, etype), ts in unique.items()])
+    return n
+
+
+async def _event_flush_loop():
+    while True:
         try:
-            async with create_async_session() as session:
-                session.add(UserPlaceEvent(
-                    user_id=user_id, place_id=place_id, event_type=event_type
-                ))
-                await session.commit()
+            try:
+                await asyncio.wait_for(_event_wakeup.wait(), timeout=EVENT_FLUSH_INTERVAL_SECONDS)
+            except asyncio.TimeoutError:
+                pass
+            _event_wakeup.clear()
+            while await flush_events_once() >= EVENT_FLUSH_BATCH:
+                pass
+        except asyncio.CancelledError:
+            break
         except Exception as e:
-            logger.debug(f"place event log failed: {e}")
-    try:
-        asyncio.create_task(_log())
-    except RuntimeError:
-        pass
+            logger.warning(f"Place event flush failed: {e}")
+            await asyncio.sleep(EVENT_FLUSH_INTERVAL_SECONDS)
+
+
+async def start_event_flusher():
+    global _event_flush_task, _event_wakeup
+    if _event_flush_task is not None:
+        return
+    _event_wakeup = asyncio.Event()
+    _event_flush_task = asyncio.create_task(_event_flush_loop())
+
+
+async def stop_event_flusher():
+    """Cancel the loop, wait for it to exit (an in-flight batch is requeued),
+    then write whatever is still buffered."""
+    global _event_flush_task
+    if _event_flush_task is not None:
+        task, _event_flush_task = _event_flush_task, None
+        task.cancel()
+        try:
+            await task
+        except asyncio.CancelledError:
+            pass
+        try:
+            while _event_buffer:
+                await flush_events_once()
+        except Exception as e:
+            logger.warning(f"Final place event flush failed: {e}")
+
+
+def event_log_stats() -> dict:
+    return {**_event_stats, "buffered": len(_event_buffer)}
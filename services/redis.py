@@ -4,13 +4,17 @@ Two clients: the standard text client (JSON/strings) and a binary client
 (decode_responses=False) for raw image bytes. Both carry socket timeouts so a
 slow Redis degrades requests instead of hanging them, plus a shared circuit
 breaker so repeated failures short-circuit cache calls for a cooldown window.
+Commands and pipelines are counted per request by services.metrics.
 """
 
 import logging
 import time
 
 import redis.asyncio as redis
+from redis.asyncio.client import Pipeline
+
 from core.config import settings
+from services.metrics import record_redis
 
 logger = logging.getLogger(__name__)
 
@@ -42,8 +46,29 @@ def record_failure():
         logger.warning(f"Redis circuit breaker opened for {COOLDOWN_SECONDS}s")
 
 
+class _InstrumentedPipeline(Pipeline):
+    async def execute(self, raise_on_error: bool = True):
+        if self.command_stack:
+            record_redis("PIPELINE", len(self.command_stack))
+        return await super().execute(raise_on_error)
+
+    async def immediate_execute_command(self, *args, **options):
+        # WATCH and the reads between WATCH and MULTI
+        record_redis(str(args[0]).upper())
+        return await super().immediate_execute_command(*args, **options)
+
+
+class _InstrumentedRedis(redis.Redis):
+    async def execute_command(self, *args, **options):
+        record_redis(str(args[0]).upper())
+        return await super().execute_command(*args, **options)
+
+    def pipeline(self, transaction: bool = True, shard_hint=None) -> Pipeline:
+        return _InstrumentedPipeline(self.connection_pool, self.response_callbacks, transaction, shard_hint)
+
+
 def _make_client(decode_responses: bool) -> redis.Redis:
-    return redis.from_url(
+    return _InstrumentedRedis.from_url(
         settings.REDIS_URL,
         encoding="utf-8",
         decode_responses=decode_responses,
@@ -95,6 +120,20 @@ async def increment_badge_count(user_id: int) -> int:
     return count
 
 
+async def increment_badge_counts(user_ids: list) -> dict:
+    """increment_badge_count for a batch of users in one pipeline round trip"""
+    if not user_ids:
+        return {}
+    r = await get_redis()
+    pipe = r.pipeline(transaction=False)
+    for user_id in user_ids:
+        key = f"{BADGE_KEY_PREFIX}{user_id}"
+        pipe.incr(key)
+        pipe.expire(key, BADGE_TTL)
+    replies = await pipe.execute()
+    return {uid: int(count) for uid, count in zip(user_ids, replies[::2])}
+
+
 async def get_badge_count(user_id: int) -> int:
     """Get current badge count for a user"""
     r = await get_redis()
@@ -0,0 +1,120 @@
+"""Timing-wheel scheduler for location-sharing silent pushes.
+
+Users who share their location with at least one close friend get a
+content-available push every SILENT_PUSH_INTERVAL_SECONDS so the app wakes and
+reports a fix. Instead of re-querying every sharer and pushing them all at
+once each interval, the sharing set lives in Redis, partitioned into
+WHEEL_SLOTS slot sets by a stable hash of the user id:
+
+    silent_push:slot:<n>    user ids whose push falls in slot n
+
+Every TICK_SECONDS one worker (per-tick NX lock) takes the current slot,
+skips users with a fresh `user:alive:*` heartbeat (their app is already
+running), and sends the rest through APNsService.send_silent_push_bulk. Each
+user is pushed once per interval at a fixed offset, so load is spread evenly
+instead of spiking every 180s.
+
+Membership is maintained incrementally (refresh_sharer after any change to
+a user's outgoing is_sharing_location), and rebuilt from Postgres every
+REBUILD_SECONDS to heal drift from paths that bypass it (cascading deletes).
+"""
+
+import logging
+import time
+import zlib
+
+from sqlalchemy import select
+from sqlalchemy.ext.asyncio import AsyncSession
+
+from db.models import Follow
+from services.redis import get_redis
+
+logger = logging.getLogger(__name__)
+
+# APNs budgets content-available pushes to roughly a few per hour per device when the
+# app isn't in use — a 30s cadence just gets throttled while burning APNs traffic and
+# device battery. A few minutes is the fastest cadence that reliably delivers.
+SILENT_PUSH_INTERVAL_SECONDS = 180
+TICK_SECONDS = 10
+WHEEL_SLOTS = SILENT_PUSH_INTERVAL_SECONDS // TICK_SECONDS
+REBUILD_SECONDS = 30 * 60
+
+SLOT_KEY = "silent_push:slot:{slot}"
+TICK_LOCK_KEY = "locks:silent_push_tick:{tick}"
+REBUILD_LOCK_KEY = "locks:silent_push_rebuild"
+
+
+def slot_for(user_id: int) -> int:
+    return zlib.crc32(str(user_id).encode()) % WHEEL_SLOTS
+
+
+def _sharers_query():
+    return select(Follow.follower_id).where(
+        Follow.close_friend_status == 'accepted',
+        Follow.is_sharing_location == True
+    )
+
+
+async def refresh_sharer(db: AsyncSession, user_id: int) -> None:
+    """Re-derive whether user_id shares with anyone and update their slot set."""
+    try:
+        result = await db.execute(_sharers_query().where(Follow.follower_id == user_id).limit(1))
+        sharing = result.first() is not None
+        r = await get_redis()
+        key = SLOT_KEY.format(slot=slot_for(user_id))
+        if sharing:
+            await r.sadd(key, user_id)
+        else:
+            await r.srem(key, user_id)
+    except Exception as e:
+        # The periodic rebuild picks it up
+        logger.warning(f"Silent push membership refresh failed for user {user_id}: {e}")
+
+
+async def rebuild(db: AsyncSession) -> int:
+    """Replace every slot set from Postgres. Returns the sharer count."""
+    result = await db.execute(_sharers_query().distinct())
+    slots: dict[int, list] = {}
+    for (user_id,) in result.all():
+        slots.setdefault(slot_for(user_id), []).append(user_id)
+
+    r = await get_redis()
+    pipe = r.pipeline(transaction=True)
+    for slot in range(WHEEL_SLOTS):
+        key = SLOT_KEY.format(slot=slot)
+        pipe.delete(key)
+        if slots.get(slot):
+            pipe.sadd(key, *slots[slot])
+    await pipe.execute()
+    return sum(len(v) for v in slots.values())
+
+
+async def run_tick(session_maker) -> int:
+    """Push the current slot if this worker wins the tick. Returns pushes attempted."""
+    from services.apns_service import get_apns_service
+
+    now = time.time()
+    tick = int(now // TICK_SECONDS)
+    r = await get_redis()
+    if not await r.set(TICK_LOCK_KEY.format(tick=tick), "1", nx=True, ex=TICK_SECONDS * 3):
+        return 0
+
+    if await r.set(REBUILD_LOCK_KEY, "1", nx=True, ex=REBUILD_SECONDS):
+        async with session_maker() as db:
+            count = await rebuild(db)
+        logger.info(f"Silent push wheel rebuilt: {count} sharers")
+
+    members = [int(m) for m in await r.smembers(SLOT_KEY.format(slot=tick % WHEEL_SLOTS))]
+    if not members:
+        return 0
+    alive = await r.mget([f"user:alive:{uid}" for uid in members])
+    due = [uid for uid, flag in zip(members, alive) if not flag]
+    if not due:
+        return 0
+
+    apns = await get_apns_service()
+    async with session_maker() as db:
+        delivered = await apns.send_silent_push_bulk(db, due)
+    logger.debug(f"Silent push slot {tick % WHEEL_SLOTS}: {delivered}/{len(due)} delivered "
+                 f"({len(members) - len(due)} skipped, heartbeat fresh)")
+    return len(due)
@@ -35,53 +35,58 @@ def enqueue_notification(user_id: int, payload_dict: Dict[str, Any]) -> None:
         user_id: Target user ID
         payload_dict: Serialized NotificationPayload as dict
     """
-    # Send APNs notification directly in a background task
-    asyncio.create_task(_send_apns_direct(user_id, payload_dict))
-
-
-async def _send_apns_direct(user_id: int, payload_dict: Dict[str, Any]) -> None:
-    """Send APNs notification directly without queue"""
-    from services.apns_service import get_apns_service, NotificationPayload, NotificationType
+    enqueue_notifications_bulk([user_id], payload_dict)
+
+
+def _payload_from_dict(payload_dict: Dict[str, Any]):
+    from services.apns_service import NotificationPayload, NotificationType
+
+    return NotificationPayload(
+        notification_type=NotificationType(payload_dict['notification_type']),
+        title=payload_dict['title'],
+        body=payload_dict['body'],
+        actor_id=payload_dict['actor_id'],
+        actor_nickname=payload_dict['actor_nickname'],
+        actor_profile_picture=payload_dict.get('actor_profile_picture'),
+        bounce_id=payload_dict.get('bounce_id'),
+        bounce_venue_name=payload_dict.get('bounce_venue_name'),
+        bounce_place_id=payload_dict.get('bounce_place_id'),
+        venue_place_id=payload_dict.get('venue_place_id'),
+        venue_name=payload_dict.get('venue_name'),
+        venue_latitude=payload_dict.get('venue_latitude'),
+        venue_longitude=payload_dict.get('venue_longitude'),
+        conversation_id=payload_dict.get('conversation_id'),
+    )
+
+
+async def _send_apns_bulk(user_ids: list, payload_dict: Dict[str, Any]) -> None:
+    """Send one APNs notification to many users: one session, one batch"""
+    from services.apns_service import get_apns_service
     from db.database import get_session_maker
 
     try:
         session_maker = get_session_maker()
         async with session_maker() as db:
-            payload = NotificationPayload(
-                notification_type=NotificationType(payload_dict['notification_type']),
-                title=payload_dict['title'],
-                body=payload_dict['body'],
-                actor_id=payload_dict['actor_id'],
-                actor_nickname=payload_dict['actor_nickname'],
-                actor_profile_picture=payload_dict.get('actor_profile_picture'),
-                bounce_id=payload_dict.get('bounce_id'),
-                bounce_venue_name=payload_dict.get('bounce_venue_name'),
-                bounce_place_id=payload_dict.get('bounce_place_id'),
-                venue_place_id=payload_dict.get('venue_place_id'),
-                venue_name=payload_dict.get('venue_name'),
-                venue_latitude=payload_dict.get('venue_latitude'),
-                venue_longitude=payload_dict.get('venue_longitude'),
-                conversation_id=payload_dict.get('conversation_id'),
-            )
-
             apns = await get_apns_service()
-            result = await apns.send_notification(db, user_id, payload)
-            logger.info(f"APNs notification sent to user {user_id}: {result}")
+            results = await apns.send_bulk(db, user_ids, _payload_from_dict(payload_dict))
+            logger.debug(f"APNs batch sent: {sum(results.values())}/{len(user_ids)} user(s)")
 
     except Exception as e:
-        logger.error(f"Failed to send APNs notification to user {user_id}: {e}")
+        logger.error(f"Failed to send APNs notification to {len(user_ids)} user(s): {e}")
 
 
 def enqueue_notifications_bulk(user_ids: list, payload_dict: Dict[str, Any]) -> None:
     """
-    Enqueue notifications for multiple users.
+    Send the same push notification to multiple users as one background
+    batch: O(1) DB / Redis round trips regardless of recipient count.
 
     Args:
         user_ids: List of target user IDs
         payload_dict: Serialized NotificationPayload as dict
     """
-    for user_id in user_ids:
-        enqueue_notification(user_id, payload_dict)
+    if not user_ids:
+        return
+    asyncio.create_task(_send_apns_bulk(list(user_ids), payload_dict))
 
 
 def send_notification_task(user_id: int, payload_dict: Dict[str, Any]) -> bool:
@@ -95,30 +100,14 @@ def send_notification_task(user_id: int, payload_dict: Dict[str, Any]) -> bool:
 
 async def _send_notification_async(user_id: int, payload_dict: Dict[str, Any]) -> bool:
     """Async implementation of notification sending"""
-    from services.apns_service import get_apns_service, NotificationPayload, NotificationType
+    from services.apns_service import get_apns_service
     from db.database import get_session_maker
 
     try:
         # Create a new database session for this task
         session_maker = get_session_maker()
         async with session_maker() as db:
-            # Reconstruct the NotificationPayload from dict
-            payload = NotificationPayload(
-                notification_type=NotificationType(payload_dict['notification_type']),
-                title=payload_dict['title'],
-                body=payload_dict['body'],
-                actor_id=payload_dict['actor_id'],
-                actor_nickname=payload_dict['actor_nickname'],
-                actor_profile_picture=payload_dict.get('actor_profile_picture'),
-                bounce_id=payload_dict.get('bounce_id'),
-                bounce_venue_name=payload_dict.get('bounce_venue_name'),
-                bounce_place_id=payload_dict.get('bounce_place_id'),
-                venue_place_id=payload_dict.get('venue_place_id'),
-                venue_name=payload_dict.get('venue_name'),
-                venue_latitude=payload_dict.get('venue_latitude'),
-                venue_longitude=payload_dict.get('venue_longitude'),
-                conversation_id=payload_dict.get('conversation_id'),
-            )
+            payload = _payload_from_dict(payload_dict)
 
             apns = await get_apns_service()
             result = await apns.send_notification(db, user_id, payload)
@@ -0,0 +1,163 @@
+"""Hot first page + resumable deltas for venue feeds.
+
+Opening a venue feed ran a VenueFeedMessage ⋈ User query per open, and the
+busiest venues are opened by everyone arriving at once. Now:
+
+    venuefeed:ring:<place_id>   LIST, newest first: the latest RING_SIZE
+                                messages, pre-serialized FeedMessageResponse
+                                JSON (image / picture URLs, never data URIs)
+    venuefeed:gen:<place_id>    per-venue change counter = the resume cursor
+    venuefeed:log:<place_id>    ZSET gen -> "<gen>|<ws event json>", last LOG_SIZE
+
+Every post / delete bumps gen and logs its WS event under it; posts LPUSHX
+onto the ring (only an existing ring — a partial one would be wrong), deletes
+drop the ring so the next read refills it. Refills read Postgres and write
+the ring under WATCH gen, so a post that lands mid-refill aborts the refill
+instead of being lost. Moderation hides made directly in the DB age out with
+RING_TTL.
+
+A reconnecting socket passes its last cursor and gets the missed events from
+the log, or a "resync" frame when they have already been trimmed.
+
+Every function degrades: a None return means "Redis unavailable, use SQL".
+"""
+
+import json
+import logging
+from typing import Optional
+
+from redis.exceptions import WatchError
+
+from services.redis import circuit_is_open, get_redis
+
+logger = logging.getLogger(__name__)
+
+RING_KEY = "venuefeed:ring:{place_id}"
+GEN_KEY = "venuefeed:gen:{place_id}"
+LOG_KEY = "venuefeed:log:{place_id}"
+
+RING_SIZE = 101          # max page (100) + 1, so has_more is exact
+RING_TTL = 3600
+GEN_TTL = 7 * 24 * 3600
+LOG_SIZE = 200
+
+
+async def read_page(place_id: str, limit: int) -> tuple[Optional[list[str]], Optional[str]]:
+    """(up to limit + 1 serialized messages, gen) from the ring; messages is
+    None when there is no ring and the caller must refill it."""
+    if circuit_is_open():
+        return None, None
+    try:
+        r = await get_redis()
+        pipe = r.pipeline(transaction=False)
+        pipe.lrange(RING_KEY.format(place_id=place_id), 0, limit)
+        pipe.exists(RING_KEY.format(place_id=place_id))
+        pipe.get(GEN_KEY.format(place_id=place_id))
+        entries, exists, gen = await pipe.execute()
+        return (entries if exists else None), gen
+    except Exception as e:
+        logger.warning(f"Venue feed ring read failed for {place_id}: {e}")
+        return None, None
+
+
+async def fill(place_id: str, entries: list[str], expected_gen: Optional[str]) -> None:
+    """Replace the ring with `entries` (newest first) unless the feed changed
+    since `expected_gen` was read."""
+    if not entries or circuit_is_open():
+        return
+    gen_key = GEN_KEY.format(place_id=place_id)
+    ring_key = RING_KEY.format(place_id=place_id)
+    try:
+        r = await get_redis()
+        async with r.pipeline(transaction=True) as pipe:
+            await pipe.watch(gen_key)
+            if await pipe.get(gen_key) != expected_gen:
+                await pipe.reset()
+                return
+            pipe.multi()
+            pipe.delete(ring_key)
+            pipe.rpush(ring_key, *entries[:RING_SIZE])
+            pipe.expire(ring_key, RING_TTL)
+            await pipe.execute()
+    except WatchError:
+        pass
+    except Exception as e:
+        logger.warning(f"Venue feed ring fill failed for {place_id}: {e}")
+
+
+async def _record(place_id: str, event: dict, entry: Optional[str]) -> Optional[int]:
+    if circuit_is_open():
+        return None
+    ring_key = RING_KEY.format(place_id=place_id)
+    gen_key = GEN_KEY.format(place_id=place_id)
+    log_key = LOG_KEY.format(place_id=place_id)
+    try:
+        r = await get_redis()
+        pipe = r.pipeline(transaction=True)
+        pipe.incr(gen_key)
+        pipe.expire(gen_key, GEN_TTL)
+        if entry is not None:
+            pipe.lpushx(ring_key, entry)
+            pipe.ltrim(ring_key, 0, RING_SIZE - 1)
+        else:
+            pipe.delete(ring_key)
+        gen = (await pipe.execute())[0]
+
+        pipe = r.pipeline(transaction=False)
+        pipe.zadd(log_key, {f"{gen}|{json.dumps(event)}": gen})
+        pipe.zremrangebyrank(log_key, 0, -(LOG_SIZE + 1))
+        pipe.expire(log_key, RING_TTL)
+        await pipe.execute()
+        return gen
+    except Exception as e:
+        logger.warning(f"Venue feed ring update failed for {place_id}: {e}")
+        return None
+
+
+async def record_message(place_id: str, entry: dict, event: dict) -> Optional[int]:
+    """New message: push `entry` onto the ring, log `event`. Returns its cursor."""
+    return await _record(place_id, event, json.dumps(entry))
+
+
+async def record_removal(place_id: str, event: dict) -> Optional[int]:
+    """Deleted / hidden message: drop the ring, log `event`. Returns its cursor."""
+    return await _record(place_id, event, None)
+
+
+async def current_cursor(place_id: str) -> Optional[int]:
+    if circuit_is_open():
+        return None
+    try:
+        r = await get_redis()
+        return int(await r.get(GEN_KEY.format(place_id=place_id)) or 0)
+    except Exception as e:
+        logger.warning(f"Venue feed cursor read failed for {place_id}: {e}")
+        return None
+
+
+async def events_since(place_id: str, cursor: int) -> tuple[Optional[list[dict]], Optional[int]]:
+    """(events after cursor each carrying its "cursor", current gen); events
+    is None when the log no longer reaches back to cursor."""
+    if circuit_is_open():
+        return None, None
+    try:
+        r = await get_redis()
+        log_key = LOG_KEY.format(place_id=place_id)
+        pipe = r.pipeline(transaction=False)
+        pipe.get(GEN_KEY.format(place_id=place_id))
+        pipe.zrange(log_key, 0, 0, withscores=True)
+        pipe.zrangebyscore(log_key, f"({cursor}", "+inf")
+        gen, oldest, members = await pipe.execute()
+        gen = int(gen or 0)
+        if cursor == gen:
+            return [], gen
+        if cursor > gen or not oldest or int(oldest[0][1]) > cursor + 1:
+            return None, gen
+        events = []
+        for member in members:
+            seq, _, payload = member.partition("|")
+            events.append({**json.loads(payload), "cursor": int(seq)})
+        return events, gen
+    except Exception as e:
+        logger.warning(f"Venue feed resume failed for {place_id}: {e}")
+        return None, None
@@ -0,0 +1,142 @@
+"""WebSocket fan-out engine: serialize once, write concurrently, never block
+on a slow client.
+
+Every accepted socket gets an Outbox — a bounded queue drained by its own
+writer task. Fan-out serializes the payload once and `offer`s the same text
+to each target's outbox without awaiting, so one stalled phone on hotel
+Wi-Fi can't delay the rest of the room. When an outbox is full the message
+is dropped for that client; after SLOW_DROP_LIMIT consecutive drops (or a
+send stuck longer than SEND_TIMEOUT_SECONDS) the socket is closed with 1013
+"try again later" and the client reconnects into a fresh state.
+
+FanoutStats keeps per-channel-kind counters and enqueue->written latency
+samples so peak-night fan-out cost is visible (see ConnectionManager.stats).
+"""
+
+import asyncio
+import logging
+import time
+from collections import deque
+from typing import Callable
+
+from fastapi import WebSocket
+
+logger = logging.getLogger(__name__)
+
+SEND_QUEUE_MAX = 64
+SLOW_DROP_LIMIT = 16
+SEND_TIMEOUT_SECONDS = 10.0
+LATENCY_SAMPLES = 512
+
+
+class ChannelStats:
+    __slots__ = ("fanouts", "recipients", "delivered", "dropped",
+                 "slow_disconnects", "max_ms", "_samples")
+
+    def __init__(self):
+        self.fanouts = 0
+        self.recipients = 0
+        self.delivered = 0
+        self.dropped = 0
+        self.slow_disconnects = 0
+        self.max_ms = 0.0
+        self._samples: deque = deque(maxlen=LATENCY_SAMPLES)
+
+    def observe(self, ms: float):
+        self.delivered += 1
+        self._samples.append(ms)
+        if ms > self.max_ms:
+            self.max_ms = ms
+
+    def snapshot(self) -> dict:
+        samples = sorted(self._samples)
+
+        def pct(q: float):
+            return round(samples[min(len(samples) - 1, int(q * len(samples)))], 2) if samples else None
+
+        return {
+            "fanouts": self.fanouts,
+            "recipients": self.recipients,
+            "delivered": self.delivered,
+            "dropped": self.dropped,
+            "slow_disconnects": self.slow_disconnects,
+            "latency_ms_p50": pct(0.50),
+            "latency_ms_p99": pct(0.99),
+            "latency_ms_max": round(self.max_ms, 2),
+        }
+
+
+class FanoutStats:
+    def __init__(self):
+        self.channels: dict[str, ChannelStats] = {}
+
+    def channel(self, kind: str) -> ChannelStats:
+        stats = self.channels.get(kind)
+        if stats is None:
+            stats = self.channels[kind] = ChannelStats()
+        return stats
+
+    def snapshot(self) -> dict:
+        return {kind: s.snapshot() for kind, s in self.channels.items()}
+
+
+class Outbox:
+    """Bounded per-connection send queue with its own writer task."""
+
+    def __init__(self, websocket: WebSocket, on_dead: Callable[[], None],
+                 stats: FanoutStats, maxsize: int = SEND_QUEUE_MAX):
+        self.websocket = websocket
+        self._on_dead = on_dead
+        self._stats = stats
+        self._queue: asyncio.Queue = asyncio.Queue(maxsize=maxsize)
+        self._consecutive_drops = 0
+        self._closed = False
+        self._task = asyncio.create_task(self._run())
+
+    def offer(self, text: str, kind: str, enqueued_at: float) -> bool:
+        """Queue without awaiting. False if dropped (queue full or closed)."""
+        if self._closed:
+            return False
+        try:
+            self._queue.put_nowait((text, kind, enqueued_at))
+            return True
+        except asyncio.QueueFull:
+            self._consecutive_drops += 1
+            self._stats.channel(kind).dropped += 1
+            if self._consecutive_drops >= SLOW_DROP_LIMIT:
+                self._stats.channel(kind).slow_disconnects += 1
+                self._kill("slow consumer")
+            return False
+
+    async def _run(self):
+        try:
+            while True:
+                text, kind, enqueued_at = await self._queue.get()
+                await asyncio.wait_for(self.websocket.send_text(text), SEND_TIMEOUT_SECONDS)
+                self._consecutive_drops = 0
+                self._stats.channel(kind).observe((time.perf_counter() - enqueued_at) * 1000)
+        except asyncio.CancelledError:
+            pass
+        except asyncio.TimeoutError:
+            self._kill("send timeout")
+        except Exception:
+            self._kill(None)
+
+    def _kill(self, reason):
+        if self._closed:
+            return
+        self.close()
+        if reason:
+            logger.info(f"Closing WebSocket: {reason}")
+            asyncio.create_task(self._close_socket())
+        self._on_dead()
+
+    async def _close_socket(self):
+        try:
+            await self.websocket.close(code=1013, reason="Try again later")
+        except Exception:
+            pass
+
+    def close(self):
+        self._closed = True
+        self._task.cancel()
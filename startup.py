@@ -3,12 +3,16 @@ Startup script for Railway deployment
 Handles:
 - Apple Sign-In private key decoding from base64 env var
 - Directory creation
+- Model builder process, supervised (MODEL_BUILDER_MODE=process)
 - Uvicorn server launch
 """
 
 import base64
 import os
+import subprocess
 import sys
+import threading
+import time
 from pathlib import Path
 
 
@@ -54,6 +58,54 @@ def setup_apple_private_key():
         return False
 
 
+BUILDER_RESTART_MIN_SECONDS = 1
+BUILDER_RESTART_MAX_SECONDS = 60
+BUILDER_HEALTHY_SECONDS = 300   # ran this long: reset the backoff
+
+
+def start_model_builder():
+    """
+    Spawn the recsys/matching builder next to uvicorn so workers only map
+    its snapshots (services/model_builder.py), and restart it with backoff
+    whenever it exits. Returns a stop callable, or None in inline mode.
+    """
+    if os.getenv("MODEL_BUILDER_MODE", "process") != "process":
+        print("✓ Model builder: inline mode, not spawned")
+        return None
+
+    stopping = threading.Event()
+    current = {"proc": None}
+
+    def supervise():
+        backoff = BUILDER_RESTART_MIN_SECONDS
+        while not stopping.is_set():
+            started = time.monotonic()
+            try:
+                proc = current["proc"] = subprocess.Popen([sys.executable, "-m", "services.model_builder"])
+                print(f"✓ Model builder started (pid {proc.pid})")
+                status = f"exit code {proc.wait()}"
+            except Exception as e:
+                status = f"failed to start: {e}"
+            if stopping.is_set():
+                return
+            if time.monotonic() - started > BUILDER_HEALTHY_SECONDS:
+                backoff = BUILDER_RESTART_MIN_SECONDS
+            print(f"❌ Model builder {status} — restarting in {backoff}s "
+                  f"(workers wait for or fit a snapshot meanwhile)", file=sys.stderr, flush=True)
+            stopping.wait(backoff)
+            backoff = min(backoff * 2, BUILDER_RESTART_MAX_SECONDS)
+
+    threading.Thread(target=supervise, name="model-builder-supervisor", daemon=True).start()
+
+    def stop():
+        stopping.set()
+        proc = current["proc"]
+        if proc is not None and proc.poll() is None:
+            proc.terminate()
+
+    return stop
+
+
 def main():
     """Main startup sequence"""
     print("=" * 60)
@@ -61,15 +113,19 @@ def main():
     print("=" * 60)
 
     # Step 1: Create directories
-    print("\n[1/3] Setting up directories...")
+    print("\n[1/4] Setting up directories...")
     setup_directories()
 
     # Step 2: Decode Apple private key
-    print("\n[2/3] Setting up Apple Sign-In private key...")
+    print("\n[2/4] Setting up Apple Sign-In private key...")
     setup_apple_private_key()
 
-    # Step 3: Launch uvicorn
-    print("\n[3/3] Starting uvicorn server...")
+    # Step 3: Model builder
+    print("\n[3/4] Starting model builder...")
+    stop_builder = start_model_builder()
+
+    # Step 4: Launch uvicorn
+    print("\n[4/4] Starting uvicorn server...")
     print("=" * 60)
 
     # Get port from environment (Railway provides this)
@@ -85,6 +141,9 @@ def main():
     except KeyboardInterrupt:
         print("\n⏹️  Shutting down...")
         sys.exit(0)
+    finally:
+        if stop_builder is not None:
+            stop_builder()
 
 
 if __name__ == "__main__":